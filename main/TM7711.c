@@ -1,7 +1,79 @@
 #include "TM7711.h"
+#include <string.h>
 #include "esp_system.h"
 #include "esp_err.h"
+#include "esp_log.h"
 #include "rom/ets_sys.h"
+#include "soc/soc_caps.h"
+
+#if SOC_GPSPI_SUPPORTED
+#include "freertos/semphr.h"
+#include "driver/spi_master.h"
+#endif
+
+/**
+ * @brief Tag for logging messages from the TM7711 driver.
+ */
+static const char *TAG = "TM7711";
+
+/**
+ * @brief State of a TM7711 read from its DOUT interrupt.
+ */
+typedef struct {
+    bool attached;                      ///< Channel is in use.
+    int dout_pin;                       ///< GPIO of DOUT.
+    int sck_pin;                        ///< GPIO of PD_SCK.
+    Tm7711Readout readout;              ///< How the clock train is generated.
+    int bits;                           ///< PD_SCK pulses per readout, selecting the next conversion.
+    unsigned char skip;                 ///< Conversions still to discard after the reset.
+    uint32_t ring[TM7711_RING_SIZE];    ///< Queued samples.
+    uint32_t head;                      ///< Number of samples queued; the slot is head % TM7711_RING_SIZE.
+    uint32_t tail;                      ///< Number of samples taken.
+    uint32_t dropped;                   ///< Samples overwritten before they were taken.
+#if SOC_GPSPI_SUPPORTED
+    int spi_slot;                       ///< Index into spi_hosts, or -1.
+    spi_device_handle_t device;         ///< SPI device clocking the chip.
+    spi_transaction_t trans;            ///< Transfer of the current readout.
+    bool busy;                          ///< A readout was requested and has not completed yet.
+#endif
+} Tm7711Channel;
+
+/**
+ * @brief Channels of the attached chips.
+ */
+static Tm7711Channel channels[TM7711_MAX_CHANNELS];
+
+/**
+ * @brief Lock held while a sample is clocked out and while the rings are accessed.
+ */
+static portMUX_TYPE tm7711_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Task notified when a sample is queued.
+ */
+static TaskHandle_t listener = NULL;
+
+#if SOC_GPSPI_SUPPORTED
+/**
+ * @brief SPI hosts the SPI readout may claim, one per chip.
+ */
+static const spi_host_device_t spi_hosts[TM7711_SPI_HOST_COUNT] = { SPI2_HOST, SPI3_HOST };
+
+/**
+ * @brief Channel using each SPI host, or NULL.
+ */
+static Tm7711Channel *spi_owners[TM7711_SPI_HOST_COUNT];
+
+/**
+ * @brief Task starting and completing the SPI readouts.
+ */
+static TaskHandle_t spi_task = NULL;
+
+/**
+ * @brief Held by the SPI task while it uses the SPI devices, and while a device is removed.
+ */
+static SemaphoreHandle_t spi_mutex = NULL;
+#endif
 
 esp_err_t tm7711_init(int dout_pin, int sck_pin) {
     esp_err_t ret = ESP_OK;
@@ -20,70 +92,395 @@ esp_err_t tm7711_init(int dout_pin, int sck_pin) {
     return ret;
 }
 
-esp_err_t tm7711_read(unsigned char next_select, int dout_pin, int sck_pin, unsigned long *data) {
-    unsigned char i;
-    unsigned long data_temp = 0;
-    unsigned char pulses;
-    int timeout;
-    int retries = 3; // Maximum 3 attempts
-
-    // Determine additional clock pulses and timeout based on mode
-    switch (next_select) {
-        case CH1_10HZ:
-            timeout = 120000; // 120ms for 10Hz
-            pulses = CH1_10HZ_CLK - 24;  // 1 pulse
-            break;
-        case CH1_40HZ:
-            timeout = 30000;  // 30ms for 40Hz
-            pulses = CH1_40HZ_CLK - 24;  // 3 pulses
-            break;
-        case CH2_TEMP:
-            timeout = 60000;  // 60ms for temperature
-            pulses = CH2_TEMP_CLK - 24;  // 2 pulses
-            break;
-        default:
-            return ESP_ERR_INVALID_ARG;
-    }
-
-    if (data == NULL) {
-        return ESP_ERR_INVALID_ARG;
+/**
+ * @brief Queues a sample read from a chip. Called with tm7711_lock held.
+ * @param ch Pointer to the channel.
+ * @param data Raw 24-bit sample.
+ * @return bool True if the sample was queued, false if it was discarded.
+ */
+static bool IRAM_ATTR queue_sample(Tm7711Channel *ch, uint32_t data) {
+    // The conversion after the reset ran in the default mode
+    if (ch->skip) {
+        ch->skip--;
+        return false;
     }
 
-    while (retries--) {
-        // Wait for DOUT to go low (data ready)
-        int temp_timeout = timeout;
-        while (gpio_get_level(dout_pin) && temp_timeout--) {
-            ets_delay_us(1);
-        }
-        if (temp_timeout <= 0) {
-            if (retries == 0) {
-                return ESP_ERR_TIMEOUT;
+    // A full ring drops its oldest sample; the newest ones matter most
+    ch->ring[ch->head & (TM7711_RING_SIZE - 1)] = data;
+    ch->head++;
+    if (ch->head - ch->tail > TM7711_RING_SIZE) {
+        ch->tail = ch->head - TM7711_RING_SIZE;
+        ch->dropped++;
+    }
+    return true;
+}
+
+/**
+ * @brief Bit-bangs a readout if the chip has a sample ready and queues it. Called with tm7711_lock held.
+ * @param ch Pointer to the channel.
+ * @return bool True if a sample was queued.
+ */
+static bool IRAM_ATTR read_sample(Tm7711Channel *ch) {
+    // DOUT is high until a conversion is ready; the edges of the readout itself land here too
+    if (gpio_get_level(ch->dout_pin)) {
+        return false;
+    }
+
+    // Read 24 bits, MSB first
+    uint32_t data = 0;
+    for (int i = 0; i < TM7711_DATA_BITS; i++) {
+        gpio_set_level(ch->sck_pin, 1);
+        ets_delay_us(TM7711_SCK_HALF_PERIOD_US);
+        data = (data << 1) | (gpio_get_level(ch->dout_pin) ? 1 : 0);
+        gpio_set_level(ch->sck_pin, 0);
+        ets_delay_us(TM7711_SCK_HALF_PERIOD_US);
+    }
+
+    // Send additional clock pulses for next mode
+    for (int i = TM7711_DATA_BITS; i < ch->bits; i++) {
+        gpio_set_level(ch->sck_pin, 1);
+        ets_delay_us(TM7711_SCK_HALF_PERIOD_US);
+        gpio_set_level(ch->sck_pin, 0);
+        ets_delay_us(TM7711_SCK_HALF_PERIOD_US);
+    }
+
+    return queue_sample(ch, data);
+}
+
+/**
+ * @brief Clocks out a conversion on the falling edge of DOUT.
+ * @param arg Pointer to the channel.
+ */
+static void IRAM_ATTR dout_falling_isr(void *arg) {
+    Tm7711Channel *ch = arg;
+
+    // PD_SCK must not be held high by a preemption, so the whole readout runs in the critical section
+    portENTER_CRITICAL_ISR(&tm7711_lock);
+    bool queued = ch->attached && read_sample(ch);
+    TaskHandle_t task = listener;
+    portEXIT_CRITICAL_ISR(&tm7711_lock);
+
+    if (queued && task) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+#if SOC_GPSPI_SUPPORTED
+/**
+ * @brief Marks a chip busy if it has a sample ready and no readout is pending. Called with tm7711_lock held.
+ * @param ch Pointer to the channel.
+ * @return bool True if the SPI task has to start a readout.
+ */
+static bool IRAM_ATTR claim_spi_readout(Tm7711Channel *ch) {
+    // The transfer's own DOUT edges land here too, while the channel is busy
+    if (!ch->attached || ch->busy || gpio_get_level(ch->dout_pin)) {
+        return false;
+    }
+    ch->busy = true;
+    return true;
+}
+
+/**
+ * @brief Hands a ready conversion to the SPI task on the falling edge of DOUT.
+ * @param arg Pointer to the channel.
+ */
+static void IRAM_ATTR dout_falling_spi_isr(void *arg) {
+    Tm7711Channel *ch = arg;
+
+    portENTER_CRITICAL_ISR(&tm7711_lock);
+    bool start = claim_spi_readout(ch);
+    portEXIT_CRITICAL_ISR(&tm7711_lock);
+
+    if (start) {
+        BaseType_t woken = pdFALSE;
+        xTaskNotifyFromISR(spi_task, 1u << (ch - channels), eSetBits, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+/**
+ * @brief Task running the SPI readouts requested by the DOUT interrupts.
+ * @param pvParameters Task parameters (unused).
+ */
+static void tm7711_spi_task(void *pvParameters) {
+    while (1) {
+        uint32_t pending = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &pending, portMAX_DELAY);
+        xSemaphoreTake(spi_mutex, portMAX_DELAY);
+
+        // Start every ready chip first, so the transfers on the different hosts overlap
+        uint32_t started = 0;
+        for (int i = 0; i < TM7711_MAX_CHANNELS; i++) {
+            Tm7711Channel *ch = &channels[i];
+            if (!(pending & (1u << i)) || !ch->attached || ch->readout != TM7711_READOUT_SPI) continue;
+            memset(&ch->trans, 0, sizeof(ch->trans));
+            ch->trans.flags = SPI_TRANS_USE_RXDATA;
+            ch->trans.length = ch->bits;
+            if (spi_device_queue_trans(ch->device, &ch->trans, 0) == ESP_OK) {
+                started |= 1u << i;
+            } else {
+                ch->busy = false;
             }
-            continue; // Retry
         }
 
-        // Read 24 bits
-        for (i = 0; i < 24; i++) {
-            gpio_set_level(sck_pin, 1);  // SCK high
-            ets_delay_us(5);             // Wait 5us
-            data_temp <<= 1;             // Shift data left
-            if (gpio_get_level(dout_pin)) {
-                data_temp |= 1;          // Read bit from DOUT
+        // Collect the samples; the CPU is free while the hosts clock
+        for (int i = 0; i < TM7711_MAX_CHANNELS; i++) {
+            if (!(started & (1u << i))) continue;
+            Tm7711Channel *ch = &channels[i];
+            spi_transaction_t *done = NULL;
+            bool received = spi_device_get_trans_result(ch->device, &done, portMAX_DELAY) == ESP_OK;
+
+            portENTER_CRITICAL(&tm7711_lock);
+            bool queued = received && queue_sample(ch, tm7711_frame_decode(done->rx_data));
+            ch->busy = false;
+            TaskHandle_t task = listener;
+            portEXIT_CRITICAL(&tm7711_lock);
+            if (queued && task) {
+                xTaskNotifyGive(task);
             }
-            gpio_set_level(sck_pin, 0);  // SCK low
-            ets_delay_us(5);             // Wait 5us
         }
+        xSemaphoreGive(spi_mutex);
+    }
+}
+
+/**
+ * @brief Claims an SPI host for a chip, with PD_SCK on SCLK and DOUT on MISO.
+ * @param ch Pointer to the channel, with its pins set.
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG if TM7711_SPI_CLOCK_HZ is out of spec,
+ *         ESP_ERR_NO_MEM if no host is left, or the driver error.
+ */
+static esp_err_t attach_spi(Tm7711Channel *ch) {
+    if (!tm7711_clock_valid(TM7711_SPI_CLOCK_HZ)) {
+        // A PD_SCK phase outside the datasheet limits corrupts samples or powers the chip down
+        ESP_LOGE(TAG, "SPI clock of %d Hz violates the TM7711 timing", TM7711_SPI_CLOCK_HZ);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!spi_mutex) {
+        spi_mutex = xSemaphoreCreateMutex();
+        if (!spi_mutex) return ESP_ERR_NO_MEM;
+    }
+    if (!spi_task && xTaskCreate(tm7711_spi_task, "tm7711_spi_task", 2048, NULL, 6, &spi_task) != pdPASS) {
+        spi_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    int slot = -1;
+    for (int i = 0; i < TM7711_SPI_HOST_COUNT && slot < 0; i++) {
+        if (!spi_owners[i]) slot = i;
+    }
+    if (slot < 0) {
+        ESP_LOGE(TAG, "No SPI host left for DOUT GPIO %d", ch->dout_pin);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // A readout is at most 27 bits, received in the transaction itself, so no DMA is needed
+    spi_bus_config_t bus_config = {
+        .mosi_io_num = -1,
+        .miso_io_num = ch->dout_pin,
+        .sclk_io_num = ch->sck_pin,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = 4,
+        // The GPIO matrix keeps DOUT readable for the data-ready interrupt
+        .flags = SPICOMMON_BUSFLAG_MASTER | SPICOMMON_BUSFLAG_GPIO_PINS,
+    };
+    esp_err_t err = spi_bus_initialize(spi_hosts[slot], &bus_config, SPI_DMA_DISABLED);
+    if (err != ESP_OK) return err;
+
+    // Mode 1: PD_SCK idles low and DOUT is sampled on the falling edge, after it settled
+    spi_device_interface_config_t dev_config = {
+        .mode = 1,
+        .clock_speed_hz = TM7711_SPI_CLOCK_HZ,
+        .spics_io_num = -1,
+        .queue_size = 1,
+    };
+    err = spi_bus_add_device(spi_hosts[slot], &dev_config, &ch->device);
+    if (err != ESP_OK) {
+        spi_bus_free(spi_hosts[slot]);
+        return err;
+    }
+    ch->spi_slot = slot;
+    spi_owners[slot] = ch;
+    return ESP_OK;
+}
+
+/**
+ * @brief Releases the SPI host of a chip once the SPI task is done with it.
+ * @param ch Pointer to the detached channel.
+ */
+static void detach_spi(Tm7711Channel *ch) {
+    if (ch->spi_slot < 0) {
+        return;
+    }
+    xSemaphoreTake(spi_mutex, portMAX_DELAY);
+    spi_bus_remove_device(ch->device);
+    spi_bus_free(spi_hosts[ch->spi_slot]);
+    spi_owners[ch->spi_slot] = NULL;
+    ch->spi_slot = -1;
+    ch->device = NULL;
+    xSemaphoreGive(spi_mutex);
+}
+#endif
+
+/**
+ * @brief Finds the channel attached to a DOUT pin.
+ * @param dout_pin GPIO pin for data output.
+ * @return Tm7711Channel* Pointer to the channel, or NULL if the pin is not attached.
+ */
+static Tm7711Channel *find_channel(int dout_pin) {
+    for (int i = 0; i < TM7711_MAX_CHANNELS; i++) {
+        if (channels[i].attached && channels[i].dout_pin == dout_pin) {
+            return &channels[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t tm7711_attach(int dout_pin, int sck_pin, unsigned char next_select, Tm7711Readout readout) {
+    int bits = tm7711_frame_bits(next_select);
+    if (bits == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if !SOC_GPSPI_SUPPORTED
+    if (readout == TM7711_READOUT_SPI) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+#endif
+
+    tm7711_detach(dout_pin);
+    Tm7711Channel *ch = NULL;
+    for (int i = 0; i < TM7711_MAX_CHANNELS && !ch; i++) {
+        if (!channels[i].attached) ch = &channels[i];
+    }
+    if (!ch) {
+        ESP_LOGE(TAG, "No channel left for DOUT GPIO %d", dout_pin);
+        return ESP_ERR_NO_MEM;
+    }
 
-        // Send additional clock pulses for next mode
-        for (i = 0; i < pulses; i++) {
-            gpio_set_level(sck_pin, 1);
-            ets_delay_us(1);
-            gpio_set_level(sck_pin, 0);
-            ets_delay_us(1);
+    esp_err_t ret = tm7711_init(dout_pin, sck_pin);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) { // Already installed is fine
+        ESP_LOGE(TAG, "Failed to install GPIO ISR service: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    portENTER_CRITICAL(&tm7711_lock);
+    memset(ch, 0, sizeof(*ch));
+    ch->dout_pin = dout_pin;
+    ch->sck_pin = sck_pin;
+    ch->readout = readout;
+    ch->bits = bits;
+    ch->skip = 1;
+#if SOC_GPSPI_SUPPORTED
+    ch->spi_slot = -1;
+#endif
+    portEXIT_CRITICAL(&tm7711_lock);
+
+    gpio_isr_t isr = dout_falling_isr;
+#if SOC_GPSPI_SUPPORTED
+    if (readout == TM7711_READOUT_SPI) {
+        ret = attach_spi(ch);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set up SPI readout on DOUT GPIO %d: %s", dout_pin, esp_err_to_name(ret));
+            return ret;
         }
+        isr = dout_falling_spi_isr;
+    }
+#endif
+
+    portENTER_CRITICAL(&tm7711_lock);
+    ch->attached = true;
+    portEXIT_CRITICAL(&tm7711_lock);
 
-        *data = data_temp;
-        return ESP_OK;
+    ret = gpio_set_intr_type(dout_pin, GPIO_INTR_NEGEDGE);
+    if (ret == ESP_OK) {
+        ret = gpio_isr_handler_add(dout_pin, isr, ch);
     }
-    return ESP_ERR_TIMEOUT;
-}
\ No newline at end of file
+    if (ret == ESP_OK) {
+        ret = gpio_intr_enable(dout_pin);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to attach interrupt to DOUT GPIO %d: %s", dout_pin, esp_err_to_name(ret));
+        tm7711_detach(dout_pin);
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Reading TM7711 on DOUT GPIO %d, PD_SCK GPIO %d by %s", dout_pin, sck_pin,
+             readout == TM7711_READOUT_SPI ? "SPI" : "GPIO");
+    return ESP_OK;
+}
+
+void tm7711_detach(int dout_pin) {
+    Tm7711Channel *ch = find_channel(dout_pin);
+    if (!ch) {
+        return;
+    }
+    gpio_isr_handler_remove(dout_pin);
+    gpio_set_intr_type(dout_pin, GPIO_INTR_DISABLE);
+
+    portENTER_CRITICAL(&tm7711_lock);
+    ch->attached = false;
+    portEXIT_CRITICAL(&tm7711_lock);
+#if SOC_GPSPI_SUPPORTED
+    detach_spi(ch);
+#endif
+}
+
+void tm7711_detach_all(void) {
+    for (int i = 0; i < TM7711_MAX_CHANNELS; i++) {
+        if (channels[i].attached) {
+            tm7711_detach(channels[i].dout_pin);
+        }
+    }
+}
+
+size_t tm7711_take(int dout_pin, uint32_t *samples, size_t max) {
+    Tm7711Channel *ch = find_channel(dout_pin);
+    if (!ch || !samples) {
+        return 0;
+    }
+
+    size_t count = 0;
+    uint32_t dropped;
+#if SOC_GPSPI_SUPPORTED
+    bool start_spi = false;
+#endif
+    portENTER_CRITICAL(&tm7711_lock);
+    if (ch->head == ch->tail) {
+        // Catch a conversion whose edge was missed, or the chip would wait for its readout forever
+#if SOC_GPSPI_SUPPORTED
+        if (ch->readout == TM7711_READOUT_SPI) {
+            start_spi = claim_spi_readout(ch);
+        } else
+#endif
+        read_sample(ch);
+    }
+    while (ch->tail != ch->head && count < max) {
+        samples[count++] = ch->ring[ch->tail & (TM7711_RING_SIZE - 1)];
+        ch->tail++;
+    }
+    dropped = ch->dropped;
+    ch->dropped = 0;
+    portEXIT_CRITICAL(&tm7711_lock);
+
+#if SOC_GPSPI_SUPPORTED
+    if (start_spi) {
+        xTaskNotify(spi_task, 1u << (ch - channels), eSetBits);
+    }
+#endif
+    if (dropped) {
+        // Log warning; the reader is slower than the chip
+        ESP_LOGW(TAG, "Dropped %lu samples on DOUT GPIO %d", (unsigned long)dropped, dout_pin);
+    }
+    return count;
+}
+
+void tm7711_set_listener(TaskHandle_t task) {
+    portENTER_CRITICAL(&tm7711_lock);
+    listener = task;
+    portEXIT_CRITICAL(&tm7711_lock);
+}
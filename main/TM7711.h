@@ -1,37 +1,42 @@
 #ifndef _TM7711_H_
 #define _TM7711_H_
 
+#include <stddef.h>
+#include <stdint.h>
 #include <driver/gpio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "tm7711_frame.h"
 
 /**
- * @brief Mode for Channel 1 with 10 Hz sampling rate.
+ * @brief Maximum number of TM7711 chips read at the same time.
  */
-#define CH1_10HZ    0x01
+#define TM7711_MAX_CHANNELS 10
 
 /**
- * @brief Mode for Channel 1 with 40 Hz sampling rate.
+ * @brief Samples buffered per chip; must be a power of two. The oldest sample is dropped when full.
  */
-#define CH1_40HZ    0x02
+#define TM7711_RING_SIZE 16
 
 /**
- * @brief Mode for Channel 2, temperature measurement.
+ * @brief Half period of PD_SCK while clocking out a sample, in microseconds.
+ *
+ * PD_SCK must not stay high for 60 us or longer, or the chip powers down.
  */
-#define CH2_TEMP    0x03
+#define TM7711_SCK_HALF_PERIOD_US 1
 
 /**
- * @brief Number of clock pulses for Channel 1 at 10 Hz.
+ * @brief Number of SPI hosts available to the SPI readout, and so of chips it reads at once.
  */
-#define CH1_10HZ_CLK  25
+#define TM7711_SPI_HOST_COUNT 2
 
 /**
- * @brief Number of clock pulses for Channel 1 at 40 Hz.
+ * @brief How the PD_SCK clock train of a readout is generated.
  */
-#define CH1_40HZ_CLK  27
-
-/**
- * @brief Number of clock pulses for Channel 2 temperature measurement.
- */
-#define CH2_TEMP_CLK  26
+typedef enum {
+    TM7711_READOUT_GPIO,    ///< Bit-banged by the DOUT interrupt, about 60 us of CPU per sample.
+    TM7711_READOUT_SPI,     ///< Clocked by an SPI host of its own; the CPU only starts the transfer.
+} Tm7711Readout;
 
 /**
  * @brief Initialize the TM7711 ADC with specified pins.
@@ -42,13 +47,47 @@
 esp_err_t tm7711_init(int dout_pin, int sck_pin);
 
 /**
- * @brief Read data from the TM7711 ADC.
- * @param next_select Mode selection for the next reading (e.g., CH1_10HZ, CH1_40HZ, CH2_TEMP).
+ * @brief Reset a TM7711 and start reading it from the DOUT falling edge interrupt.
+ *
+ * Every conversion is clocked out when DOUT falls and queued in the chip's sample ring, so
+ * the chip runs at its own output rate without a task polling DOUT. With the SPI readout the
+ * interrupt only wakes a driver task, which starts the transfers of all ready chips so they
+ * run side by side on their SPI hosts. Attaching a DOUT pin again replaces its previous channel.
  * @param dout_pin GPIO pin for data output.
  * @param sck_pin GPIO pin for serial clock.
- * @param data Pointer to store the read data.
- * @return esp_err_t ESP_OK on success, or an error code on failure.
+ * @param next_select Mode of every conversion (CH1_10HZ, CH1_40HZ or CH2_TEMP).
+ * @param readout How the clock train is generated.
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if all channels or SPI hosts are in use,
+ *                   ESP_ERR_NOT_SUPPORTED if the target has no SPI host for the readout, or the driver error.
+ */
+esp_err_t tm7711_attach(int dout_pin, int sck_pin, unsigned char next_select, Tm7711Readout readout);
+
+/**
+ * @brief Stop reading the TM7711 on a DOUT pin.
+ * @param dout_pin GPIO pin for data output.
+ */
+void tm7711_detach(int dout_pin);
+
+/**
+ * @brief Stop reading all attached TM7711 chips.
+ */
+void tm7711_detach_all(void);
+
+/**
+ * @brief Take the samples queued for a TM7711, oldest first.
+ *
+ * A conversion whose falling edge was missed is read here if DOUT is low.
+ * @param dout_pin GPIO pin for data output.
+ * @param samples Buffer receiving the raw 24-bit samples.
+ * @param max Capacity of samples.
+ * @return size_t Number of samples taken, 0 if none are queued or the pin is not attached.
+ */
+size_t tm7711_take(int dout_pin, uint32_t *samples, size_t max);
+
+/**
+ * @brief Set the task notified when a sample is queued.
+ * @param task Task to notify with vTaskNotifyGiveFromISR, or NULL.
  */
-esp_err_t tm7711_read(unsigned char next_select, int dout_pin, int sck_pin, unsigned long *data);
+void tm7711_set_listener(TaskHandle_t task);
 
 #endif
\ No newline at end of file
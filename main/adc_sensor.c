@@ -64,7 +64,46 @@ static ADCSensorState *find_or_add_sensor_state(const char *sensor_name) {
     return NULL;
 }
 
-esp_err_t adc_sensor_init(char *sensor_type, char *pd_sck, char *dout){
+/**
+ * @brief Converts a sampling rate setting into a TM7711 mode.
+ * @param sampling_rate Sampling rate string ("10Hz", "40Hz" or "Temperature").
+ * @param next_select Receives the TM7711 mode.
+ * @return bool True if the setting is supported.
+ */
+static bool tm7711_mode(const char *sampling_rate, unsigned char *next_select) {
+    if (!sampling_rate) {
+        return false;
+    }
+    if (strcmp(sampling_rate, "10Hz") == 0) {
+        *next_select = CH1_10HZ;
+    } else if (strcmp(sampling_rate, "40Hz") == 0) {
+        *next_select = CH1_40HZ;
+    } else if (strcmp(sampling_rate, "Temperature") == 0) {
+        *next_select = CH2_TEMP;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Converts a readout setting into a TM7711 readout.
+ * @param readout Readout string ("GPIO" or "SPI"), or NULL or empty for the default.
+ * @param tm7711_readout Receives the TM7711 readout.
+ * @return bool True if the setting is supported.
+ */
+static bool tm7711_readout_of(const char *readout, Tm7711Readout *tm7711_readout) {
+    if (!readout || !*readout || strcmp(readout, "GPIO") == 0) {
+        *tm7711_readout = TM7711_READOUT_GPIO;
+    } else if (strcmp(readout, "SPI") == 0) {
+        *tm7711_readout = TM7711_READOUT_SPI;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+esp_err_t adc_sensor_init(char *sensor_type, char *pd_sck, char *dout, char *sampling_rate, char *readout){
     gpio_num_t dout_pin, pd_sck_pin;
     esp_err_t ret;
 
@@ -80,8 +119,20 @@ esp_err_t adc_sensor_init(char *sensor_type, char *pd_sck, char *dout){
     
     // Initialize TM7711 sensor if specified
     if (strcmp(sensor_type, "TM7711") == 0) {
-        // Initialize TM7711 with specified pins
-        ret = tm7711_init(dout_pin, pd_sck_pin);
+        // Map sampling rate string to corresponding constant
+        unsigned char next_select;
+        if (!tm7711_mode(sampling_rate, &next_select)) {
+            ESP_LOGE(TAG, "Unsupported sampling_rate value: %s", sampling_rate ? sampling_rate : "(null)");
+            return ESP_ERR_INVALID_ARG;
+        }
+        Tm7711Readout tm7711_readout;
+        if (!tm7711_readout_of(readout, &tm7711_readout)) {
+            ESP_LOGE(TAG, "Unsupported readout value: %s", readout);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        // Reset the TM7711 and read it from its data-ready interrupt from now on
+        ret = tm7711_attach(dout_pin, pd_sck_pin, next_select, tm7711_readout);
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "TM7711 initialization failed: %d", ret);
             return ret;
@@ -93,70 +144,51 @@ esp_err_t adc_sensor_init(char *sensor_type, char *pd_sck, char *dout){
     return ESP_ERR_NOT_SUPPORTED;
 }
 
-double adc_sensor_read(char *sensor_type, char *pd_sck, char *dout, double map_low, double map_high, double gain, char *sampling_rate, const char *sensor_name) {
-    gpio_num_t dout_pin, pd_sck_pin;
-    unsigned long data = 0;
-    esp_err_t ret;
-
-    // Find GPIO pins by name
-    if (!find_pin_by_name(pd_sck, &pd_sck_pin)) {
-        ESP_LOGE(TAG, "PD_SCK pin %s not found", pd_sck);
-        return 0.0;
-    }
-    if (!find_pin_by_name(dout, &dout_pin)) {
-        ESP_LOGE(TAG, "DOUT pin %s not found", dout);
-        return 0.0;
-    }
-
+bool adc_sensor_read(const char *sensor_type, gpio_num_t dout_pin, double map_low, double map_high, double gain, const char *sensor_name, double *value) {
     // Validate mapping parameters and gain
     if (map_low == map_high || gain < 0) {
         ESP_LOGE(TAG, "Invalid mapping parameters or gain");
-        return 0.0;
+        return false;
     }
-    
-    // Handle TM7711 sensor reading
-    if (strcmp(sensor_type, "TM7711") == 0) {
-        unsigned char next_select;
 
-        // Map sampling rate string to corresponding constant
-        if (strcmp(sampling_rate, "10Hz") == 0) {
-            next_select = CH1_10HZ;
-        } else if (strcmp(sampling_rate, "40Hz") == 0) {
-            next_select = CH1_40HZ;
-        } else if (strcmp(sampling_rate, "Temperature") == 0) {
-            next_select = CH2_TEMP;
-        } else {
-            ESP_LOGE(TAG, "Unsupported sampling_rate value: %s", sampling_rate);
-            return 0.0;
-        }
-
-        // Read data from TM7711 sensor
-        ret = tm7711_read(next_select, dout_pin, pd_sck_pin, &data);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "TM7711 read failed: %d", ret);
-            return 0.0;
+    // Handle TM7711 sensor samples
+    if (strcmp(sensor_type, "TM7711") == 0) {
+        // Take the samples the interrupt queued since the previous read
+        uint32_t samples[TM7711_RING_SIZE];
+        size_t count = tm7711_take(dout_pin, samples, TM7711_RING_SIZE);
+        if (count == 0) {
+            return false;
         }
 
         // Find or add sensor state
         ADCSensorState *state = find_or_add_sensor_state(sensor_name);
         if (!state) {
-            return 0.0;
+            return false;
         }
 
-        // Check for extreme values (min=0, max=16777215 for 24-bit ADC)
-        if (data == 0 || data == 16777215) {
-            ESP_LOGW(TAG, "Extreme value detected for %s: %lu, returning last value", sensor_name, data);
-            return state->has_value ? state->last_value : 0.0;
+        bool updated = false;
+        for (size_t n = 0; n < count; n++) {
+            uint32_t data = samples[n];
+
+            // Check for extreme values (min=0, max=16777215 for 24-bit ADC)
+            if (data == 0 || data == 16777215) {
+                ESP_LOGW(TAG, "Extreme value detected for %s: %lu, keeping last value", sensor_name, (unsigned long)data);
+                continue;
+            }
+
+            // Map the raw data to the specified range
+            double mapped_value = map_value((double)data, 0, 16777215, map_low, map_high);
+
+            // Update the sensor value buffer
+            state->value_buffer[state->buffer_index] = mapped_value;
+            state->buffer_index = (state->buffer_index + 1) % VALUE_BUFFER_SIZE;
+            if (state->buffer_count < VALUE_BUFFER_SIZE) {
+                state->buffer_count++;
+            }
+            updated = true;
         }
-
-        // Map the raw data to the specified range
-        double mapped_value = map_value((double)data, 0, 16777215, map_low, map_high);
-
-        // Update the sensor value buffer
-        state->value_buffer[state->buffer_index] = mapped_value;
-        state->buffer_index = (state->buffer_index + 1) % VALUE_BUFFER_SIZE;
-        if (state->buffer_count < VALUE_BUFFER_SIZE) {
-            state->buffer_count++;
+        if (!updated) {
+            return false;
         }
 
         // Calculate the average of buffered values
@@ -170,10 +202,25 @@ double adc_sensor_read(char *sensor_type, char *pd_sck, char *dout, double map_l
         state->last_value = avg_value;
         state->has_value = true;
 
-        return avg_value;
+        *value = avg_value;
+        return true;
     }
 
     // Log error for unsupported sensor types
     ESP_LOGE(TAG, "Unsupported sensor type: %s", sensor_type);
-    return 0.0;
-}
\ No newline at end of file
+    return false;
+}
+
+void adc_sensor_release(const char *sensor_type, gpio_num_t dout_pin) {
+    if (sensor_type && strcmp(sensor_type, "TM7711") == 0) {
+        tm7711_detach(dout_pin);
+    }
+}
+
+void adc_sensor_release_all(void) {
+    tm7711_detach_all();
+}
+
+void adc_sensor_set_listener(TaskHandle_t task) {
+    tm7711_set_listener(task);
+}
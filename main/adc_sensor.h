@@ -2,6 +2,8 @@
 #define _ADC_SENSOR_H_
 
 #include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 /**
  * @brief Maximum number of ADC sensors supported.
@@ -42,26 +44,46 @@ extern ADCSensorState sensor_states[];
 extern int sensor_state_count;
 
 /**
- * @brief Initializes an ADC sensor with the specified configuration.
+ * @brief Initializes an ADC sensor and starts its interrupt-driven acquisition.
  * @param sensor_type Type of the sensor (e.g., model or identifier).
  * @param pd_sck Pin used for the clock signal.
  * @param dout Pin used for data output.
+ * @param sampling_rate Sampling rate of the sensor ("10Hz", "40Hz" or "Temperature").
+ * @param readout Peripheral clocking the sensor: "GPIO" (or empty) to bit-bang in the data-ready
+ *                interrupt, "SPI" to let an SPI host generate the clock train.
  * @return esp_err_t Error code indicating success or failure of initialization.
  */
-esp_err_t adc_sensor_init(char *sensor_type, char *pd_sck, char *dout);
+esp_err_t adc_sensor_init(char *sensor_type, char *pd_sck, char *dout, char *sampling_rate, char *readout);
 
 /**
- * @brief Reads the value from an ADC sensor and maps it to a specified range.
+ * @brief Takes the samples an ADC sensor acquired since the previous call and maps them to a specified range.
  * @param sensor_type Type of the sensor (e.g., model or identifier).
- * @param pd_sck Pin used for the clock signal.
- * @param dout Pin used for data output.
+ * @param dout_pin GPIO used for data output.
  * @param map_low Lower bound of the mapped output range.
  * @param map_high Upper bound of the mapped output range.
  * @param gain Gain factor to apply to the sensor reading.
- * @param sampling_rate Sampling rate for reading the sensor.
  * @param sensor_name Name of the sensor for identification.
- * @return double The mapped sensor value.
+ * @param value Receives the average of the last mapped samples.
+ * @return bool True if new samples were taken, false if there were none or the sensor is invalid.
+ */
+bool adc_sensor_read(const char *sensor_type, gpio_num_t dout_pin, double map_low, double map_high, double gain, const char *sensor_name, double *value);
+
+/**
+ * @brief Stops the acquisition of an ADC sensor.
+ * @param sensor_type Type of the sensor (e.g., model or identifier).
+ * @param dout_pin GPIO used for data output.
+ */
+void adc_sensor_release(const char *sensor_type, gpio_num_t dout_pin);
+
+/**
+ * @brief Stops the acquisition of all ADC sensors.
+ */
+void adc_sensor_release_all(void);
+
+/**
+ * @brief Sets the task notified whenever an ADC sensor acquired a sample.
+ * @param task Task to notify, or NULL.
  */
-double adc_sensor_read(char *sensor_type, char *pd_sck, char *dout, double map_low, double map_high, double gain, char *sampling_rate, const char *sensor_name);
+void adc_sensor_set_listener(TaskHandle_t task);
 
 #endif
\ No newline at end of file
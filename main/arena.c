@@ -0,0 +1,83 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+
+/**
+ * @brief Tag for logging messages from the arena module.
+ */
+static const char *TAG = "ARENA";
+
+Arena config_arena = { .block_size = ARENA_DEFAULT_BLOCK_SIZE };
+
+void *arena_alloc(Arena *arena, size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (size == 0) {
+        size = ARENA_ALIGNMENT;
+    }
+
+    ArenaBlock *block = arena->head;
+    if (!block || block->size - block->used < size) {
+        size_t block_size = arena->block_size;
+        if (!arena->head && arena->first_block_hint > block_size) {
+            block_size = arena->first_block_hint;
+        }
+        if (size > block_size) {
+            block_size = size;
+        }
+
+        block = malloc(sizeof(ArenaBlock) + block_size);
+        if (!block) {
+            ESP_LOGE(TAG, "Failed to allocate %zu byte block", block_size);
+            return NULL;
+        }
+        block->next = arena->head;
+        block->size = block_size;
+        block->used = 0;
+        arena->head = block;
+    }
+
+    void *ptr = block->data + block->used;
+    block->used += size;
+    arena->total_used += size;
+    return ptr;
+}
+
+void *arena_calloc(Arena *arena, size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size) {
+        return NULL;
+    }
+    void *ptr = arena_alloc(arena, count * size);
+    if (ptr) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+char *arena_strdup(Arena *arena, const char *str) {
+    if (!str) {
+        return NULL;
+    }
+    size_t len = strlen(str) + 1;
+    char *copy = arena_alloc(arena, len);
+    if (copy) {
+        memcpy(copy, str, len);
+    }
+    return copy;
+}
+
+void arena_reset(Arena *arena) {
+    if (arena->head && !arena->head->next) {
+        // Common case: the whole generation fit in one block, keep it
+        arena->head->used = 0;
+    } else {
+        // Free all blocks and make the next generation start with one block that fits
+        arena->first_block_hint = arena->total_used;
+        while (arena->head) {
+            ArenaBlock *next = arena->head->next;
+            free(arena->head);
+            arena->head = next;
+        }
+    }
+    arena->total_used = 0;
+}
@@ -0,0 +1,76 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Alignment of every arena allocation in bytes.
+ */
+#define ARENA_ALIGNMENT 8
+
+/**
+ * @brief Default minimum size of an arena block in bytes.
+ */
+#define ARENA_DEFAULT_BLOCK_SIZE 4096
+
+/**
+ * @brief Memory block owned by an arena.
+ */
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;                    ///< Previously filled block.
+    size_t size;                                ///< Usable size of the block in bytes.
+    size_t used;                                ///< Bytes handed out from the block.
+    _Alignas(ARENA_ALIGNMENT) uint8_t data[];   ///< Block storage.
+} ArenaBlock;
+
+/**
+ * @brief Bump allocator whose allocations are all released at once.
+ */
+typedef struct {
+    ArenaBlock *head;       ///< Block currently allocated from.
+    size_t block_size;      ///< Minimum size of a new block.
+    size_t total_used;      ///< Bytes handed out since the last reset.
+    size_t first_block_hint; ///< Size of the first block after a reset, learned from the previous generation.
+} Arena;
+
+/**
+ * @brief Arena holding all memory of the applied configuration (device, variables, compiled program).
+ */
+extern Arena config_arena;
+
+/**
+ * @brief Allocates memory from an arena.
+ * @param arena Pointer to the arena.
+ * @param size Number of bytes to allocate.
+ * @return void* Pointer to ARENA_ALIGNMENT-aligned memory, or NULL on allocation failure.
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * @brief Allocates zeroed memory for an array from an arena.
+ * @param arena Pointer to the arena.
+ * @param count Number of elements.
+ * @param size Size of one element.
+ * @return void* Pointer to zeroed memory, or NULL on allocation failure or overflow.
+ */
+void *arena_calloc(Arena *arena, size_t count, size_t size);
+
+/**
+ * @brief Copies a string into an arena.
+ * @param arena Pointer to the arena.
+ * @param str String to copy.
+ * @return char* Pointer to the copy, or NULL if str is NULL or allocation fails.
+ */
+char *arena_strdup(Arena *arena, const char *str);
+
+/**
+ * @brief Releases all allocations of an arena at once.
+ *
+ * A single-block arena keeps its block for the next generation; otherwise all
+ * blocks are freed and the next first block is sized to the previous footprint.
+ * @param arena Pointer to the arena.
+ */
+void arena_reset(Arena *arena);
+
+#endif // ARENA_H
@@ -1,5 +1,6 @@
 #include "ble.h"
 #include <stdio.h>
+#include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "nvs_flash.h"
@@ -14,9 +15,12 @@
 #include "esp_mac.h"
 
 #include "conf_task_manager.h"
+#include "config_transfer.h"
 #include "nvs_utils.h"
 
 #include "variables.h"
+#include "json_writer.h"
+#include "cbor.h"
 #include "one_wire_detect.h"
 
 /**
@@ -30,6 +34,31 @@ char *TAG = "BLE-Server";
  */
 static uint16_t ble_mtu = 23; // Default minimum MTU
 
+/**
+ * @brief Interval in milliseconds between monitor stream rounds (up to 20 frames per second).
+ */
+#define BLE_MONITOR_PERIOD_MS 50
+
+/**
+ * @brief Number of stream rounds between keyframes (5 seconds).
+ */
+#define BLE_MONITOR_KEYFRAME_INTERVAL 100
+
+/**
+ * @brief Link layer payload requested through Data Length Extension, in bytes.
+ */
+#define BLE_DLE_TX_OCTETS 251
+
+/**
+ * @brief Transmit time for BLE_DLE_TX_OCTETS on the 1M PHY, in microseconds.
+ */
+#define BLE_DLE_TX_TIME 2120
+
+/**
+ * @brief Largest attribute value accepted in one write, the ATT limit for long (prepared) writes.
+ */
+#define BLE_WRITE_MAX_LEN 512
+
 /**
  * @brief BLE address type (public or random).
  */
@@ -52,75 +81,363 @@ uint16_t conn_handle = BLE_HS_CONN_HANDLE_NONE;
 bool app_connected_ble = false;
 
 /**
- * @brief Handles read requests for the configuration characteristic.
- * Loads configuration from NVS and sends it in chunks based on the MTU size.
- * @param conn_handle Connection handle for the BLE connection.
- * @param attr_handle Attribute handle of the characteristic.
- * @param ctxt Context for the GATT access operation.
- * @param arg Unused argument.
- * @return int 0 on success, or a BLE_ATT error code on failure.
+ * @brief Attribute handle of the configuration acknowledgement characteristic.
  */
-static int configuration_read(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg) {
-    static char *nvs_data = NULL;
-    static size_t nvs_data_len = 0;
-    static size_t offset = 0;
+static uint16_t config_ack_handle = 0;
 
-    // Load configuration from NVS if not already loaded
-    if (nvs_data == NULL) {
-        ESP_LOGI(TAG, "Client requested configuration");
+/**
+ * @brief Attribute handle of the monitor stream characteristic.
+ */
+static uint16_t monitor_notify_handle = 0;
+
+/**
+ * @brief True while the client is subscribed to monitor stream notifications.
+ */
+static volatile bool monitor_subscribed = false;
+
+/**
+ * @brief Set to make the stream drop its pending frame and start over with a keyframe.
+ */
+static volatile bool monitor_stream_resync = true;
+
+/**
+ * @brief Maximum number of simultaneous BLE client sessions.
+ */
+#define BLE_MAX_SESSIONS CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+
+/**
+ * @brief Reference-counted document shared by the sessions reading it.
+ */
+typedef struct {
+    uint32_t refs;   ///< Number of holders; the document is freed when the last one releases it.
+    uint8_t *data;   ///< Document bytes, owned by the snapshot.
+    size_t len;      ///< Length of the document in bytes.
+} BleSnapshot;
+
+/**
+ * @brief Position of a client in a document sent over consecutive reads.
+ */
+typedef struct {
+    const uint8_t *data;  ///< Document being read, or NULL between documents.
+    size_t len;           ///< Length of the document in bytes.
+    size_t offset;        ///< Offset of the next chunk.
+} ReadCursor;
+
+/**
+ * @brief State of one connected client.
+ * Accessed from the NimBLE host task; the monitor stream task only reads the encoding.
+ */
+typedef struct {
+    uint16_t conn_handle;        ///< Connection owning the session, BLE_HS_CONN_HANDLE_NONE if unused.
+    bool cbor;                   ///< True if the client selected CBOR monitor frames.
+    bool names_sent;             ///< True once the index-to-name table was read by the CBOR client.
+    uint32_t names_generation;   ///< Variables generation of the last index-to-name table.
+    BleSnapshot *config;         ///< Configuration snapshot being read, holds a reference.
+    ReadCursor config_cursor;    ///< Position in the configuration.
+    JsonBuffer monitor_json;     ///< Monitor document in JSON, reused between reads.
+    CborBuffer monitor_cbor;     ///< Monitor document in CBOR, reused between reads.
+    ReadCursor monitor_cursor;   ///< Position in the monitor document.
+    char *one_wire_json;         ///< One-wire document in JSON.
+    CborBuffer one_wire_cbor;    ///< One-wire document in CBOR, reused between reads.
+    ReadCursor one_wire_cursor;  ///< Position in the one-wire document.
+} BleSession;
+
+/**
+ * @brief Client sessions, looked up by connection handle.
+ */
+static BleSession sessions[BLE_MAX_SESSIONS];
+
+/**
+ * @brief Cached configuration read from NVS, shared by all sessions.
+ */
+static BleSnapshot *config_snapshot = NULL;
+
+/**
+ * @brief Configuration generation (get_config_generation) the cached configuration was read at.
+ */
+static uint32_t config_snapshot_generation = 0;
+
+/**
+ * @brief Last configuration transfer acknowledgement, returned on read.
+ */
+static char config_ack[CONFIG_TRANSFER_ACK_LEN] = "";
+
+/**
+ * @brief Drops a reference to a snapshot, freeing it with the last one.
+ * @param snapshot Snapshot to release, may be NULL.
+ */
+static void snapshot_release(BleSnapshot *snapshot) {
+    if (snapshot && --snapshot->refs == 0) {
+        free(snapshot->data);
+        free(snapshot);
+    }
+}
+
+/**
+ * @brief Returns a reference to the configuration stored in NVS.
+ * NVS is read only when the stored configuration changed since the last read, including
+ * changes that keep the variables, such as a new set of wires.
+ * @return BleSnapshot* Snapshot holding a reference for the caller, or NULL on error.
+ */
+static BleSnapshot *acquire_config_snapshot(void) {
+    uint32_t generation = get_config_generation();
+    if (config_snapshot && config_snapshot_generation != generation) {
+        snapshot_release(config_snapshot); // Sessions still reading keep the old document
+        config_snapshot = NULL;
+    }
+
+    if (config_snapshot == NULL) {
+        BleSnapshot *snapshot = calloc(1, sizeof(BleSnapshot));
+        if (snapshot == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate configuration snapshot");
+            return NULL;
+        }
+        char *nvs_data = NULL;
+        size_t nvs_data_len = 0;
         esp_err_t ret = load_config_from_nvs(&nvs_data, &nvs_data_len);
         if (ret != ESP_OK || nvs_data == NULL) {
             ESP_LOGE(TAG, "Failed to load config from NVS");
-            return 0;
+            free(snapshot);
+            return NULL;
         }
+        snapshot->refs = 1; // Held by the cache
+        snapshot->data = (uint8_t *)nvs_data;
+        snapshot->len = nvs_data_len;
+        config_snapshot = snapshot;
+        // Taken before the read, so a configuration saved meanwhile replaces it on the next read
+        config_snapshot_generation = generation;
+    }
+
+    config_snapshot->refs++;
+    return config_snapshot;
+}
+
+/**
+ * @brief Finds the session of a connection.
+ * @param handle Connection handle.
+ * @return BleSession* Session, or NULL if the connection has none.
+ */
+static BleSession *session_find(uint16_t handle) {
+    for (int i = 0; i < BLE_MAX_SESSIONS; i++) {
+        if (sessions[i].conn_handle == handle && handle != BLE_HS_CONN_HANDLE_NONE) return &sessions[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Starts a session for a new connection.
+ * @param handle Connection handle.
+ * @return BleSession* New session, or NULL if all sessions are in use.
+ */
+static BleSession *session_open(uint16_t handle) {
+    BleSession *session = NULL;
+    for (int i = 0; i < BLE_MAX_SESSIONS && session == NULL; i++) {
+        if (sessions[i].conn_handle == BLE_HS_CONN_HANDLE_NONE) session = &sessions[i];
     }
+    if (session == NULL) {
+        ESP_LOGE(TAG, "No free session for conn_handle=%d", handle);
+        return NULL;
+    }
+    memset(session, 0, sizeof(*session)); // Each connection starts with JSON frames
+    session->conn_handle = handle;
+    return session;
+}
+
+/**
+ * @brief Ends the session of a closed connection and releases everything it holds.
+ * The cached configuration is dropped with the last session.
+ * @param handle Connection handle.
+ */
+static void session_close(uint16_t handle) {
+    BleSession *session = session_find(handle);
+    if (session == NULL) return;
+
+    snapshot_release(session->config);
+    free(session->monitor_json.data);
+    free(session->monitor_cbor.data);
+    free(session->one_wire_json);
+    free(session->one_wire_cbor.data);
+    memset(session, 0, sizeof(*session));
+    session->conn_handle = BLE_HS_CONN_HANDLE_NONE;
+
+    for (int i = 0; i < BLE_MAX_SESSIONS; i++) {
+        if (sessions[i].conn_handle != BLE_HS_CONN_HANDLE_NONE) return;
+    }
+    snapshot_release(config_snapshot);
+    config_snapshot = NULL;
+}
 
+/**
+ * @brief Sends the next MTU-sized chunk of a document over consecutive reads.
+ * The chunk is appended straight from the document; an empty response signals the end,
+ * after which the cursor is reset for the next document.
+ * @param ctxt Context for the GATT access operation.
+ * @param cursor Position of the client in the document.
+ * @return int 0 on success, or a BLE_ATT error code on failure.
+ */
+static int send_read_chunk(struct ble_gatt_access_ctxt *ctxt, ReadCursor *cursor) {
     // Check if all data has been sent
-    if (offset >= nvs_data_len) {
-        // All data sent, return empty response to signal end
-        ESP_LOGI(TAG, "Configuration sent successfully. (End of data reached, sending empty response)");
-        if (nvs_data != NULL) {
-            free(nvs_data); // Free allocated memory
-            nvs_data = NULL;
-            nvs_data_len = 0;
-            offset = 0;
-        }
-        return 0; // Success, no more data to send
+    if (cursor->offset >= cursor->len) {
+        memset(cursor, 0, sizeof(*cursor)); // Keep the buffer for the next snapshot
+        return 0; // Empty response signals end
     }
 
     // Calculate chunk size based on remaining data and MTU
-    size_t remaining = nvs_data_len - offset;
-    size_t current_chunk_size = (remaining > (ble_mtu - 3)) ? (ble_mtu - 3) : remaining;
+    size_t remaining = cursor->len - cursor->offset;
+    size_t chunk_size = (remaining > (ble_mtu - 3)) ? (ble_mtu - 3) : remaining;
 
     // Append chunk to response buffer
-    int rc = os_mbuf_append(ctxt->om, &nvs_data[offset], current_chunk_size);
+    int rc = os_mbuf_append(ctxt->om, cursor->data + cursor->offset, chunk_size);
     if (rc != 0) {
         ESP_LOGE(TAG, "Failed to append data to mbuf: %d", rc);
+        memset(cursor, 0, sizeof(*cursor));
         return BLE_ATT_ERR_INSUFFICIENT_RES;
     }
 
-    offset += current_chunk_size; // Update offset for next read
-    return 0; 
+    cursor->offset += chunk_size; // Update offset for next read
+    return 0;
+}
+
+/**
+ * @brief Handles read requests for the configuration characteristic.
+ * Sends the cached configuration in chunks based on the MTU size.
+ * @param conn_handle Connection handle for the BLE connection.
+ * @param attr_handle Attribute handle of the characteristic.
+ * @param ctxt Context for the GATT access operation.
+ * @param arg Unused argument.
+ * @return int 0 on success, or a BLE_ATT error code on failure.
+ */
+static int configuration_read(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg) {
+    BleSession *session = session_find(conn_handle);
+    if (session == NULL) return BLE_ATT_ERR_UNLIKELY;
+
+    // Take a reference to the configuration at the start of each read-through
+    if (session->config == NULL) {
+        ESP_LOGI(TAG, "Client requested configuration");
+        session->config = acquire_config_snapshot();
+        if (session->config == NULL) return 0;
+        session->config_cursor = (ReadCursor){ session->config->data, session->config->len, 0 };
+    }
+
+    int rc = send_read_chunk(ctxt, &session->config_cursor);
+    if (session->config_cursor.data == NULL) {
+        // All data sent (or the read failed), release the snapshot
+        if (rc == 0) ESP_LOGI(TAG, "Configuration sent successfully. (End of data reached, sending empty response)");
+        snapshot_release(session->config);
+        session->config = NULL;
+    }
+    return rc;
+}
+
+/**
+ * @brief Copies a written value out of its mbuf chain.
+ * NimBLE reassembles long (prepared) writes and passes them to the access callback
+ * at execution as a chain of mbufs, so the first mbuf alone may hold only part of the value.
+ * @param ctxt Context for the GATT access operation.
+ * @param buf Buffer receiving the value.
+ * @param size Size of the buffer.
+ * @param len Pointer to store the value length.
+ * @return int 0 on success, or a BLE_ATT error code on failure.
+ */
+static int flatten_write(struct ble_gatt_access_ctxt *ctxt, uint8_t *buf, size_t size, size_t *len) {
+    size_t total = OS_MBUF_PKTLEN(ctxt->om);
+    if (total > size) {
+        ESP_LOGE(TAG, "Written value too long: %u bytes", (unsigned)total);
+        return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    if (os_mbuf_copydata(ctxt->om, 0, (int)total, buf) != 0) {
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+    *len = total;
+    return 0;
 }
 
 /**
  * @brief Handles write requests for the configuration characteristic.
- * Applies the received configuration data.
+ * Framed transfers are acknowledged through the acknowledgement characteristic;
+ * other data is applied as a raw configuration chunk. Long writes arrive here once,
+ * after the client executes them, with the whole value.
  * @param conn_handle Connection handle for the BLE connection.
  * @param attr_handle Attribute handle of the characteristic.
  * @param ctxt Context for the GATT access operation.
  * @param arg Unused argument.
- * @return int 0 on success.
+ * @return int 0 on success, or a BLE_ATT error code on failure.
  */
 static int configuration_write(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg) {
-    const char *data = (const char *)ctxt->om->om_data;
-    configure(data, ctxt->om->om_len, false); // Apply configuration
+    static uint8_t value[BLE_WRITE_MAX_LEN]; // Only the host task writes here
+    size_t len = 0;
+    int rc = flatten_write(ctxt, value, sizeof(value), &len);
+    if (rc != 0) return rc;
+
+    if (config_transfer_is_frame(value, len)) {
+        // Framed transfer: write the chunk in place and notify the acknowledgement
+        if (config_transfer_handle_frame(value, len, config_ack, sizeof(config_ack))) {
+            struct os_mbuf *om = ble_hs_mbuf_from_flat(config_ack, strlen(config_ack));
+            if (om && ble_gatts_notify_custom(conn_handle, config_ack_handle, om) != 0) {
+                ESP_LOGW(TAG, "Failed to notify configuration acknowledgement");
+            }
+        }
+        return 0;
+    }
+    configure((const char *)value, (int)len, false); // Apply configuration
+    return 0;
+}
+
+/**
+ * @brief Handles read requests for the configuration acknowledgement characteristic.
+ * Returns the last acknowledgement so a reconnecting client can find the resume offset.
+ * @param conn_handle Connection handle for the BLE connection.
+ * @param attr_handle Attribute handle of the characteristic.
+ * @param ctxt Context for the GATT access operation.
+ * @param arg Unused argument.
+ * @return int 0 on success, or a BLE_ATT error code on failure.
+ */
+static int config_ack_read(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg) {
+    int rc = os_mbuf_append(ctxt->om, config_ack, strlen(config_ack));
+    return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+/**
+ * @brief Handles read and write requests for the monitor encoding characteristic.
+ * Writing "Cbor" switches the monitor and one-wire characteristics of this connection
+ * to CBOR frames; "Json" switches back. Reads return the current encoding.
+ * @param conn_handle Connection handle for the BLE connection.
+ * @param attr_handle Attribute handle of the characteristic.
+ * @param ctxt Context for the GATT access operation.
+ * @param arg Unused argument.
+ * @return int 0 on success, or a BLE_ATT error code on failure.
+ */
+static int encoding_access(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg) {
+    BleSession *session = session_find(conn_handle);
+    if (session == NULL) return BLE_ATT_ERR_UNLIKELY;
+
+    if (ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
+        const char *encoding = session->cbor ? "Cbor" : "Json";
+        int rc = os_mbuf_append(ctxt->om, encoding, strlen(encoding));
+        return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+
+    char data[8];
+    size_t len = 0;
+    int rc = flatten_write(ctxt, (uint8_t *)data, sizeof(data), &len);
+    if (rc != 0) return rc;
+    if (len == 4 && strncmp(data, "Cbor", 4) == 0) {
+        session->cbor = true;
+        session->names_sent = false; // Start with the index-to-name table
+    } else if (len == 4 && strncmp(data, "Json", 4) == 0) {
+        session->cbor = false;
+    } else {
+        return BLE_ATT_ERR_VALUE_NOT_ALLOWED;
+    }
+    ESP_LOGI(TAG, "Monitor encoding set to %s", session->cbor ? "CBOR" : "JSON");
+    monitor_stream_resync = true; // Restart the stream in the new encoding
     return 0;
 }
 
 /**
  * @brief Handles read requests for the monitor characteristic.
- * Reads variable data as JSON and sends it in chunks based on the MTU size.
+ * Reads variable data as JSON (or a CBOR frame) and sends it in chunks based on the MTU size.
+ * In CBOR mode the first document after a (re)configuration is the index-to-name table.
  * @param conn_handle Connection handle for the BLE connection.
  * @param attr_handle Attribute handle of the characteristic.
  * @param ctxt Context for the GATT access operation.
@@ -128,52 +445,201 @@ static int configuration_write(uint16_t conn_handle, uint16_t attr_handle, struc
  * @return int 0 on success, or a BLE_ATT error code on failure.
  */
 static int monitor_read(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg) {
-    static char *monitor_data = NULL;
-    static size_t monitor_data_len = 0;
-    static size_t monitor_offset = 0;
+    BleSession *session = session_find(conn_handle);
+    if (session == NULL) return BLE_ATT_ERR_UNLIKELY;
+    ReadCursor *cursor = &session->monitor_cursor;
 
     // Load monitor data if not already loaded
-    if (monitor_data == NULL) {
-        monitor_data = read_variables_json(); // Read variables as JSON
-        if (monitor_data == NULL) {
-            ESP_LOGI(TAG, "No monitor data available");
-            return 0;
+    if (cursor->data == NULL) {
+        if (session->cbor) {
+            bool names = !session->names_sent || session->names_generation != get_variables_generation();
+            if (!cbor_buffer_fill(&session->monitor_cbor, names ? write_variable_names_cbor : write_variables_cbor)) {
+                ESP_LOGI(TAG, "No monitor data available");
+                return 0;
+            }
+            if (names) {
+                session->names_sent = true;
+                session->names_generation = get_variables_generation();
+            }
+            *cursor = (ReadCursor){ session->monitor_cbor.data, session->monitor_cbor.len, 0 };
+        } else {
+            if (!json_buffer_fill(&session->monitor_json, write_variables_json)) { // Read variables as JSON
+                ESP_LOGI(TAG, "No monitor data available");
+                return 0;
+            }
+            *cursor = (ReadCursor){ (const uint8_t *)session->monitor_json.data, session->monitor_json.len, 0 };
         }
-        monitor_data_len = strlen(monitor_data);
-        monitor_offset = 0;
     }
-    
-    // Check if all data has been sent
-    if (monitor_offset >= monitor_data_len) {
-        free(monitor_data); // Free allocated memory
-        monitor_data = NULL; 
-        monitor_data_len = 0; 
-        monitor_offset = 0; 
-        return 0; // Empty response signals end
+
+    return send_read_chunk(ctxt, cursor);
+}
+
+/**
+ * @brief Handles read requests for the monitor stream characteristic.
+ * Frames are only pushed as notifications, so reads return an empty value.
+ * @param conn_handle Connection handle for the BLE connection.
+ * @param attr_handle Attribute handle of the characteristic.
+ * @param ctxt Context for the GATT access operation.
+ * @param arg Unused argument.
+ * @return int 0 on success.
+ */
+static int monitor_notify_access(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg) {
+    return 0;
+}
+
+/**
+ * @brief Formats a JSON delta from the dirty bits of the BLE stream.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return size_t Length of the full document, or 0 if nothing changed.
+ */
+static size_t write_stream_delta_json(char *buf, size_t size) {
+    return write_variables_delta_json(MONITOR_CONSUMER_BLE, buf, size);
+}
+
+/**
+ * @brief Formats a CBOR delta from the dirty bits of the BLE stream.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return size_t Length of the full frame, or 0 if nothing changed.
+ */
+static size_t write_stream_delta_cbor(uint8_t *buf, size_t size) {
+    return write_variables_delta_cbor(MONITOR_CONSUMER_BLE, buf, size);
+}
+
+/**
+ * @brief Builds the next monitor stream frame.
+ * In CBOR mode the index-to-name table goes first, after that keyframes and change-driven deltas.
+ * @param cbor True to build a CBOR frame, false for JSON.
+ * @param keyframe True to build a keyframe, false for a delta.
+ * @param frame Pointer to store the frame.
+ * @param frame_len Pointer to store the frame length.
+ * @return bool True if a frame was built, false if nothing changed or on allocation failure.
+ */
+static bool build_stream_frame(bool cbor, bool keyframe, const uint8_t **frame, size_t *frame_len) {
+    static JsonBuffer stream_json = {0}; // Reused for the whole session
+    static CborBuffer stream_cbor = {0};
+
+    if (!cbor) {
+        if (!json_buffer_fill(&stream_json, keyframe ? write_variables_json : write_stream_delta_json)) return false;
+        *frame = (const uint8_t *)stream_json.data;
+        *frame_len = stream_json.len;
+        return true;
     }
+    if (!cbor_buffer_fill(&stream_cbor, keyframe ? write_variables_cbor : write_stream_delta_cbor)) return false;
+    *frame = stream_cbor.data;
+    *frame_len = stream_cbor.len;
+    return true;
+}
 
-    // Calculate chunk size based on remaining data and MTU
-    size_t remaining = monitor_data_len - monitor_offset;
-    size_t chunk_size = (remaining > (ble_mtu - 3)) ? (ble_mtu - 3) : remaining;
+/**
+ * @brief Pushes monitor frames to the subscribed client as notifications.
+ * Every notification starts with a header byte carrying MONITOR_PACKET_START and
+ * MONITOR_PACKET_END, followed by as much of the frame as fits in the ATT MTU.
+ * When the stack runs out of buffers the frame is continued in the next round; no new frame
+ * is built before it is finished, so changes made meanwhile coalesce into the next delta.
+ */
+static void stream_monitor(void) {
+    static CborBuffer names_cbor = {0};
+    static const uint8_t *frame = NULL;
+    static size_t frame_len = 0;
+    static size_t frame_offset = 0;
+    static int keyframe_countdown = 0;
+    static uint32_t names_generation = 0;
+    static bool names_sent = false;
+
+    if (monitor_stream_resync) {
+        monitor_stream_resync = false;
+        frame = NULL; // A partial frame is discarded by the client on the next start flag
+        keyframe_countdown = 0;
+        names_sent = false;
+    }
 
-    // Append chunk to response buffer
-    int rc = os_mbuf_append(ctxt->om, &monitor_data[monitor_offset], chunk_size);
-    if (rc != 0) {
-        ESP_LOGE(TAG, "Failed to append monitor data to mbuf: %d", rc);
-        free(monitor_data); // Free memory on error
-        monitor_data = NULL; 
-        monitor_data_len = 0; 
-        monitor_offset = 0; 
-        return BLE_ATT_ERR_INSUFFICIENT_RES;
+    // Only the encoding is read from the session, which the host task owns
+    BleSession *session = session_find(conn_handle);
+    if (session == NULL) return;
+    bool cbor = session->cbor;
+
+    if (frame == NULL) {
+        if (cbor && (!names_sent || names_generation != get_variables_generation())) {
+            if (!cbor_buffer_fill(&names_cbor, write_variable_names_cbor)) return;
+            names_sent = true;
+            names_generation = get_variables_generation();
+            frame = names_cbor.data;
+            frame_len = names_cbor.len;
+        } else {
+            // The stream has its own dirty bits, independent of the MQTT monitor
+            bool keyframe = keyframe_countdown-- <= 0;
+            if (keyframe) {
+                variables_clear_dirty(MONITOR_CONSUMER_BLE);
+                keyframe_countdown = BLE_MONITOR_KEYFRAME_INTERVAL;
+            }
+            if (!build_stream_frame(cbor, keyframe, &frame, &frame_len)) return; // Nothing changed
+        }
+        frame_offset = 0;
     }
 
-    monitor_offset += chunk_size; // Update offset for next read
-    return 0;
+    // ATT notification header takes 3 bytes and the packet header 1 more
+    size_t payload = ble_mtu > 4 ? ble_mtu - 4 : 1;
+    while (frame != NULL) {
+        size_t remaining = frame_len - frame_offset;
+        size_t chunk_size = remaining > payload ? payload : remaining;
+        uint8_t header = (frame_offset == 0 ? MONITOR_PACKET_START : 0) | (chunk_size == remaining ? MONITOR_PACKET_END : 0);
+
+        struct os_mbuf *om = ble_hs_mbuf_from_flat(&header, 1);
+        if (om == NULL) return; // Out of buffers, continue in the next round
+        if (os_mbuf_append(om, frame + frame_offset, chunk_size) != 0) {
+            os_mbuf_free_chain(om);
+            return;
+        }
+        if (ble_gatts_notify_custom(conn_handle, monitor_notify_handle, om) != 0) return; // The stack frees om
+
+        frame_offset += chunk_size;
+        if (frame_offset >= frame_len) frame = NULL;
+    }
+}
+
+/**
+ * @brief Task streaming monitor frames while a client is subscribed.
+ * @param param Unused parameter.
+ */
+static void monitor_stream_task(void *param) {
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(BLE_MONITOR_PERIOD_MS));
+        if (monitor_subscribed && conn_handle != BLE_HS_CONN_HANDLE_NONE) {
+            stream_monitor();
+        }
+    }
+}
+
+/**
+ * @brief Requests a faster link for streaming: larger MTU and link layer packets, the 2M PHY
+ * and a short connection interval. Clients may refuse any of them; the stream adapts to the MTU.
+ * @param handle Connection handle.
+ */
+static void request_fast_link(uint16_t handle) {
+    int rc = ble_gattc_exchange_mtu(handle, NULL, NULL);
+    if (rc != 0) ESP_LOGW(TAG, "MTU exchange request failed: %d", rc);
+
+    rc = ble_gap_set_data_len(handle, BLE_DLE_TX_OCTETS, BLE_DLE_TX_TIME);
+    if (rc != 0) ESP_LOGW(TAG, "Data length request failed: %d", rc);
+
+    rc = ble_gap_set_prefered_le_phy(handle, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_CODED_ANY);
+    if (rc != 0) ESP_LOGW(TAG, "2M PHY request failed: %d", rc);
+
+    struct ble_gap_upd_params params = {
+        .itvl_min = 12,                // 15 ms
+        .itvl_max = 24,                // 30 ms
+        .latency = 0,
+        .supervision_timeout = 400,    // 4 s
+    };
+    rc = ble_gap_update_params(handle, &params);
+    if (rc != 0) ESP_LOGW(TAG, "Connection parameter update failed: %d", rc);
 }
 
 /**
  * @brief Handles read requests for the one-wire sensor characteristic.
- * Reads one-wire sensor data and sends it in chunks based on the MTU size.
+ * Reads one-wire sensor data as JSON (or CBOR) and sends it in chunks based on the MTU size.
  * @param conn_handle Connection handle for the BLE connection.
  * @param attr_handle Attribute handle of the characteristic.
  * @param ctxt Context for the GATT access operation.
@@ -181,47 +647,31 @@ static int monitor_read(uint16_t conn_handle, uint16_t attr_handle, struct ble_g
  * @return int 0 on success, or a BLE_ATT error code on failure.
  */
 static int one_wire_read(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg) {
-    static char *one_wire_data = NULL;
-    static size_t one_wire_data_len = 0;
-    static size_t one_wire_offset = 0;
+    BleSession *session = session_find(conn_handle);
+    if (session == NULL) return BLE_ATT_ERR_UNLIKELY;
+    ReadCursor *cursor = &session->one_wire_cursor;
 
     // Load one-wire sensor data if not already loaded
-    if (one_wire_data == NULL) {
-        one_wire_data = search_for_one_wire_sensors(); // Read one-wire sensor data
-        if (one_wire_data == NULL) {
-            ESP_LOGI(TAG, "No one-wire data available");
-            return 0;
+    if (cursor->data == NULL) {
+        free(session->one_wire_json); // Document of the previous read
+        session->one_wire_json = NULL;
+        if (session->cbor) {
+            if (!scan_one_wire_sensors() || !cbor_buffer_fill(&session->one_wire_cbor, write_one_wire_sensors_cbor)) {
+                ESP_LOGI(TAG, "No one-wire data available");
+                return 0;
+            }
+            *cursor = (ReadCursor){ session->one_wire_cbor.data, session->one_wire_cbor.len, 0 };
+        } else {
+            session->one_wire_json = search_for_one_wire_sensors(); // Read one-wire sensor data
+            if (session->one_wire_json == NULL) {
+                ESP_LOGI(TAG, "No one-wire data available");
+                return 0;
+            }
+            *cursor = (ReadCursor){ (const uint8_t *)session->one_wire_json, strlen(session->one_wire_json), 0 };
         }
-        one_wire_data_len = strlen(one_wire_data);
-        one_wire_offset = 0;
-    }
-
-    // Check if all data has been sent
-    if (one_wire_offset >= one_wire_data_len) {
-        free(one_wire_data); // Free allocated memory
-        one_wire_data = NULL; 
-        one_wire_data_len = 0; 
-        one_wire_offset = 0; 
-        return 0; // Empty response signals end
-    }
-
-    // Calculate chunk size based on remaining data and MTU
-    size_t remaining = one_wire_data_len - one_wire_offset;
-    size_t chunk_size = (remaining > (ble_mtu - 3)) ? (ble_mtu - 3) : remaining;
-
-    // Append chunk to response buffer
-    int rc = os_mbuf_append(ctxt->om, &one_wire_data[one_wire_offset], chunk_size);
-    if (rc != 0) {
-        ESP_LOGE(TAG, "Failed to append one-wire data to mbuf: %d", rc);
-        free(one_wire_data); // Free memory on error
-        one_wire_data = NULL;
-        one_wire_data_len = 0;
-        one_wire_offset = 0;
-        return BLE_ATT_ERR_INSUFFICIENT_RES;
     }
 
-    one_wire_offset += chunk_size; // Update offset for next read
-    return 0;
+    return send_read_chunk(ctxt, cursor);
 }
 
 /**
@@ -254,6 +704,23 @@ static const struct ble_gatt_svc_def gatt_svcs[] = {
                 .flags = BLE_GATT_CHR_F_READ,
                 .access_cb = one_wire_read // Read one-wire sensor data
             },
+            {
+                .uuid = BLE_UUID16_DECLARE(CONFIG_ACK_CHAR_UUID),
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
+                .access_cb = config_ack_read, // Read/notify configuration transfer acknowledgements
+                .val_handle = &config_ack_handle
+            },
+            {
+                .uuid = BLE_UUID16_DECLARE(ENCODING_CHAR_UUID),
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                .access_cb = encoding_access // Select JSON or CBOR monitor frames
+            },
+            {
+                .uuid = BLE_UUID16_DECLARE(MONITOR_NOTIFY_CHAR_UUID),
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
+                .access_cb = monitor_notify_access, // Stream monitor frames
+                .val_handle = &monitor_notify_handle
+            },
             {0} // Terminator for characteristics array
         }
     },
@@ -275,6 +742,9 @@ static int ble_gap_event(struct ble_gap_event *event, void *arg) {
             conn_handle = event->connect.conn_handle;  // Store connection handle
             ESP_LOGI(TAG, "Client connected successfully");
             app_connected_ble = true; // Set BLE connection flag
+            session_open(conn_handle);
+            monitor_subscribed = false;
+            request_fast_link(conn_handle);
         } else {
             ble_app_advertise(); // Restart advertising on connection failure
         }
@@ -285,9 +755,11 @@ static int ble_gap_event(struct ble_gap_event *event, void *arg) {
             ESP_LOGI(TAG, "EVENT DISCONNECT, reason=%d, conn_handle=%d", event->disconnect.reason, event->disconnect.conn.conn_handle);
             conn_handle = BLE_HS_CONN_HANDLE_NONE;  // Reset connection handle
             app_connected_ble = false; // Clear BLE connection flag
+            monitor_subscribed = false;
         } else {
             ESP_LOGW(TAG, "Other disconnect, conn_handle: %d", conn_handle);
         }
+        session_close(event->disconnect.conn.conn_handle); // Drops the reads in progress
         ble_app_advertise(); // Restart advertising
         break;
     case BLE_GAP_EVENT_ADV_COMPLETE:
@@ -300,6 +772,14 @@ static int ble_gap_event(struct ble_gap_event *event, void *arg) {
         ESP_LOGI(TAG, "MTU updated: %d", event->mtu.value);
         ble_mtu = event->mtu.value; // Update MTU size
         break;
+    case BLE_GAP_EVENT_SUBSCRIBE:
+        // Start streaming with a keyframe when the client enables monitor notifications
+        if (event->subscribe.attr_handle == monitor_notify_handle) {
+            ESP_LOGI(TAG, "Monitor notifications %s", event->subscribe.cur_notify ? "enabled" : "disabled");
+            monitor_stream_resync = true;
+            monitor_subscribed = event->subscribe.cur_notify;
+        }
+        break;
     default:
         // Log unhandled GAP events
         ESP_LOGI(TAG, "Unhandled GAP event: %d", event->type);
@@ -395,6 +875,10 @@ static void set_ble_name_from_mac() {
  * Sets up the NimBLE host, GAP, GATT, and custom services, and starts the host task.
  */
 void ble_init(void) {
+    for (int i = 0; i < BLE_MAX_SESSIONS; i++) {
+        sessions[i].conn_handle = BLE_HS_CONN_HANDLE_NONE;
+    }
+
     // Initialize NimBLE stack
     ESP_ERROR_CHECK(nimble_port_init());
     set_ble_name_from_mac(); // Set device name based on MAC
@@ -406,4 +890,9 @@ void ble_init(void) {
 
     // Start NimBLE host task
     nimble_port_freertos_init(host_task);
+
+    // Start the monitor stream task, idle until a client subscribes
+    if (xTaskCreate(monitor_stream_task, "monitor_stream", 4096, NULL, 5, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create monitor stream task");
+    }
 }
\ No newline at end of file
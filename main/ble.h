@@ -31,24 +31,29 @@
 #define READ_ONE_WIRE_CHAR_UUID       0xFFF4
 
 /**
- * @brief Pointer to the monitor data buffer.
+ * @brief UUID for the configuration transfer acknowledgement characteristic (read/notify).
  */
-extern char *monitor_data;
+#define CONFIG_ACK_CHAR_UUID          0xFFF5
 
 /**
- * @brief Length of the monitor data buffer.
+ * @brief UUID for the monitor encoding characteristic (read/write "Json" or "Cbor").
  */
-extern size_t monitor_data_len;
+#define ENCODING_CHAR_UUID            0xFFF6
 
 /**
- * @brief Current offset in the monitor data buffer.
+ * @brief UUID for the monitor stream characteristic (notify).
  */
-extern size_t monitor_offset;
+#define MONITOR_NOTIFY_CHAR_UUID      0xFFF7
 
 /**
- * @brief Flag indicating if monitor data is being read.
+ * @brief Stream packet header flag marking the first packet of a monitor frame.
  */
-extern bool monitor_reading;
+#define MONITOR_PACKET_START          0x80
+
+/**
+ * @brief Stream packet header flag marking the last packet of a monitor frame.
+ */
+#define MONITOR_PACKET_END            0x40
 
 /**
  * @brief Flag indicating if the BLE application is connected.
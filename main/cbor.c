@@ -0,0 +1,300 @@
+#include "cbor.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "esp_log.h"
+
+/**
+ * @brief Tag for logging messages from the CBOR module.
+ */
+static const char *TAG = "CBOR";
+
+/**
+ * @brief Maximum container nesting accepted by cbor_skip.
+ */
+#define CBOR_MAX_SKIP_DEPTH 8
+
+/**
+ * @brief Appends bytes to the encoding, counting those that do not fit.
+ * @param w Pointer to the writer.
+ * @param data Bytes to append.
+ * @param len Number of bytes.
+ */
+static void put(CborWriter *w, const void *data, size_t len) {
+    if (w->buf && w->len < w->size) {
+        size_t room = w->size - w->len;
+        memcpy(w->buf + w->len, data, len < room ? len : room);
+    }
+    w->len += len;
+}
+
+/**
+ * @brief Writes an item head with the shortest argument encoding.
+ * @param w Pointer to the writer.
+ * @param major Major type.
+ * @param arg Argument value.
+ */
+static void put_head(CborWriter *w, CborMajorType major, uint64_t arg) {
+    uint8_t head[9];
+    size_t len;
+    uint8_t mt = (uint8_t)(major << 5);
+    if (arg < 24) {
+        head[0] = mt | (uint8_t)arg;
+        len = 1;
+    } else if (arg <= UINT8_MAX) {
+        head[0] = mt | 24;
+        head[1] = (uint8_t)arg;
+        len = 2;
+    } else if (arg <= UINT16_MAX) {
+        head[0] = mt | 25;
+        head[1] = (uint8_t)(arg >> 8);
+        head[2] = (uint8_t)arg;
+        len = 3;
+    } else if (arg <= UINT32_MAX) {
+        head[0] = mt | 26;
+        for (int i = 0; i < 4; i++) head[1 + i] = (uint8_t)(arg >> (24 - 8 * i));
+        len = 5;
+    } else {
+        head[0] = mt | 27;
+        for (int i = 0; i < 8; i++) head[1 + i] = (uint8_t)(arg >> (56 - 8 * i));
+        len = 9;
+    }
+    put(w, head, len);
+}
+
+void cbor_writer_init(CborWriter *w, uint8_t *buf, size_t size) {
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+}
+
+size_t cbor_writer_finish(const CborWriter *w) {
+    return w->len;
+}
+
+void cbor_write_uint(CborWriter *w, uint64_t value) {
+    put_head(w, CBOR_MAJOR_UINT, value);
+}
+
+void cbor_write_int(CborWriter *w, int64_t value) {
+    if (value >= 0) put_head(w, CBOR_MAJOR_UINT, (uint64_t)value);
+    else put_head(w, CBOR_MAJOR_NINT, (uint64_t)(-1 - value));
+}
+
+void cbor_write_number(CborWriter *w, double value) {
+    // Integral values in the int64 range are encoded as integers
+    if (value == floor(value) && value >= -9223372036854775808.0 && value < 9223372036854775808.0) {
+        cbor_write_int(w, (int64_t)value);
+        return;
+    }
+
+    // Single precision when it round-trips, double precision otherwise (NaN and infinities included)
+    float single = (float)value;
+    if ((double)single == value || isnan(value)) {
+        uint32_t bits;
+        memcpy(&bits, &single, sizeof(bits));
+        uint8_t out[5] = { 0xFA, (uint8_t)(bits >> 24), (uint8_t)(bits >> 16), (uint8_t)(bits >> 8), (uint8_t)bits };
+        put(w, out, sizeof(out));
+    } else {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint8_t out[9] = { 0xFB };
+        for (int i = 0; i < 8; i++) out[1 + i] = (uint8_t)(bits >> (56 - 8 * i));
+        put(w, out, sizeof(out));
+    }
+}
+
+void cbor_write_bool(CborWriter *w, bool value) {
+    uint8_t out = value ? 0xF5 : 0xF4;
+    put(w, &out, 1);
+}
+
+void cbor_write_text(CborWriter *w, const char *str) {
+    size_t len = str ? strlen(str) : 0;
+    put_head(w, CBOR_MAJOR_TEXT, len);
+    if (len) put(w, str, len);
+}
+
+void cbor_write_array(CborWriter *w, size_t count) {
+    put_head(w, CBOR_MAJOR_ARRAY, count);
+}
+
+void cbor_write_map(CborWriter *w, size_t count) {
+    put_head(w, CBOR_MAJOR_MAP, count);
+}
+
+void cbor_write_map_indefinite(CborWriter *w) {
+    uint8_t out = (CBOR_MAJOR_MAP << 5) | 31;
+    put(w, &out, 1);
+}
+
+void cbor_write_break(CborWriter *w) {
+    uint8_t out = 0xFF;
+    put(w, &out, 1);
+}
+
+bool cbor_buffer_fill(CborBuffer *cb, CborWriteFn write) {
+    size_t len = write(cb->data, cb->capacity);
+    if (len == 0) return false;
+
+    if (len > cb->capacity) {
+        // Grow with headroom so small fluctuations do not reallocate again
+        size_t capacity = len + len / 4;
+        uint8_t *data = realloc(cb->data, capacity);
+        if (!data) {
+            ESP_LOGE(TAG, "Failed to grow CBOR buffer to %u bytes", (unsigned)capacity);
+            return false;
+        }
+        cb->data = data;
+        cb->capacity = capacity;
+        len = write(cb->data, cb->capacity);
+        if (len == 0 || len > cb->capacity) return false;
+    }
+    cb->len = len;
+    return true;
+}
+
+void cbor_reader_init(CborReader *r, const uint8_t *data, size_t len) {
+    r->data = data;
+    r->len = len;
+    r->pos = 0;
+    r->failed = false;
+}
+
+bool cbor_read_head(CborReader *r, CborMajorType *major, uint64_t *arg) {
+    if (r->failed || r->pos >= r->len) {
+        r->failed = true;
+        return false;
+    }
+    uint8_t initial = r->data[r->pos++];
+    *major = (CborMajorType)(initial >> 5);
+    uint8_t info = initial & 0x1F;
+
+    // Indefinite lengths and reserved values are not accepted
+    size_t extra = info < 24 ? 0 : info == 24 ? 1 : info == 25 ? 2 : info == 26 ? 4 : info == 27 ? 8 : SIZE_MAX;
+    if (extra == SIZE_MAX || r->len - r->pos < extra) {
+        r->failed = true;
+        return false;
+    }
+    uint64_t value = extra ? 0 : info;
+    for (size_t i = 0; i < extra; i++) {
+        value = (value << 8) | r->data[r->pos++];
+    }
+    *arg = value;
+    return true;
+}
+
+bool cbor_read_text(CborReader *r, const char **str, size_t *len) {
+    CborMajorType major;
+    uint64_t arg;
+    if (!cbor_read_head(r, &major, &arg)) return false;
+    if (major != CBOR_MAJOR_TEXT || arg > r->len - r->pos) {
+        r->failed = true;
+        return false;
+    }
+    *str = (const char *)&r->data[r->pos];
+    *len = (size_t)arg;
+    r->pos += (size_t)arg;
+    return true;
+}
+
+bool cbor_read_scalar(CborReader *r, double *number, bool *is_bool) {
+    size_t start = r->pos;
+    CborMajorType major;
+    uint64_t arg;
+    if (!cbor_read_head(r, &major, &arg)) return false;
+    *is_bool = false;
+
+    switch (major) {
+        case CBOR_MAJOR_UINT:
+            *number = (double)arg;
+            return true;
+        case CBOR_MAJOR_NINT:
+            *number = -1.0 - (double)arg;
+            return true;
+        case CBOR_MAJOR_SIMPLE: {
+            uint8_t info = r->data[start] & 0x1F;
+            if (info == 20 || info == 21) {
+                *is_bool = true;
+                *number = info == 21;
+                return true;
+            } else if (info == 25) {
+                // Half precision: 1 sign, 5 exponent and 10 mantissa bits
+                int exponent = (int)(arg >> 10) & 0x1F;
+                double mantissa = (double)(arg & 0x3FF);
+                double magnitude = exponent == 0 ? ldexp(mantissa, -24)
+                                 : exponent == 31 ? (mantissa ? NAN : INFINITY)
+                                 : ldexp(mantissa + 1024, exponent - 25);
+                *number = (arg & 0x8000) ? -magnitude : magnitude;
+                return true;
+            } else if (info == 26) {
+                uint32_t bits = (uint32_t)arg;
+                float single;
+                memcpy(&single, &bits, sizeof(single));
+                *number = single;
+                return true;
+            } else if (info == 27) {
+                memcpy(number, &arg, sizeof(*number));
+                return true;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    // Not a scalar: rewind so the caller can skip the item
+    r->pos = start;
+    return false;
+}
+
+/**
+ * @brief Skips the next item, tracking the nesting depth.
+ * @param r Pointer to the reader.
+ * @param depth Current nesting depth.
+ * @return bool True on success, false otherwise.
+ */
+static bool skip_item(CborReader *r, int depth) {
+    CborMajorType major;
+    uint64_t arg;
+    if (depth > CBOR_MAX_SKIP_DEPTH || !cbor_read_head(r, &major, &arg)) {
+        r->failed = true;
+        return false;
+    }
+    switch (major) {
+        case CBOR_MAJOR_BYTES:
+        case CBOR_MAJOR_TEXT:
+            if (arg > r->len - r->pos) {
+                r->failed = true;
+                return false;
+            }
+            r->pos += (size_t)arg;
+            return true;
+        case CBOR_MAJOR_MAP:
+            // A map holds twice as many items as pairs; guard the doubling against overflow
+            if (arg > (r->len - r->pos)) {
+                r->failed = true;
+                return false;
+            }
+            arg *= 2;
+            // fall through
+        case CBOR_MAJOR_ARRAY:
+            // Every item takes at least one byte, larger counts cannot be valid
+            if (arg > r->len - r->pos) {
+                r->failed = true;
+                return false;
+            }
+            for (uint64_t i = 0; i < arg; i++) {
+                if (!skip_item(r, depth + 1)) return false;
+            }
+            return true;
+        case CBOR_MAJOR_TAG:
+            return skip_item(r, depth + 1);
+        default:
+            return true;
+    }
+}
+
+bool cbor_skip(CborReader *r) {
+    return skip_item(r, 0);
+}
@@ -0,0 +1,188 @@
+#ifndef CBOR_H
+#define CBOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief CBOR major types (RFC 8949).
+ */
+typedef enum {
+    CBOR_MAJOR_UINT = 0,    ///< Unsigned integer.
+    CBOR_MAJOR_NINT = 1,    ///< Negative integer (-1 - n).
+    CBOR_MAJOR_BYTES = 2,   ///< Byte string.
+    CBOR_MAJOR_TEXT = 3,    ///< UTF-8 text string.
+    CBOR_MAJOR_ARRAY = 4,   ///< Array.
+    CBOR_MAJOR_MAP = 5,     ///< Map.
+    CBOR_MAJOR_TAG = 6,     ///< Tagged item.
+    CBOR_MAJOR_SIMPLE = 7   ///< Simple values and floats.
+} CborMajorType;
+
+/**
+ * @brief Streaming CBOR encoder writing into a caller-provided buffer.
+ *
+ * Like JsonWriter, the encoder keeps counting once the buffer is full, so the
+ * length returned by cbor_writer_finish tells how much space the item needs.
+ */
+typedef struct {
+    uint8_t *buf;  ///< Output buffer, may be NULL to only measure.
+    size_t size;   ///< Size of the output buffer in bytes.
+    size_t len;    ///< Length of the encoding so far, including bytes that did not fit.
+} CborWriter;
+
+/**
+ * @brief Grow-only heap buffer reused between encodings.
+ */
+typedef struct {
+    uint8_t *data;    ///< Encoded item, or NULL before the first fill.
+    size_t capacity;  ///< Allocated size of data in bytes.
+    size_t len;       ///< Length of the last encoding.
+} CborBuffer;
+
+/**
+ * @brief Function encoding an item into a buffer, returning the full length like snprintf.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return size_t Length of the full encoding, or 0 if there is nothing to write.
+ */
+typedef size_t (*CborWriteFn)(uint8_t *buf, size_t size);
+
+/**
+ * @brief Minimal CBOR decoder over a received buffer; failures are sticky.
+ */
+typedef struct {
+    const uint8_t *data;  ///< Encoded data.
+    size_t len;           ///< Length of the data in bytes.
+    size_t pos;           ///< Current read position.
+    bool failed;          ///< True once the data was found malformed or truncated.
+} CborReader;
+
+/**
+ * @brief Starts an encoding in the given buffer.
+ * @param w Pointer to the writer.
+ * @param buf Output buffer, or NULL to only measure.
+ * @param size Size of the output buffer.
+ */
+void cbor_writer_init(CborWriter *w, uint8_t *buf, size_t size);
+
+/**
+ * @brief Returns the length of the encoding.
+ * @param w Pointer to the writer.
+ * @return size_t Length of the full encoding; it was truncated if this is > the buffer size.
+ */
+size_t cbor_writer_finish(const CborWriter *w);
+
+/**
+ * @brief Writes an unsigned integer.
+ * @param w Pointer to the writer.
+ * @param value Value to write.
+ */
+void cbor_write_uint(CborWriter *w, uint64_t value);
+
+/**
+ * @brief Writes a signed integer.
+ * @param w Pointer to the writer.
+ * @param value Value to write.
+ */
+void cbor_write_int(CborWriter *w, int64_t value);
+
+/**
+ * @brief Writes a number in its smallest exact form (integer, single or double precision).
+ * @param w Pointer to the writer.
+ * @param value Value to write.
+ */
+void cbor_write_number(CborWriter *w, double value);
+
+/**
+ * @brief Writes a boolean.
+ * @param w Pointer to the writer.
+ * @param value Value to write.
+ */
+void cbor_write_bool(CborWriter *w, bool value);
+
+/**
+ * @brief Writes a text string; NULL is written as an empty string.
+ * @param w Pointer to the writer.
+ * @param str NUL-terminated string.
+ */
+void cbor_write_text(CborWriter *w, const char *str);
+
+/**
+ * @brief Opens an array of known length.
+ * @param w Pointer to the writer.
+ * @param count Number of elements that follow.
+ */
+void cbor_write_array(CborWriter *w, size_t count);
+
+/**
+ * @brief Opens a map of known length.
+ * @param w Pointer to the writer.
+ * @param count Number of key/value pairs that follow.
+ */
+void cbor_write_map(CborWriter *w, size_t count);
+
+/**
+ * @brief Opens a map of unknown length, closed with cbor_write_break.
+ * @param w Pointer to the writer.
+ */
+void cbor_write_map_indefinite(CborWriter *w);
+
+/**
+ * @brief Closes an indefinite-length container.
+ * @param w Pointer to the writer.
+ */
+void cbor_write_break(CborWriter *w);
+
+/**
+ * @brief Encodes an item into a reusable buffer, growing it once if the item does not fit.
+ * @param cb Pointer to the buffer; cb->data and cb->len hold the item on success.
+ * @param write Function encoding the item.
+ * @return bool True if a non-empty item was written, false if there was nothing to write or on allocation failure.
+ */
+bool cbor_buffer_fill(CborBuffer *cb, CborWriteFn write);
+
+/**
+ * @brief Starts decoding a buffer.
+ * @param r Pointer to the reader.
+ * @param data Encoded data.
+ * @param len Length of the data in bytes.
+ */
+void cbor_reader_init(CborReader *r, const uint8_t *data, size_t len);
+
+/**
+ * @brief Reads the head of the next item.
+ * @param r Pointer to the reader.
+ * @param major Pointer to store the major type.
+ * @param arg Pointer to store the argument (length, count or value; simple value for major type 7).
+ * @return bool True on success, false if the data is malformed or truncated.
+ */
+bool cbor_read_head(CborReader *r, CborMajorType *major, uint64_t *arg);
+
+/**
+ * @brief Reads a text string without copying it.
+ * @param r Pointer to the reader.
+ * @param str Pointer to store the start of the string (not NUL-terminated).
+ * @param len Pointer to store the string length.
+ * @return bool True on success, false if the next item is not a definite-length text string.
+ */
+bool cbor_read_text(CborReader *r, const char **str, size_t *len);
+
+/**
+ * @brief Reads a scalar value as a number or boolean.
+ * @param r Pointer to the reader.
+ * @param number Pointer to store the value (booleans read as 0/1).
+ * @param is_bool Pointer to store whether the item was a boolean.
+ * @return bool True on success, false if the next item is not a number or boolean
+ *              (the reader then stays at the item, unless the data is malformed).
+ */
+bool cbor_read_scalar(CborReader *r, double *number, bool *is_bool);
+
+/**
+ * @brief Skips the next item, including nested definite-length containers.
+ * @param r Pointer to the reader.
+ * @return bool True on success, false if the data is malformed, truncated or nested too deeply.
+ */
+bool cbor_skip(CborReader *r);
+
+#endif // CBOR_H
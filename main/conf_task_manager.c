@@ -9,7 +9,11 @@
 #include "nvs_utils.h"
 #include "device_config.h"
 #include "variables.h"
-#include "ladder_elements.h"
+#include "ladder_program.h"
+#include "scan_cycle.h"
+#include "arena.h"
+#include "json_stream.h"
+#include "config_image.h"
 
 /**
  * @brief Tag for logging messages from the configuration task manager module.
@@ -37,22 +41,57 @@ static char *large_buffer = NULL;
 static size_t total_received = 0;
 
 /**
- * @brief Structure to store task information.
+ * @brief Allocated size of large_buffer in bytes.
+ */
+static size_t buffer_capacity = 0;
+
+/**
+ * @brief Structural scanner detecting when the received document is complete.
+ */
+static JsonStream config_stream = {0};
+
+/**
+ * @brief Frees the receive buffer and resets the document scanner.
+ */
+static void reset_config_buffer(void) {
+    free(large_buffer);
+    large_buffer = NULL;
+    total_received = 0;
+    buffer_capacity = 0;
+    json_stream_reset(&config_stream);
+}
+
+/**
+ * @brief Growth of config_arena past its footprint after a full load beyond which a change is applied with a full load.
+ *
+ * Incremental changes leave the replaced rungs and variables in the arena until it is reset.
+ */
+#define INCREMENTAL_ARENA_FACTOR 2
+
+/**
+ * @brief Fingerprints of the applied configuration, used to find what a new one changes.
  */
 typedef struct {
-    TaskHandle_t handle; ///< Handle of the FreeRTOS task.
-    cJSON *wire_copy;   ///< Copy of the JSON wire configuration.
-} TaskInfo;
+    bool valid;             ///< The scan cycle runs the configuration described here.
+    uint64_t device;        ///< json_fingerprint of the Device section.
+    uint64_t variables;     ///< json_fingerprint of the Variables section.
+    size_t arena_used;      ///< config_arena footprint right after the last full load.
+} AppliedConfig;
 
 /**
- * @brief Array of task information structures.
+ * @brief Compiled ladder programs; a changed configuration is compiled into the one not being scanned.
  */
-static TaskInfo *tasks = NULL;
+static LadderProgram programs[2] = {0};
 
 /**
- * @brief Number of tasks currently managed.
+ * @brief Compiled ladder program executed by the scan cycle.
  */
-static int num_tasks = 0;
+static LadderProgram *program = &programs[0];
+
+/**
+ * @brief Fingerprints of the running configuration.
+ */
+static AppliedConfig applied = {0};
 
 /**
  * @brief Callback function for configuration timeout.
@@ -61,367 +100,284 @@ static int num_tasks = 0;
 static void config_timeout_callback(TimerHandle_t xTimer) {
     // Log warning and clear buffer on timeout
     ESP_LOGW(TAG, "Configuration timeout - clearing buffer");
-    if (large_buffer) {
-        free(large_buffer);
-        large_buffer = NULL;
-        total_received = 0;
+    reset_config_buffer();
+}
+
+/**
+ * @brief Device and Variables sections of the image as configured, after a reserved image header.
+ *
+ * Captured before the scan cycle changes any variable, so the image never holds runtime state.
+ */
+static ImageWriter configured_sections = {0};
+
+/**
+ * @brief Replaces the configured sections kept for the image.
+ * @param sections Writer holding the new sections; ownership of its buffer moves here.
+ */
+static void keep_configured_sections(ImageWriter *sections) {
+    free(configured_sections.data);
+    configured_sections = *sections;
+    memset(sections, 0, sizeof(*sections));
+}
+
+/**
+ * @brief Captures the configured sections from the loaded device and variables.
+ *
+ * Only valid before the scan cycle starts, while the variables still hold their configured values.
+ */
+static void capture_configured_sections(void) {
+    ImageWriter sections;
+    image_writer_begin(&sections);
+    device_config_write_image(&sections);
+    variables_write_image(&sections);
+    keep_configured_sections(&sections);
+}
+
+/**
+ * @brief Serializes the configuration and stores it in NVS for fast boot.
+ * @param compiled Program to store with the configured sections.
+ */
+static void save_config_image(const LadderProgram *compiled) {
+    if (configured_sections.failed || !configured_sections.data) {
+        // Log error; the next boot falls back to the JSON configuration
+        ESP_LOGE(TAG, "No configured sections to build the configuration image from");
+        return;
+    }
+    ImageWriter writer;
+    image_writer_begin(&writer);
+    image_write_bytes(&writer, configured_sections.data + sizeof(ConfigImageHeader),
+                      configured_sections.len - sizeof(ConfigImageHeader));
+    ladder_program_write_image(compiled, &writer);
+    // Fingerprints of the source sections, so a change after booting from the image is incremental
+    image_write_u64(&writer, applied.device);
+    image_write_u64(&writer, applied.variables);
+    if (!image_writer_finish(&writer)) {
+        // Log error; the next boot falls back to the JSON configuration
+        ESP_LOGE(TAG, "Failed to build configuration image");
+        return;
     }
+    save_config_image_to_nvs(writer.data, writer.len);
+    free(writer.data);
 }
 
-// Forward declarations
-static bool process_node(cJSON *node, bool *condition);
-static bool process_nodes(cJSON *nodes, bool *condition, cJSON **last_coil);
-static void process_coil(cJSON *node, bool condition);
+/**
+ * @brief Deletes all tasks and cleans up associated resources.
+ */
+void delete_all_tasks(void) {
+    // Stop timeout timer if it exists
+    if (config_timeout_timer) {
+        xTimerStop(config_timeout_timer, portMAX_DELAY);
+        xTimerDelete(config_timeout_timer, portMAX_DELAY);
+        config_timeout_timer = NULL;
+    }
+
+    // Free large_buffer if it exists
+    reset_config_buffer();
+
+    // Stop the scan cycle
+    scan_cycle_stop();
+
+    // Free compiled program once the scan cycle no longer references it
+    ladder_program_free(program);
+    applied.valid = false;
+}
 
 /**
- * @brief Processes a single ladder node (excluding Coil nodes).
- * @param node JSON object representing the node.
- * @param condition Pointer to the current condition state.
- * @return bool Updated condition state or false on error.
+ * @brief Applies a configuration with an unchanged Device section without tearing down the running one.
+ *
+ * If only the wires changed, the new program is compiled while the scan cycle keeps running and
+ * swapped in between two scans; unchanged rungs are reused with their edge states. If the
+ * variables changed, the scan cycle pauses while they are reloaded in place, keeping the sensor
+ * tasks and the state of the variables that still exist.
+ * @param device_fp Fingerprint of the new Device section.
+ * @param variables_fp Fingerprint of the new Variables section.
+ * @param variables New Variables array.
+ * @param wires New Wires array.
+ * @return bool True if the change was applied, false if a full load is needed.
  */
-static bool process_node(cJSON *node, bool *condition) {
-    if (!node || !condition || !cJSON_IsObject(node)) {
-        // Log error for invalid node or condition
-        ESP_LOGE(TAG, "Invalid node or condition");
+static bool apply_incremental(uint64_t device_fp, uint64_t variables_fp, cJSON *variables, cJSON *wires) {
+    if (!applied.valid || device_fp != applied.device || !cJSON_IsArray(wires)) {
         return false;
     }
-
-    cJSON *type = cJSON_GetObjectItem(node, "Type");
-    if (!cJSON_IsString(type)) {
-        // Log error if node type is missing or invalid
-        ESP_LOGE(TAG, "Node missing Type or Type is not a string");
+    if (config_arena.total_used > INCREMENTAL_ARENA_FACTOR * applied.arena_used) {
+        // Log info; the full load releases what earlier incremental changes left behind
+        ESP_LOGI(TAG, "Reclaiming configuration memory with a full load");
         return false;
     }
 
-    if (strcmp(type->valuestring, "LadderElement") == 0) {
-        cJSON *element_type = cJSON_GetObjectItem(node, "ElementType");
-        cJSON *combo_values = cJSON_GetObjectItem(node, "ComboBoxValues");
-
-        if (!cJSON_IsString(element_type) || !cJSON_IsArray(combo_values)) {
-            // Log error if LadderElement is missing required fields
-            ESP_LOGE(TAG, "LadderElement missing ElementType or ComboBoxValues");
+    LadderProgram *next = program == &programs[0] ? &programs[1] : &programs[0];
+    if (variables_fp == applied.variables) {
+        // Only wires changed: the scan cycle keeps running the current program until the swap
+        if (!ladder_program_update(wires, program, false, next)) {
+            ladder_program_free(next);
             return false;
         }
-
-        // Get arguments from ComboBoxValues
-        cJSON *arg1 = cJSON_GetArrayItem(combo_values, 0);
-        cJSON *arg2 = cJSON_GetArrayItem(combo_values, 1);
-        cJSON *arg3 = cJSON_GetArrayItem(combo_values, 2);
-
-        const char *var1 = (arg1 && cJSON_IsString(arg1)) ? arg1->valuestring : NULL;
-        const char *var2 = (arg2 && cJSON_IsString(arg2)) ? arg2->valuestring : NULL;
-        const char *var3 = (arg3 && cJSON_IsString(arg3)) ? arg3->valuestring : NULL;
-
-        // Handle Contacts and Comparisons
-        if (strcmp(element_type->valuestring, "NOContact") == 0 && var1) {
-            bool result = no_contact(var1);
-            ESP_LOGD(TAG, "NOContact(%s) = %d", var1, result);
-            *condition &= result;
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "NCContact") == 0 && var1) {
-            bool result = nc_contact(var1);
-            ESP_LOGD(TAG, "NCContact(%s) = %d", var1, result);
-            *condition &= result;
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "GreaterCompare") == 0 && var1 && var2) {
-            bool result = greater(var1, var2);
-            ESP_LOGD(TAG, "GreaterCompare(%s, %s) = %d", var1, var2, result);
-            *condition &= result;
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "LessCompare") == 0 && var1 && var2) {
-            bool result = less(var1, var2);
-            ESP_LOGD(TAG, "LessCompare(%s, %s) = %d", var1, var2, result);
-            *condition &= result;
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "GreaterOrEqualCompare") == 0 && var1 && var2) {
-            bool result = greater_or_equal(var1, var2);
-            ESP_LOGD(TAG, "GreaterOrEqualCompare(%s, %s) = %d", var1, var2, result);
-            *condition &= result;
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "LessOrEqualCompare") == 0 && var1 && var2) {
-            bool result = less_or_equal(var1, var2);
-            ESP_LOGD(TAG, "LessOrEqualCompare(%s, %s) = %d", var1, var2, result);
-            *condition &= result;
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "EqualCompare") == 0 && var1 && var2) {
-            bool result = equal(var1, var2);
-            ESP_LOGD(TAG, "EqualCompare(%s, %s) = %d", var1, var2, result);
-            *condition &= result;
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "NotEqualCompare") == 0 && var1 && var2) {
-            bool result = not_equal(var1, var2);
-            ESP_LOGD(TAG, "NotEqualCompare(%s, %s) = %d", var1, var2, result);
-            *condition &= result;
-            return *condition;
-        }
-        // Actions executed immediately if condition is true
-        else if (strcmp(element_type->valuestring, "AddMath") == 0 && var1 && var2 && var3) {
-            add(var1, var2, var3, *condition);
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "SubtractMath") == 0 && var1 && var2 && var3) {
-            subtract(var1, var2, var3, *condition);
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "MultiplyMath") == 0 && var1 && var2 && var3) {
-            multiply(var1, var2, var3, *condition);
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "DivideMath") == 0 && var1 && var2 && var3) {
-            divide(var1, var2, var3, *condition);
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "MoveMath") == 0 && var1 && var2) {
-            move(var1, var2, *condition);
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "CountUp") == 0 && var1) {
-            count_up(var1, *condition);
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "CountDown") == 0 && var1) {
-            count_down(var1, *condition);
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "OnDelayTimer") == 0 && var1) {
-            bool result = timer_on(var1, *condition);
-            *condition &= result;
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "OffDelayTimer") == 0 && var1) {
-            bool result = timer_off(var1, *condition);
-            // Note: Uses = instead of &= because this timer sets true regardless of prior elements
-            *condition = result;
-            return *condition;
-        } else if (strcmp(element_type->valuestring, "Reset") == 0 && var1) {
-            reset(var1, *condition);
-            return *condition;
-        }
-        return *condition; // Unknown element doesn't change condition
-    } else if (strcmp(type->valuestring, "Branch") == 0) {
-        cJSON *nodes1 = cJSON_GetObjectItem(node, "Nodes1");
-        cJSON *nodes2 = cJSON_GetObjectItem(node, "Nodes2");
-
-        if (!cJSON_IsArray(nodes1) || !cJSON_IsArray(nodes2)) {
-            // Log error if Branch is missing required node arrays
-            ESP_LOGE(TAG, "Branch missing Nodes1 or Nodes2 arrays");
+        save_config_image(next);
+        if (scan_cycle_swap(next) != ESP_OK) {
+            ladder_program_free(next);
             return false;
         }
-
-        bool nodes1_condition = true; // Independent condition for Nodes1
-        bool nodes2_condition = true; // Independent condition for Nodes2
-        cJSON *nodes1_last_coil = NULL;
-        cJSON *nodes2_last_coil = NULL;
-
-        // Process both branches
-        bool nodes1_active = process_nodes(nodes1, &nodes1_condition, &nodes1_last_coil);
-        bool nodes2_active = process_nodes(nodes2, &nodes2_condition, &nodes2_last_coil);
-
-        // Log branch conditions
-        ESP_LOGD(TAG, "Branch: Nodes1_active=%d (cond=%d), Nodes2_active=%d (cond=%d)", 
-                 nodes1_active, nodes1_condition, nodes2_active, nodes2_condition);
-
-        // OR logic: at least one branch must be active
-        bool branch_condition = nodes1_active || nodes2_active;
-        *condition &= branch_condition;
-
-        // Process coils only if present (shouldn't be in this JSON, but handle for robustness)
-        if (nodes1_last_coil && nodes1_condition) {
-            // Log warning for unexpected coil in Nodes1
-            ESP_LOGW(TAG, "Unexpected coil in Nodes1");
-            process_coil(nodes1_last_coil, nodes1_condition);
+    } else {
+        // Handle indices change with the variables, so no scan may run during the reload
+        scan_cycle_stop();
+        applied.valid = false;
+        ImageWriter sections;
+        image_writer_begin(&sections);
+        device_config_write_image(&sections);
+        if (!reload_variables(variables, &sections) || !ladder_program_update(wires, program, true, next)) {
+            // Log error; the full load starts over from an empty arena
+            ESP_LOGE(TAG, "Failed to reload variables in place");
+            free(sections.data);
+            ladder_program_free(next);
+            return false;
         }
-        if (nodes2_last_coil && nodes2_condition) {
-            // Log warning for unexpected coil in Nodes2
-            ESP_LOGW(TAG, "Unexpected coil in Nodes2");
-            process_coil(nodes2_last_coil, nodes2_condition);
+        keep_configured_sections(&sections);
+        applied.variables = variables_fp;
+        save_config_image(next);
+        if (scan_cycle_start(next, _device.scan_period_ms) != ESP_OK) {
+            // Log error; the full load starts over from an empty arena
+            ESP_LOGE(TAG, "Failed to restart the scan cycle");
+            ladder_program_free(next);
+            return false;
         }
-
-        return *condition;
+        applied.valid = true;
     }
 
-    // Log warning for unknown node type
-    ESP_LOGW(TAG, "Unknown node type: %s", type->valuestring);
-    return false;
+    // The previous program is no longer scanned; its memory goes with the next full load
+    ladder_program_free(program);
+    program = next;
+    ESP_LOGI(TAG, "Applied configuration change in place: %zu wires", program->rung_count);
+    return true;
 }
 
-/**
- * @brief Processes an array of ladder nodes, identifying the last coil if present.
- * @param nodes JSON array of nodes.
- * @param condition Pointer to the current condition state.
- * @param last_coil Pointer to store the last coil node, if any.
- * @return bool Updated condition state or false if the node list is empty or invalid.
- */
-static bool process_nodes(cJSON *nodes, bool *condition, cJSON **last_coil) {
-    if (!nodes || !cJSON_IsArray(nodes) || !condition || !last_coil) {
-        // Log error for invalid nodes array or parameters
-        ESP_LOGE(TAG, "Invalid nodes array or parameters");
-        return false;
+bool configure_document(const char *data, size_t data_len, bool loaded_from_nvs) {
+    // Stop timeout timer, the document is complete
+    if (config_timeout_timer) {
+        xTimerStop(config_timeout_timer, portMAX_DELAY);
     }
 
-    *last_coil = NULL;
-    bool all_conditions_met = *condition;
-    int node_count = cJSON_GetArraySize(nodes);
-
-    if (node_count == 0) {
-        // Empty node list
+    cJSON *json = cJSON_ParseWithLength(data, data_len);
+    if (!json) {
+        // Log error if the document is not valid JSON
+        ESP_LOGE(TAG, "Invalid JSON configuration, length: %zu bytes", data_len);
         return false;
     }
 
-    // Check if the last node is a coil
-    cJSON *last_node = cJSON_GetArrayItem(nodes, node_count - 1);
-    cJSON *last_type = cJSON_GetObjectItem(last_node, "Type");
-    cJSON *last_element_type = cJSON_GetObjectItem(last_node, "ElementType");
-
-    if (last_type && cJSON_IsString(last_type) && 
-        strcmp(last_type->valuestring, "LadderElement") == 0 &&
-        last_element_type && cJSON_IsString(last_element_type) &&
-        (strcmp(last_element_type->valuestring, "Coil") == 0 ||
-         strcmp(last_element_type->valuestring, "OneShotPositiveCoil") == 0 ||
-         strcmp(last_element_type->valuestring, "SetCoil") == 0 ||
-         strcmp(last_element_type->valuestring, "ResetCoil") == 0)) {
-        *last_coil = last_node;
-        node_count--; // Exclude the coil from condition processing
-    }
+    // JSON is valid, complete message received
+    ESP_LOGI(TAG, "Complete JSON received, length: %zu bytes", data_len);
 
-    // Process all nodes except the last coil (if it was a coil)
-    for (int i = 0; i < node_count; i++) {
-        cJSON *node = cJSON_GetArrayItem(nodes, i);
-        all_conditions_met = process_node(node, &all_conditions_met);
+    // Save to NVS; drop the stale compiled image first so it never outlives its JSON
+    if(!loaded_from_nvs) {
+        delete_config_image_from_nvs();
+        delete_config_from_nvs();
+        save_config_to_nvs(data, data_len);
     }
 
-    *condition = all_conditions_met;
-    // Log processed nodes condition
-    ESP_LOGD(TAG, "Nodes processed, condition=%d", *condition);
-    return all_conditions_met;
-}
-
-/**
- * @brief Processes a Coil node.
- * @param node JSON object representing the coil node.
- * @param condition Current condition state.
- */
-static void process_coil(cJSON *node, bool condition) {
-    if (!node || !cJSON_IsObject(node)) {
-        // Log error for invalid coil node
-        ESP_LOGE(TAG, "Invalid coil node");
-        return;
+    // Keep the running configuration if the device is unchanged
+    cJSON *device = cJSON_GetObjectItem(json, "Device");
+    cJSON *variables = cJSON_GetObjectItem(json, "Variables");
+    cJSON *wires = cJSON_GetObjectItem(json, "Wires");
+    uint64_t device_fp = json_fingerprint(device);
+    uint64_t variables_fp = json_fingerprint(variables);
+    if (apply_incremental(device_fp, variables_fp, variables, wires)) {
+        reset_config_buffer();
+        cJSON_Delete(json);
+        return true;
     }
 
-    cJSON *type = cJSON_GetObjectItem(node, "Type");
-    if (!cJSON_IsString(type) || strcmp(type->valuestring, "LadderElement") != 0) {
-        // Log error if coil is not a LadderElement
-        ESP_LOGE(TAG, "Coil node is not a LadderElement");
-        return;
-    }
+    // Delete all previous tasks
+    delete_all_tasks();
 
-    cJSON *element_type = cJSON_GetObjectItem(node, "ElementType");
-    cJSON *combo_values = cJSON_GetObjectItem(node, "ComboBoxValues");
+    // Release the previous configuration generation in one step
+    unload_variables();
+    arena_reset(&config_arena);
 
-    if (!cJSON_IsString(element_type) || !cJSON_IsArray(combo_values)) {
-        // Log error if coil is missing required fields
-        ESP_LOGE(TAG, "Coil missing ElementType or ComboBoxValues");
-        return;
-    }
+    // Get Device data
+    device_init(device);
+    print_device_info();
 
-    cJSON *arg1 = cJSON_GetArrayItem(combo_values, 0);
-    const char *var1 = (arg1 && cJSON_IsString(arg1)) ? arg1->valuestring : NULL;
-
-    if (var1) {
-        if (strcmp(element_type->valuestring, "Coil") == 0) {
-            // Log and process standard coil
-            ESP_LOGD(TAG, "Coil(%s, %d)", var1, condition);
-            coil(var1, condition);
-        } else if (strcmp(element_type->valuestring, "OneShotPositiveCoil") == 0) {
-            // Log and process one-shot positive coil
-            ESP_LOGD(TAG, "OneShotPositiveCoil(%s, %d)", var1, condition);
-            one_shot_positive_coil(var1, condition);
-        } else if (strcmp(element_type->valuestring, "SetCoil") == 0) {
-            // Log and process set coil
-            ESP_LOGD(TAG, "SetCoil(%s, %d)", var1, condition);
-            set_coil(var1, condition);
-        } else if (strcmp(element_type->valuestring, "ResetCoil") == 0) {
-            // Log and process reset coil
-            ESP_LOGD(TAG, "ResetCoil(%s, %d)", var1, condition);
-            reset_coil(var1, condition);
-        } else {
-            // Log warning for unknown coil type
-            ESP_LOGW(TAG, "Unknown coil type: %s", element_type->valuestring);
-        }
-    } else {
-        // Log error if coil is missing variable name
-        ESP_LOGE(TAG, "Coil missing variable name");
-    }
-}
+    // Get variables
+    load_variables(variables);
 
-/**
- * @brief Main task function to process a wire (ladder logic block).
- * @param pvParameters Pointer to the JSON wire configuration.
- */
-static void process_block_task(void *pvParameters) {
-    cJSON *wire = (cJSON *)pvParameters;
-
-    // Get Nodes
-    cJSON *nodes = cJSON_GetObjectItem(wire, "Nodes");
-    if (!nodes || !cJSON_IsArray(nodes)) {
-        // Log error and clean up if Nodes array is invalid
-        ESP_LOGE(TAG, "Invalid or missing Nodes array in wire");
-        cJSON_Delete(wire);
-        vTaskDelete(NULL);
-        return;
+    if (!cJSON_IsArray(wires)) {
+        // Log error and clean up if Wires is not an array
+        ESP_LOGE(TAG, "Wires is not an array");
+        cJSON_Delete(json);
+        return false;
     }
 
-    while (1) {
-        bool condition = true;
-        cJSON *last_coil = NULL;
+    // Compile all wires into instruction streams once
+    if (!ladder_program_compile(wires, program)) {
+        // Log error and clean up if compilation fails
+        ESP_LOGE(TAG, "Failed to compile wires");
+        cJSON_Delete(json);
+        return false;
+    }
 
-        // Process nodes and identify the last coil
-        process_nodes(nodes, &condition, &last_coil);
+    // Log number of wires found
+    ESP_LOGI(TAG, "Found wires: %zu", program->rung_count);
 
-        // Process the coil if present
-        if (last_coil) {
-            process_coil(last_coil, condition);
-        } 
+    // Persist the compiled image before the scan cycle changes any variable
+    applied.device = device_fp;
+    applied.variables = variables_fp;
+    capture_configured_sections();
+    save_config_image(program);
 
-        // Delay to prevent excessive CPU usage
-        vTaskDelay(pdMS_TO_TICKS(10));
+    // Run all rungs from a single scan cycle task
+    if (scan_cycle_start(program, _device.scan_period_ms) != ESP_OK) {
+        // Log error and clean up if the scan cycle cannot be started
+        ESP_LOGE(TAG, "Failed to start scan cycle");
+        ladder_program_free(program);
+    } else {
+        applied.valid = true;
+        applied.arena_used = config_arena.total_used;
     }
 
-    // Clean up (unreachable due to infinite loop)
-    cJSON_Delete(wire);
-    vTaskDelete(NULL);
+    // Free memory
+    cJSON_Delete(json);
+    return true;
 }
 
-/**
- * @brief Deletes all tasks and cleans up associated resources.
- */
-void delete_all_tasks(void) {
-    // Stop timeout timer if it exists
-    if (config_timeout_timer) {
-        xTimerStop(config_timeout_timer, portMAX_DELAY);
-        xTimerDelete(config_timeout_timer, portMAX_DELAY);
-        config_timeout_timer = NULL;
+bool configure_from_image(const uint8_t *image, size_t image_len) {
+    ImageReader reader;
+    if (!config_image_open(image, image_len, &reader)) {
+        return false;
     }
 
-    // Free large_buffer if it exists
-    if (large_buffer) {
-        free(large_buffer);
-        large_buffer = NULL;
-        total_received = 0;
-    }
+    // Delete all previous tasks
+    delete_all_tasks();
 
-    // Delete all tasks
-    if (tasks) {
-        for (int i = 0; i < num_tasks; i++) {
-            if (tasks[i].handle) {
-                vTaskDelete(tasks[i].handle);
-                // Log task deletion
-                ESP_LOGI(TAG, "Deleted task %d", i);
-                tasks[i].handle = NULL;
-            }
-            if (tasks[i].wire_copy) {
-                cJSON_Delete(tasks[i].wire_copy);
-                // Log wire copy cleanup
-                ESP_LOGI(TAG, "Freed wire_copy for task %d", i);
-                tasks[i].wire_copy = NULL;
-            }
-        }
-        free(tasks);
-        tasks = NULL;
-        num_tasks = 0;
+    // Release the previous configuration generation in one step
+    unload_variables();
+    arena_reset(&config_arena);
+
+    // Device table, variables and compiled rungs, in the order they were written
+    if (!device_init_from_image(&reader) || !load_variables_from_image(&reader) ||
+        !ladder_program_read_image(&reader, program)) {
+        // Log error and leave the device unconfigured so the caller can fall back to JSON
+        ESP_LOGE(TAG, "Failed to load configuration image");
+        unload_variables();
+        ladder_program_free(program);
+        return false;
+    }
+    applied.device = image_read_u64(&reader);
+    applied.variables = image_read_u64(&reader);
+    capture_configured_sections();
+    print_device_info();
+
+    // Log number of wires found
+    ESP_LOGI(TAG, "Loaded %zu compiled wires from image", program->rung_count);
+
+    // Run all rungs from a single scan cycle task
+    if (scan_cycle_start(program, _device.scan_period_ms) != ESP_OK) {
+        // Log error and clean up if the scan cycle cannot be started
+        ESP_LOGE(TAG, "Failed to start scan cycle");
+        ladder_program_free(program);
+    } else {
+        applied.valid = !reader.failed;
+        applied.arena_used = config_arena.total_used;
     }
+    return true;
 }
 
 void configure(const char *data, int data_len, bool loaded_from_nvs) {
@@ -442,18 +398,23 @@ void configure(const char *data, int data_len, bool loaded_from_nvs) {
     }
     xTimerReset(config_timeout_timer, portMAX_DELAY);
 
-    // Allocate or expand buffer for new part
-    char *new_buffer = realloc(large_buffer, total_received + data_len + 1); // +1 for null-termination
-    if (!new_buffer) {
-        // Log error and clean up if memory allocation fails
-        ESP_LOGE(TAG, "Memory allocation failed for buffer");
-        free(large_buffer);
-        large_buffer = NULL;
-        total_received = 0;
-        xTimerStop(config_timeout_timer, portMAX_DELAY);
-        return;
+    // Grow the buffer geometrically so each byte is copied a bounded number of times
+    if (total_received + data_len + 1 > buffer_capacity) { // +1 for null-termination
+        size_t new_capacity = buffer_capacity ? buffer_capacity : 256;
+        while (new_capacity < total_received + data_len + 1) {
+            new_capacity *= 2;
+        }
+        char *new_buffer = realloc(large_buffer, new_capacity);
+        if (!new_buffer) {
+            // Log error and clean up if memory allocation fails
+            ESP_LOGE(TAG, "Memory allocation failed for buffer");
+            reset_config_buffer();
+            xTimerStop(config_timeout_timer, portMAX_DELAY);
+            return;
+        }
+        large_buffer = new_buffer;
+        buffer_capacity = new_capacity;
     }
-    large_buffer = new_buffer;
 
     // Copy new part into buffer
     memcpy(large_buffer + total_received, data, data_len);
@@ -463,125 +424,23 @@ void configure(const char *data, int data_len, bool loaded_from_nvs) {
     // Log received data
     ESP_LOGI(TAG, "Received %d bytes, total: %zu", data_len, total_received);
 
-    // Attempt to parse JSON
-    cJSON *json = cJSON_Parse(large_buffer);
-    if (json) {
-        // JSON is valid, complete message received
-        ESP_LOGI(TAG, "Complete JSON received, length: %zu bytes", total_received);
-
-        // Stop timeout timer
-        xTimerStop(config_timeout_timer, portMAX_DELAY);
-
-        // Save to NVS
-        if(!loaded_from_nvs) {
-            delete_config_from_nvs();
-            save_config_to_nvs(large_buffer, total_received);
-        }
-
-        // Delete all previous tasks
-        delete_all_tasks();
-
-        // Get Device data
-        cJSON *device = cJSON_GetObjectItem(json, "Device");
-        device_init(device);
-        print_device_info();
-
-        // Get variables
-        cJSON *variables = cJSON_GetObjectItem(json, "Variables");
-        load_variables(variables);
-
-        cJSON *wires = cJSON_GetObjectItem(json, "Wires");
-        if (!cJSON_IsArray(wires)) {
-            // Log error and clean up if Wires is not an array
-            ESP_LOGE(TAG, "Wires is not an array");
-            cJSON_Delete(json);
-            free(large_buffer);
-            large_buffer = NULL;
-            total_received = 0;
-            return;
-        }
-
-        int array_size = cJSON_GetArraySize(wires);
-        // Log number of wires found
-        ESP_LOGI(TAG, "Found wires: %d", array_size);
-
-        // Allocate memory for task array
-        if (esp_get_free_heap_size() < array_size * sizeof(TaskInfo) + (array_size * 4096) + 1024) {
-            // Log error and clean up if insufficient heap memory
-            ESP_LOGE(TAG, "Insufficient heap memory for %d tasks", array_size);
-            cJSON_Delete(json);
-            free(large_buffer);
-            large_buffer = NULL;
-            total_received = 0;
-            return;
-        }
-
-        tasks = calloc(array_size, sizeof(TaskInfo));
-        if (!tasks) {
-            // Log error and clean up if task array allocation fails
-            ESP_LOGE(TAG, "Memory allocation failed for %d tasks", array_size);
-            cJSON_Delete(json);
-            free(large_buffer);
-            large_buffer = NULL;
-            total_received = 0;
-            return;
-        }
-        num_tasks = array_size;
-
-        //printf("Heap before %lu\n", esp_get_free_heap_size());
-
-        // Iterate through wires and create tasks
-        for (int i = 0; i < array_size; i++) {
-            cJSON *wire = cJSON_GetArrayItem(wires, i);
-            if (!cJSON_IsObject(wire)) {
-                // Log warning and skip if wire is not an object
-                ESP_LOGW(TAG, "Wire %d is not an object, skipping", i);
-                continue;
-            }
-
-            // Duplicate wire JSON object
-            cJSON *wire_copy = cJSON_Duplicate(wire, true);
-            if (!wire_copy) {
-                // Log error if wire duplication fails
-                ESP_LOGE(TAG, "Failed to duplicate wire %d", i);
-                continue;
-            }
-
-            // Check available stack space
-            if (uxTaskGetStackHighWaterMark(NULL) < 1024) {
-                // Log warning and skip if stack space is low
-                ESP_LOGW(TAG, "Low stack space, skipping task %d", i);
-                cJSON_Delete(wire_copy);
-                continue;
-            }
-
-            // Create task
-            char task_name[16];
-            snprintf(task_name, sizeof(task_name), "Wire%d", i);
-            tasks[i].wire_copy = wire_copy; // Store wire_copy for cleanup
-            if (xTaskCreate(process_block_task, task_name, 4096, wire_copy, 5, &tasks[i].handle) != pdPASS) {
-                // Log error if task creation fails
-                ESP_LOGE(TAG, "Failed to create task %d", i);
-                cJSON_Delete(wire_copy);
-                tasks[i].wire_copy = NULL;
-            } else {
-                // Log successful task creation
-                ESP_LOGI(TAG, "Created task %d for wire %d", i, i);
-            }
-
-            // Delay between task creations to avoid overloading
-            vTaskDelay(pdMS_TO_TICKS(200));
-        }
-        //printf("Heap after %lu\n", esp_get_free_heap_size());
-
-        // Free memory and reset state
-        cJSON_Delete(json);
-        free(large_buffer);
-        large_buffer = NULL;
-        total_received = 0;
-    } else {
+    // Scan only the new part to find out whether the document is complete
+    JsonStreamStatus status = json_stream_feed(&config_stream, data, data_len);
+    if (status == JSON_STREAM_INCOMPLETE) {
         // Log info if JSON is incomplete
         ESP_LOGI(TAG, "JSON incomplete, waiting for next part...");
-        cJSON_Delete(json);
+        return;
+    }
+    if (status == JSON_STREAM_ERROR) {
+        // Log error and drop the malformed document
+        ESP_LOGE(TAG, "Malformed JSON at byte %zu, discarding configuration", config_stream.consumed);
+        reset_config_buffer();
+        xTimerStop(config_timeout_timer, portMAX_DELAY);
+        return;
+    }
+
+    // Parse and apply the complete document once
+    if (!configure_document(large_buffer, config_stream.consumed, loaded_from_nvs)) {
+        reset_config_buffer();
     }
-}
\ No newline at end of file
+}
@@ -2,6 +2,8 @@
 #define TASK_MANAGER_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /**
  * @brief Configures tasks based on provided data.
@@ -11,6 +13,23 @@
  */
 void configure(const char *data, int data_len, bool loaded_from_nvs);
 
+/**
+ * @brief Parses and applies a complete configuration document.
+ * @param data Pointer to the JSON document.
+ * @param data_len Length of the document in bytes.
+ * @param loaded_from_nvs Indicates if the data was loaded from non-volatile storage.
+ * @return bool True if the configuration was applied, false otherwise.
+ */
+bool configure_document(const char *data, size_t data_len, bool loaded_from_nvs);
+
+/**
+ * @brief Applies a compiled configuration image without parsing any JSON.
+ * @param image Pointer to the image.
+ * @param image_len Length of the image in bytes.
+ * @return bool True if the configuration was applied, false if the image is missing, stale or malformed.
+ */
+bool configure_from_image(const uint8_t *image, size_t image_len);
+
 /**
  * @brief Deletes all configured tasks.
  */
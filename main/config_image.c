@@ -0,0 +1,218 @@
+#include "config_image.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
+/**
+ * @brief Tag for logging messages from the configuration image module.
+ */
+static const char *TAG = "CONFIG_IMAGE";
+
+/**
+ * @brief Reserves room for n more bytes in the writer.
+ * @param w Pointer to the writer.
+ * @param n Number of bytes to reserve.
+ * @return uint8_t* Pointer to the reserved bytes, or NULL on failure.
+ */
+static uint8_t *image_reserve(ImageWriter *w, size_t n) {
+    if (w->failed) {
+        return NULL;
+    }
+    if (w->len + n > w->capacity) {
+        size_t new_capacity = w->capacity ? w->capacity : 512;
+        while (new_capacity < w->len + n) {
+            new_capacity *= 2;
+        }
+        uint8_t *new_data = realloc(w->data, new_capacity);
+        if (!new_data) {
+            ESP_LOGE(TAG, "Memory allocation failed for %zu byte image", new_capacity);
+            w->failed = true;
+            return NULL;
+        }
+        w->data = new_data;
+        w->capacity = new_capacity;
+    }
+    uint8_t *p = w->data + w->len;
+    w->len += n;
+    return p;
+}
+
+/**
+ * @brief Consumes n bytes from the reader.
+ * @param r Pointer to the reader.
+ * @param n Number of bytes to consume.
+ * @return const uint8_t* Pointer to the bytes, or NULL with r->failed set past the end.
+ */
+static const uint8_t *image_take(ImageReader *r, size_t n) {
+    if (r->failed || n > r->len - r->pos) {
+        r->failed = true;
+        return NULL;
+    }
+    const uint8_t *p = r->data + r->pos;
+    r->pos += n;
+    return p;
+}
+
+void image_writer_begin(ImageWriter *w) {
+    memset(w, 0, sizeof(*w));
+    image_reserve(w, sizeof(ConfigImageHeader));
+}
+
+bool image_writer_finish(ImageWriter *w) {
+    if (w->failed) {
+        free(w->data);
+        memset(w, 0, sizeof(*w));
+        return false;
+    }
+    ConfigImageHeader header = {
+        .magic = CONFIG_IMAGE_MAGIC,
+        .version = CONFIG_IMAGE_VERSION,
+        .header_size = sizeof(ConfigImageHeader),
+        .payload_len = (uint32_t)(w->len - sizeof(ConfigImageHeader)),
+    };
+    header.payload_crc = esp_rom_crc32_le(0, w->data + sizeof(ConfigImageHeader), header.payload_len);
+    memcpy(w->data, &header, sizeof(header));
+    return true;
+}
+
+void image_write_u8(ImageWriter *w, uint8_t value) {
+    uint8_t *p = image_reserve(w, 1);
+    if (p) p[0] = value;
+}
+
+void image_write_u16(ImageWriter *w, uint16_t value) {
+    uint8_t *p = image_reserve(w, 2);
+    if (p) {
+        p[0] = (uint8_t)value;
+        p[1] = (uint8_t)(value >> 8);
+    }
+}
+
+void image_write_u32(ImageWriter *w, uint32_t value) {
+    uint8_t *p = image_reserve(w, 4);
+    if (p) {
+        for (int i = 0; i < 4; i++) {
+            p[i] = (uint8_t)(value >> (8 * i));
+        }
+    }
+}
+
+void image_write_i32(ImageWriter *w, int32_t value) {
+    image_write_u32(w, (uint32_t)value);
+}
+
+void image_write_u64(ImageWriter *w, uint64_t value) {
+    image_write_u32(w, (uint32_t)value);
+    image_write_u32(w, (uint32_t)(value >> 32));
+}
+
+void image_write_f64(ImageWriter *w, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    image_write_u64(w, bits);
+}
+
+void image_write_bytes(ImageWriter *w, const void *bytes, size_t len) {
+    uint8_t *p = image_reserve(w, len);
+    if (p && len) memcpy(p, bytes, len);
+}
+
+void image_write_string(ImageWriter *w, const char *str) {
+    if (!str) {
+        image_write_u16(w, CONFIG_IMAGE_NULL_STRING);
+        return;
+    }
+    size_t len = strlen(str);
+    if (len >= CONFIG_IMAGE_NULL_STRING) {
+        ESP_LOGE(TAG, "String too long for image: %zu bytes", len);
+        w->failed = true;
+        return;
+    }
+    image_write_u16(w, (uint16_t)len);
+    uint8_t *p = image_reserve(w, len + 1);
+    if (p) memcpy(p, str, len + 1);
+}
+
+uint8_t image_read_u8(ImageReader *r) {
+    const uint8_t *p = image_take(r, 1);
+    return p ? p[0] : 0;
+}
+
+uint16_t image_read_u16(ImageReader *r) {
+    const uint8_t *p = image_take(r, 2);
+    return p ? (uint16_t)(p[0] | (p[1] << 8)) : 0;
+}
+
+uint32_t image_read_u32(ImageReader *r) {
+    const uint8_t *p = image_take(r, 4);
+    if (!p) {
+        return 0;
+    }
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int32_t image_read_i32(ImageReader *r) {
+    return (int32_t)image_read_u32(r);
+}
+
+uint64_t image_read_u64(ImageReader *r) {
+    uint64_t value = image_read_u32(r);
+    return value | (uint64_t)image_read_u32(r) << 32;
+}
+
+double image_read_f64(ImageReader *r) {
+    uint64_t bits = image_read_u64(r);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+const char *image_read_string(ImageReader *r) {
+    uint16_t len = image_read_u16(r);
+    if (r->failed || len == CONFIG_IMAGE_NULL_STRING) {
+        return NULL;
+    }
+    const char *str = (const char *)image_take(r, (size_t)len + 1);
+    if (str && str[len] != '\0') {
+        r->failed = true;
+        return NULL;
+    }
+    return str;
+}
+
+uint32_t image_read_count(ImageReader *r, size_t min_element_size) {
+    uint32_t count = image_read_u32(r);
+    if (min_element_size && count > (r->len - r->pos) / min_element_size) {
+        r->failed = true;
+        return 0;
+    }
+    return count;
+}
+
+bool config_image_open(const uint8_t *image, size_t image_len, ImageReader *reader) {
+    ConfigImageHeader header;
+    if (!image || image_len < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, image, sizeof(header));
+    if (header.magic != CONFIG_IMAGE_MAGIC || header.header_size != sizeof(header)) {
+        ESP_LOGW(TAG, "Not a configuration image");
+        return false;
+    }
+    if (header.version != CONFIG_IMAGE_VERSION) {
+        ESP_LOGW(TAG, "Image version %u does not match firmware version %u", header.version, CONFIG_IMAGE_VERSION);
+        return false;
+    }
+    if (header.payload_len != image_len - sizeof(header) ||
+        esp_rom_crc32_le(0, image + sizeof(header), header.payload_len) != header.payload_crc) {
+        ESP_LOGE(TAG, "Image length or CRC mismatch");
+        return false;
+    }
+
+    reader->data = image + sizeof(header);
+    reader->len = header.payload_len;
+    reader->pos = 0;
+    reader->failed = false;
+    return true;
+}
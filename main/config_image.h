@@ -0,0 +1,194 @@
+#ifndef CONFIG_IMAGE_H
+#define CONFIG_IMAGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Magic number at the start of a compiled configuration image ("PLCI").
+ */
+#define CONFIG_IMAGE_MAGIC 0x49434C50u
+
+/**
+ * @brief Version of the image layout; bump whenever a serialized structure or opcode changes.
+ */
+#define CONFIG_IMAGE_VERSION 7
+
+/**
+ * @brief Marker used as string length for a NULL string.
+ */
+#define CONFIG_IMAGE_NULL_STRING 0xFFFFu
+
+/**
+ * @brief Header of a compiled configuration image.
+ *
+ * The payload holds no pointers: all values are little-endian scalars, and
+ * strings and arrays are length-prefixed, so the image can be stored and
+ * loaded at any address.
+ */
+typedef struct {
+    uint32_t magic;         ///< CONFIG_IMAGE_MAGIC.
+    uint16_t version;       ///< CONFIG_IMAGE_VERSION.
+    uint16_t header_size;   ///< Size of this header in bytes.
+    uint32_t payload_len;   ///< Length of the payload following the header.
+    uint32_t payload_crc;   ///< CRC32 of the payload.
+} ConfigImageHeader;
+
+/**
+ * @brief Growable buffer used to serialize an image.
+ */
+typedef struct {
+    uint8_t *data;      ///< Serialized bytes.
+    size_t len;         ///< Number of bytes written.
+    size_t capacity;    ///< Allocated size of data.
+    bool failed;        ///< Set when an allocation failed; further writes are ignored.
+} ImageWriter;
+
+/**
+ * @brief Cursor over a serialized image payload.
+ */
+typedef struct {
+    const uint8_t *data;    ///< Payload bytes.
+    size_t len;             ///< Payload length.
+    size_t pos;             ///< Read position.
+    bool failed;            ///< Set when a read ran past the end or found malformed data.
+} ImageReader;
+
+/**
+ * @brief Starts an image: resets the writer and reserves room for the header.
+ * @param w Pointer to the writer.
+ */
+void image_writer_begin(ImageWriter *w);
+
+/**
+ * @brief Completes an image by filling in the header and payload CRC.
+ * @param w Pointer to the writer; on success w->data/w->len hold the image.
+ * @return bool True on success, false if any write failed (the buffer is then freed).
+ */
+bool image_writer_finish(ImageWriter *w);
+
+/**
+ * @brief Appends an unsigned 8-bit value.
+ * @param w Pointer to the writer.
+ * @param value Value to write.
+ */
+void image_write_u8(ImageWriter *w, uint8_t value);
+
+/**
+ * @brief Appends a little-endian unsigned 16-bit value.
+ * @param w Pointer to the writer.
+ * @param value Value to write.
+ */
+void image_write_u16(ImageWriter *w, uint16_t value);
+
+/**
+ * @brief Appends a little-endian unsigned 32-bit value.
+ * @param w Pointer to the writer.
+ * @param value Value to write.
+ */
+void image_write_u32(ImageWriter *w, uint32_t value);
+
+/**
+ * @brief Appends a little-endian signed 32-bit value.
+ * @param w Pointer to the writer.
+ * @param value Value to write.
+ */
+void image_write_i32(ImageWriter *w, int32_t value);
+
+/**
+ * @brief Appends a little-endian unsigned 64-bit value.
+ * @param w Pointer to the writer.
+ * @param value Value to write.
+ */
+void image_write_u64(ImageWriter *w, uint64_t value);
+
+/**
+ * @brief Appends an IEEE-754 double in little-endian byte order.
+ * @param w Pointer to the writer.
+ * @param value Value to write.
+ */
+void image_write_f64(ImageWriter *w, double value);
+
+/**
+ * @brief Appends raw bytes, such as sections copied from another image.
+ * @param w Pointer to the writer.
+ * @param bytes Bytes to write.
+ * @param len Number of bytes.
+ */
+void image_write_bytes(ImageWriter *w, const void *bytes, size_t len);
+
+/**
+ * @brief Appends a length-prefixed, null-terminated string (NULL is preserved).
+ * @param w Pointer to the writer.
+ * @param str String to write, or NULL.
+ */
+void image_write_string(ImageWriter *w, const char *str);
+
+/**
+ * @brief Reads an unsigned 8-bit value.
+ * @param r Pointer to the reader.
+ * @return uint8_t Value, or 0 with r->failed set past the end.
+ */
+uint8_t image_read_u8(ImageReader *r);
+
+/**
+ * @brief Reads a little-endian unsigned 16-bit value.
+ * @param r Pointer to the reader.
+ * @return uint16_t Value, or 0 with r->failed set past the end.
+ */
+uint16_t image_read_u16(ImageReader *r);
+
+/**
+ * @brief Reads a little-endian unsigned 32-bit value.
+ * @param r Pointer to the reader.
+ * @return uint32_t Value, or 0 with r->failed set past the end.
+ */
+uint32_t image_read_u32(ImageReader *r);
+
+/**
+ * @brief Reads a little-endian signed 32-bit value.
+ * @param r Pointer to the reader.
+ * @return int32_t Value, or 0 with r->failed set past the end.
+ */
+int32_t image_read_i32(ImageReader *r);
+
+/**
+ * @brief Reads a little-endian unsigned 64-bit value.
+ * @param r Pointer to the reader.
+ * @return uint64_t Value, or 0 with r->failed set past the end.
+ */
+uint64_t image_read_u64(ImageReader *r);
+
+/**
+ * @brief Reads a little-endian IEEE-754 double.
+ * @param r Pointer to the reader.
+ * @return double Value, or 0 with r->failed set past the end.
+ */
+double image_read_f64(ImageReader *r);
+
+/**
+ * @brief Reads a string written by image_write_string().
+ * @param r Pointer to the reader.
+ * @return const char* Null-terminated string inside the image, or NULL for a NULL string or on error.
+ */
+const char *image_read_string(ImageReader *r);
+
+/**
+ * @brief Reads an element count and checks it against the remaining payload.
+ * @param r Pointer to the reader.
+ * @param min_element_size Minimum number of payload bytes each element occupies.
+ * @return uint32_t Element count, or 0 with r->failed set if the count cannot fit.
+ */
+uint32_t image_read_count(ImageReader *r, size_t min_element_size);
+
+/**
+ * @brief Validates an image header and CRC and opens a reader over its payload.
+ * @param image Image bytes.
+ * @param image_len Image length.
+ * @param reader Pointer to the reader to initialize.
+ * @return bool True if the image is valid for this firmware, false otherwise.
+ */
+bool config_image_open(const uint8_t *image, size_t image_len, ImageReader *reader);
+
+#endif // CONFIG_IMAGE_H
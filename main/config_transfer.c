@@ -0,0 +1,209 @@
+#include "config_transfer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "conf_task_manager.h"
+
+/**
+ * @brief Tag for logging messages from the configuration transfer module.
+ */
+static const char *TAG = "CONFIG_TRANSFER";
+
+/**
+ * @brief State of the framed transfer in progress.
+ */
+typedef struct {
+    uint8_t *buffer;        ///< Document buffer, allocated once from the START frame.
+    uint32_t total_len;     ///< Announced document length.
+    uint32_t crc;           ///< Announced CRC32 of the document.
+    uint32_t received;      ///< Contiguous bytes received (the resume offset).
+    uint16_t next_seq;      ///< Sequence number expected in the next DATA frame.
+    uint16_t unacked;       ///< In-order DATA frames since the last acknowledgement.
+} ConfigTransfer;
+
+/**
+ * @brief Transfer in progress; buffer is NULL when idle.
+ */
+static ConfigTransfer transfer = {0};
+
+/**
+ * @brief Serializes frames arriving from BLE and MQTT.
+ */
+static SemaphoreHandle_t transfer_mutex = NULL;
+
+/**
+ * @brief Reads a little-endian 16-bit value.
+ * @param p Pointer to the bytes.
+ * @return uint16_t Decoded value.
+ */
+static uint16_t read_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+ * @brief Reads a little-endian 32-bit value.
+ * @param p Pointer to the bytes.
+ * @return uint32_t Decoded value.
+ */
+static uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief Drops the transfer in progress.
+ */
+static void transfer_reset(void) {
+    free(transfer.buffer);
+    memset(&transfer, 0, sizeof(transfer));
+}
+
+/**
+ * @brief Handles a START frame: begins a new transfer or resumes the interrupted one.
+ * @param data Frame bytes.
+ * @param len Frame length.
+ * @param ack Acknowledgement buffer.
+ * @param ack_size Size of the acknowledgement buffer.
+ */
+static void handle_start(const uint8_t *data, size_t len, char *ack, size_t ack_size) {
+    if (len < CONFIG_FRAME_START_LEN) {
+        snprintf(ack, ack_size, "ERR FRAME");
+        return;
+    }
+    uint32_t total_len = read_le32(&data[2]);
+    uint32_t crc = read_le32(&data[6]);
+
+    // Same document as the interrupted transfer: continue from the last contiguous offset
+    if (transfer.buffer && transfer.total_len == total_len && transfer.crc == crc) {
+        ESP_LOGI(TAG, "Resuming transfer at offset %lu of %lu", (unsigned long)transfer.received, (unsigned long)total_len);
+        transfer.unacked = 0;
+        snprintf(ack, ack_size, "ACK %lu %u", (unsigned long)transfer.received, transfer.next_seq);
+        return;
+    }
+
+    transfer_reset();
+    if (total_len == 0 || total_len > CONFIG_TRANSFER_MAX_LEN) {
+        ESP_LOGE(TAG, "Invalid transfer length %lu", (unsigned long)total_len);
+        snprintf(ack, ack_size, "ERR LENGTH");
+        return;
+    }
+
+    // Preallocate the whole document once; chunks are written in place
+    transfer.buffer = malloc(total_len);
+    if (!transfer.buffer) {
+        ESP_LOGE(TAG, "Memory allocation failed for %lu byte transfer", (unsigned long)total_len);
+        snprintf(ack, ack_size, "ERR MEMORY");
+        return;
+    }
+    transfer.total_len = total_len;
+    transfer.crc = crc;
+    ESP_LOGI(TAG, "Transfer started, length: %lu bytes", (unsigned long)total_len);
+    snprintf(ack, ack_size, "ACK 0 0");
+}
+
+/**
+ * @brief Handles a DATA frame and applies the document once it is complete.
+ * @param data Frame bytes.
+ * @param len Frame length.
+ * @param ack Acknowledgement buffer.
+ * @param ack_size Size of the acknowledgement buffer.
+ */
+static void handle_data(const uint8_t *data, size_t len, char *ack, size_t ack_size) {
+    if (!transfer.buffer) {
+        snprintf(ack, ack_size, "ERR IDLE");
+        return;
+    }
+    if (len < CONFIG_FRAME_DATA_HEADER_LEN) {
+        snprintf(ack, ack_size, "ERR FRAME");
+        return;
+    }
+
+    uint16_t seq = read_le16(&data[2]);
+    uint32_t offset = read_le32(&data[4]);
+    size_t payload_len = len - CONFIG_FRAME_DATA_HEADER_LEN;
+
+    // Only the next contiguous chunk is accepted; anything else asks the sender to rewind
+    if (seq != transfer.next_seq || offset != transfer.received || payload_len > transfer.total_len - offset) {
+        ESP_LOGW(TAG, "Out of order frame seq %u offset %lu, expected seq %u offset %lu",
+                 seq, (unsigned long)offset, transfer.next_seq, (unsigned long)transfer.received);
+        transfer.unacked = 0;
+        snprintf(ack, ack_size, "NAK %lu %u", (unsigned long)transfer.received, transfer.next_seq);
+        return;
+    }
+
+    memcpy(transfer.buffer + offset, &data[CONFIG_FRAME_DATA_HEADER_LEN], payload_len);
+    transfer.received += payload_len;
+    transfer.next_seq++;
+
+    if (transfer.received < transfer.total_len) {
+        if (++transfer.unacked >= CONFIG_TRANSFER_ACK_INTERVAL) {
+            transfer.unacked = 0;
+            snprintf(ack, ack_size, "ACK %lu %u", (unsigned long)transfer.received, transfer.next_seq);
+        }
+        return;
+    }
+
+    // Document complete: verify integrity before touching the running configuration
+    uint32_t crc = esp_rom_crc32_le(0, transfer.buffer, transfer.total_len);
+    if (crc != transfer.crc) {
+        ESP_LOGE(TAG, "CRC mismatch: expected %08lx, got %08lx", (unsigned long)transfer.crc, (unsigned long)crc);
+        transfer_reset();
+        snprintf(ack, ack_size, "ERR CRC");
+        return;
+    }
+
+    uint32_t total_len = transfer.total_len;
+    bool applied = configure_document((const char *)transfer.buffer, total_len, false);
+    transfer_reset();
+    if (applied) {
+        snprintf(ack, ack_size, "DONE %lu", (unsigned long)total_len);
+    } else {
+        snprintf(ack, ack_size, "ERR CONFIG");
+    }
+}
+
+bool config_transfer_is_frame(const uint8_t *data, size_t len) {
+    return len >= 2 && data[0] == CONFIG_TRANSFER_MAGIC;
+}
+
+esp_err_t config_transfer_init(void) {
+    if (!transfer_mutex) {
+        transfer_mutex = xSemaphoreCreateMutex();
+        if (!transfer_mutex) {
+            ESP_LOGE(TAG, "Failed to create transfer mutex");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+bool config_transfer_handle_frame(const uint8_t *data, size_t len, char *ack, size_t ack_size) {
+    ack[0] = '\0';
+    if (!transfer_mutex || !config_transfer_is_frame(data, len)) {
+        return false;
+    }
+
+    xSemaphoreTake(transfer_mutex, portMAX_DELAY);
+    switch (data[1]) {
+        case CONFIG_FRAME_START:
+            handle_start(data, len, ack, ack_size);
+            break;
+        case CONFIG_FRAME_DATA:
+            handle_data(data, len, ack, ack_size);
+            break;
+        case CONFIG_FRAME_ABORT:
+            ESP_LOGI(TAG, "Transfer aborted by sender");
+            transfer_reset();
+            snprintf(ack, ack_size, "ACK 0 0");
+            break;
+        default:
+            snprintf(ack, ack_size, "ERR FRAME");
+            break;
+    }
+    xSemaphoreGive(transfer_mutex);
+    return ack[0] != '\0';
+}
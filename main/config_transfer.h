@@ -0,0 +1,86 @@
+#ifndef CONFIG_TRANSFER_H
+#define CONFIG_TRANSFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @brief First byte of every configuration transfer frame.
+ *
+ * A JSON document never starts with this byte, so unframed uploads are still
+ * passed to configure() unchanged.
+ */
+#define CONFIG_TRANSFER_MAGIC 0xC5
+
+/**
+ * @brief Frame types of the configuration transfer protocol.
+ *
+ * All multi-byte fields are little-endian.
+ * - START: magic, type, u32 total_length, u32 crc32. Announces a document, or
+ *   resumes it if the length and CRC match the interrupted transfer.
+ * - DATA: magic, type, u16 sequence, u32 offset, payload. Written in place at offset.
+ * - ABORT: magic, type. Drops the transfer in progress.
+ */
+typedef enum {
+    CONFIG_FRAME_START = 0x01, ///< Start or resume a transfer.
+    CONFIG_FRAME_DATA = 0x02,  ///< Chunk of the document.
+    CONFIG_FRAME_ABORT = 0x03  ///< Abort the transfer in progress.
+} ConfigFrameType;
+
+/**
+ * @brief Size of the START frame in bytes.
+ */
+#define CONFIG_FRAME_START_LEN 10
+
+/**
+ * @brief Size of the DATA frame header in bytes.
+ */
+#define CONFIG_FRAME_DATA_HEADER_LEN 8
+
+/**
+ * @brief Largest document accepted by the receiver in bytes.
+ */
+#define CONFIG_TRANSFER_MAX_LEN (256 * 1024)
+
+/**
+ * @brief Number of in-order DATA frames between two progress acknowledgements.
+ */
+#define CONFIG_TRANSFER_ACK_INTERVAL 8
+
+/**
+ * @brief Maximum length of an acknowledgement message, including the terminator.
+ */
+#define CONFIG_TRANSFER_ACK_LEN 48
+
+/**
+ * @brief Initializes the transfer state shared by the BLE and MQTT receivers.
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if the mutex cannot be created.
+ */
+esp_err_t config_transfer_init(void);
+
+/**
+ * @brief Checks whether a received write is a configuration transfer frame.
+ * @param data Received bytes.
+ * @param len Number of received bytes.
+ * @return bool True if the data starts with CONFIG_TRANSFER_MAGIC.
+ */
+bool config_transfer_is_frame(const uint8_t *data, size_t len);
+
+/**
+ * @brief Handles one configuration transfer frame.
+ *
+ * When the last chunk arrives, the CRC is verified and the document is applied
+ * with configure_document(). The acknowledgement to return to the sender is written
+ * to ack as text: "ACK <offset> <sequence>", "NAK <offset> <sequence>",
+ * "DONE <length>" or "ERR <reason>".
+ * @param data Frame bytes.
+ * @param len Frame length in bytes.
+ * @param ack Buffer receiving the acknowledgement, or an empty string if none is due.
+ * @param ack_size Size of the ack buffer.
+ * @return bool True if an acknowledgement was written.
+ */
+bool config_transfer_handle_frame(const uint8_t *data, size_t len, char *ack, size_t ack_size);
+
+#endif // CONFIG_TRANSFER_H
@@ -6,6 +6,10 @@
 #include <stdlib.h>
 
 #include "sensor.h"
+#include "process_image.h"
+#include "name_index.h"
+#include "arena.h"
+#include "config_image.h"
 
 /**
  * @brief Tag for logging messages from the device configuration module.
@@ -18,96 +22,32 @@ static const char *TAG = "DEVICE CONFIGURATION";
 Device _device = {0};
 
 /**
- * @brief Frees the memory allocated for the Device structure.
- * @param dev Pointer to the Device structure to free.
+ * @brief Information of all named pins, in find_pin_by_name precedence order.
  */
-void free_device(Device *dev) {
-    free(dev->device_name);
-
-    // Free Digital I/O
-    free(dev->digital_inputs);
-    if (dev->digital_inputs_names) {
-        for (size_t i = 0; i < dev->digital_inputs_names_len; i++) {
-            free(dev->digital_inputs_names[i]);
-        }
-        free(dev->digital_inputs_names);
-    }
-    free(dev->digital_outputs);
-    if (dev->digital_outputs_names) {
-        for (size_t i = 0; i < dev->digital_outputs_names_len; i++) {
-            free(dev->digital_outputs_names[i]);
-        }
-        free(dev->digital_outputs_names);
-    }
-
-    // Free Analog I/O
-    free(dev->analog_inputs);
-    if (dev->analog_inputs_names) {
-        for (size_t i = 0; i < dev->analog_inputs_names_len; i++) {
-            free(dev->analog_inputs_names[i]);
-        }
-        free(dev->analog_inputs_names);
-    }
-    free(dev->dac_outputs);
-    if (dev->dac_outputs_names) {
-        for (size_t i = 0; i < dev->dac_outputs_names_len; i++) {
-            free(dev->dac_outputs_names[i]);
-        }
-        free(dev->dac_outputs_names);
-    }
+static PinInfo *pin_table = NULL;
 
-    // Free One-Wire
-    free(dev->one_wire_inputs);
-    if (dev->one_wire_inputs_names) {
-        for (size_t i = 0; i < dev->one_wire_inputs_len; i++) {
-            if (dev->one_wire_inputs_names[i]) {
-                for (size_t j = 0; j < dev->one_wire_inputs_names_len[i]; j++) {
-                    free(dev->one_wire_inputs_names[i][j]);
-                }
-                free(dev->one_wire_inputs_names[i]);
-            }
-        }
-        free(dev->one_wire_inputs_names);
-    }
-    if (dev->one_wire_inputs_devices_types) {
-        for (size_t i = 0; i < dev->one_wire_inputs_len; i++) {
-            if (dev->one_wire_inputs_devices_types[i]) {
-                for (size_t j = 0; j < dev->one_wire_inputs_devices_types_len[i]; j++) {
-                    free(dev->one_wire_inputs_devices_types[i][j]);
-                }
-                free(dev->one_wire_inputs_devices_types[i]);
-            }
-        }
-        free(dev->one_wire_inputs_devices_types);
-    }
-    if (dev->one_wire_inputs_devices_addresses) {
-        for (size_t i = 0; i < dev->one_wire_inputs_len; i++) {
-            if (dev->one_wire_inputs_devices_addresses[i]) {
-                for (size_t j = 0; j < dev->one_wire_inputs_devices_addresses_len[i]; j++) {
-                    free(dev->one_wire_inputs_devices_addresses[i][j]);
-                }
-                free(dev->one_wire_inputs_devices_addresses[i]);
-            }
-        }
-        free(dev->one_wire_inputs_devices_addresses);
-    }
-    free(dev->one_wire_inputs_names_len);
-    free(dev->one_wire_inputs_devices_types_len);
-    free(dev->one_wire_inputs_devices_addresses_len);
+/**
+ * @brief Number of entries in pin_table.
+ */
+static size_t pin_table_len = 0;
 
-    free(dev->uart);
-    free(dev->i2c);
-    free(dev->spi);
+/**
+ * @brief Hash index mapping pin names to pin_table entries.
+ */
+static NameIndex pin_index = {0};
 
-    if (dev->parent_devices) {
-        for (size_t i = 0; i < dev->parent_devices_len; i++) {
-            free(dev->parent_devices[i]);
-        }
-        free(dev->parent_devices);
-    }
+// Forward declarations
+static void free_pin_index(void);
+static void build_pin_index(void);
 
-    // Reset the structure to zeros
-    memset(dev, 0, sizeof(Device));
+/**
+ * @brief Clears the Device structure.
+ *
+ * The device arrays and names live in config_arena and are released by arena_reset.
+ * @param dev Pointer to the Device structure to clear.
+ */
+void free_device(Device *dev) {
+    memset(dev, 0, sizeof(*dev));
 }
 
 void print_device_info(void){
@@ -122,6 +62,10 @@ void print_device_info(void){
     for (size_t i = 0; i < _device.digital_inputs_names_len; i++) {
         ESP_LOGI(TAG, "    - %s", _device.digital_inputs_names[i] ? _device.digital_inputs_names[i] : "(null)");
     }
+    ESP_LOGI(TAG, "  interrupt_inputs: [%zu elements]", _device.interrupt_inputs_len);
+    for (size_t i = 0; i < _device.interrupt_inputs_len; i++) {
+        ESP_LOGI(TAG, "    - %d", _device.interrupt_inputs[i]);
+    }
     ESP_LOGI(TAG, "  digital_outputs: [%zu elements]", _device.digital_outputs_len);
     for (size_t i = 0; i < _device.digital_outputs_len; i++) {
         ESP_LOGI(TAG, "    - %d", _device.digital_outputs[i]);
@@ -187,10 +131,12 @@ void print_device_info(void){
         ESP_LOGI(TAG, "    - %d", _device.spi[i]);
     }
     ESP_LOGI(TAG, "  usb: %s", _device.usb ? "true" : "false");
+    ESP_LOGI(TAG, "  scan_period_ms: %d", _device.scan_period_ms);
     ESP_LOGI(TAG, "  parent_devices: [%zu elements]", _device.parent_devices_len);
     for (size_t i = 0; i < _device.parent_devices_len; i++) {
         ESP_LOGI(TAG, "    - %s", _device.parent_devices[i]);
     }
+    ESP_LOGI(TAG, "  parent_encoding: %s", _device.parent_encoding_cbor ? "cbor" : "json");
 }
 
 /**
@@ -199,13 +145,14 @@ void print_device_info(void){
  */
 void load_device_configuration(cJSON *device)
 {
-    // Free existing device memory before loading new configuration
+    // Drop the pin index (it borrows device names) and clear the previous device
+    free_pin_index();
     free_device(&_device);
 
     // device_name
     cJSON *device_name = cJSON_GetObjectItem(device, "device_name");
     if (device_name && cJSON_IsString(device_name) && device_name->valuestring) {
-        _device.device_name = strdup(device_name->valuestring);
+        _device.device_name = arena_strdup(&config_arena, device_name->valuestring);
         if (!_device.device_name) {
             // Log memory allocation error for device_name
             ESP_LOGE(TAG, "Error allocating memory for device_name");
@@ -222,7 +169,7 @@ void load_device_configuration(cJSON *device)
     cJSON *digital_inputs = cJSON_GetObjectItem(device, "digital_inputs");
     if (digital_inputs && cJSON_IsArray(digital_inputs)) {
         _device.digital_inputs_len = cJSON_GetArraySize(digital_inputs);
-        _device.digital_inputs = malloc(_device.digital_inputs_len * sizeof(int));
+        _device.digital_inputs = arena_alloc(&config_arena, _device.digital_inputs_len * sizeof(int));
         if (_device.digital_inputs) {
             for (size_t i = 0; i < _device.digital_inputs_len; i++) {
                 cJSON *item = cJSON_GetArrayItem(digital_inputs, i);
@@ -241,12 +188,12 @@ void load_device_configuration(cJSON *device)
     cJSON *digital_inputs_names = cJSON_GetObjectItem(device, "digital_inputs_names");
     if (digital_inputs_names && cJSON_IsArray(digital_inputs_names)) {
         _device.digital_inputs_names_len = cJSON_GetArraySize(digital_inputs_names);
-        _device.digital_inputs_names = malloc(_device.digital_inputs_names_len * sizeof(char *));
+        _device.digital_inputs_names = arena_alloc(&config_arena, _device.digital_inputs_names_len * sizeof(char *));
         if (_device.digital_inputs_names) {
             for (size_t i = 0; i < _device.digital_inputs_names_len; i++) {
                 cJSON *item = cJSON_GetArrayItem(digital_inputs_names, i);
                 if (item && cJSON_IsString(item) && item->valuestring) {
-                    _device.digital_inputs_names[i] = strdup(item->valuestring);
+                    _device.digital_inputs_names[i] = arena_strdup(&config_arena, item->valuestring);
                     if (!_device.digital_inputs_names[i]) {
                         // Log memory allocation error for digital_inputs_names
                         ESP_LOGE(TAG, "Error allocating memory for digital_inputs_names[%zu]", i);
@@ -262,11 +209,30 @@ void load_device_configuration(cJSON *device)
         }
     }
 
+    // interrupt_inputs (optional, digital inputs whose edges are captured by interrupt)
+    cJSON *interrupt_inputs = cJSON_GetObjectItem(device, "interrupt_inputs");
+    if (interrupt_inputs && cJSON_IsArray(interrupt_inputs)) {
+        _device.interrupt_inputs_len = cJSON_GetArraySize(interrupt_inputs);
+        _device.interrupt_inputs = arena_alloc(&config_arena, _device.interrupt_inputs_len * sizeof(int));
+        if (_device.interrupt_inputs) {
+            for (size_t i = 0; i < _device.interrupt_inputs_len; i++) {
+                cJSON *item = cJSON_GetArrayItem(interrupt_inputs, i);
+                if (item && cJSON_IsNumber(item)) {
+                    _device.interrupt_inputs[i] = item->valueint;
+                }
+            }
+        } else {
+            if(_device.interrupt_inputs_len != 0)
+                // Log memory allocation error for interrupt_inputs
+                ESP_LOGE(TAG, "Error allocating memory for interrupt_inputs");
+        }
+    }
+
     // digital_outputs
     cJSON *digital_outputs = cJSON_GetObjectItem(device, "digital_outputs");
     if (digital_outputs && cJSON_IsArray(digital_outputs)) {
         _device.digital_outputs_len = cJSON_GetArraySize(digital_outputs);
-        _device.digital_outputs = malloc(_device.digital_outputs_len * sizeof(int));
+        _device.digital_outputs = arena_alloc(&config_arena, _device.digital_outputs_len * sizeof(int));
         if (_device.digital_outputs) {
             for (size_t i = 0; i < _device.digital_outputs_len; i++) {
                 cJSON *item = cJSON_GetArrayItem(digital_outputs, i);
@@ -285,12 +251,12 @@ void load_device_configuration(cJSON *device)
     cJSON *digital_outputs_names = cJSON_GetObjectItem(device, "digital_outputs_names");
     if (digital_outputs_names && cJSON_IsArray(digital_outputs_names)) {
         _device.digital_outputs_names_len = cJSON_GetArraySize(digital_outputs_names);
-        _device.digital_outputs_names = malloc(_device.digital_outputs_names_len * sizeof(char *));
+        _device.digital_outputs_names = arena_alloc(&config_arena, _device.digital_outputs_names_len * sizeof(char *));
         if (_device.digital_outputs_names) {
             for (size_t i = 0; i < _device.digital_outputs_names_len; i++) {
                 cJSON *item = cJSON_GetArrayItem(digital_outputs_names, i);
                 if (item && cJSON_IsString(item) && item->valuestring) {
-                    _device.digital_outputs_names[i] = strdup(item->valuestring);
+                    _device.digital_outputs_names[i] = arena_strdup(&config_arena, item->valuestring);
                     if (!_device.digital_outputs_names[i]) {
                         // Log memory allocation error for digital_outputs_names
                         ESP_LOGE(TAG, "Error allocating memory for digital_outputs_names[%zu]", i);
@@ -310,7 +276,7 @@ void load_device_configuration(cJSON *device)
     cJSON *analog_inputs = cJSON_GetObjectItem(device, "analog_inputs");
     if (analog_inputs && cJSON_IsArray(analog_inputs)) {
         _device.analog_inputs_len = cJSON_GetArraySize(analog_inputs);
-        _device.analog_inputs = malloc(_device.analog_inputs_len * sizeof(int));
+        _device.analog_inputs = arena_alloc(&config_arena, _device.analog_inputs_len * sizeof(int));
         if (_device.analog_inputs) {
             for (size_t i = 0; i < _device.analog_inputs_len; i++) {
                 cJSON *item = cJSON_GetArrayItem(analog_inputs, i);
@@ -329,12 +295,12 @@ void load_device_configuration(cJSON *device)
     cJSON *analog_inputs_names = cJSON_GetObjectItem(device, "analog_inputs_names");
     if (analog_inputs_names && cJSON_IsArray(analog_inputs_names)) {
         _device.analog_inputs_names_len = cJSON_GetArraySize(analog_inputs_names);
-        _device.analog_inputs_names = malloc(_device.analog_inputs_names_len * sizeof(char *));
+        _device.analog_inputs_names = arena_alloc(&config_arena, _device.analog_inputs_names_len * sizeof(char *));
         if (_device.analog_inputs_names) {
             for (size_t i = 0; i < _device.analog_inputs_names_len; i++) {
                 cJSON *item = cJSON_GetArrayItem(analog_inputs_names, i);
                 if (item && cJSON_IsString(item) && item->valuestring) {
-                    _device.analog_inputs_names[i] = strdup(item->valuestring);
+                    _device.analog_inputs_names[i] = arena_strdup(&config_arena, item->valuestring);
                     if (!_device.analog_inputs_names[i]) {
                         // Log memory allocation error for analog_inputs_names
                         ESP_LOGE(TAG, "Error allocating memory for analog_inputs_names[%zu]", i);
@@ -354,7 +320,7 @@ void load_device_configuration(cJSON *device)
     cJSON *dac_outputs = cJSON_GetObjectItem(device, "dac_outputs");
     if (dac_outputs && cJSON_IsArray(dac_outputs)) {
         _device.dac_outputs_len = cJSON_GetArraySize(dac_outputs);
-        _device.dac_outputs = malloc(_device.dac_outputs_len * sizeof(int));
+        _device.dac_outputs = arena_alloc(&config_arena, _device.dac_outputs_len * sizeof(int));
         if (_device.dac_outputs) {
             for (size_t i = 0; i < _device.dac_outputs_len; i++) {
                 cJSON *item = cJSON_GetArrayItem(dac_outputs, i);
@@ -373,12 +339,12 @@ void load_device_configuration(cJSON *device)
     cJSON *dac_outputs_names = cJSON_GetObjectItem(device, "dac_outputs_names");
     if (dac_outputs_names && cJSON_IsArray(dac_outputs_names)) {
         _device.dac_outputs_names_len = cJSON_GetArraySize(dac_outputs_names);
-        _device.dac_outputs_names = malloc(_device.dac_outputs_names_len * sizeof(char *));
+        _device.dac_outputs_names = arena_alloc(&config_arena, _device.dac_outputs_names_len * sizeof(char *));
         if (_device.dac_outputs_names) {
             for (size_t i = 0; i < _device.dac_outputs_names_len; i++) {
                 cJSON *item = cJSON_GetArrayItem(dac_outputs_names, i);
                 if (item && cJSON_IsString(item) && item->valuestring) {
-                    _device.dac_outputs_names[i] = strdup(item->valuestring);
+                    _device.dac_outputs_names[i] = arena_strdup(&config_arena, item->valuestring);
                     if (!_device.dac_outputs_names[i]) {
                         // Log memory allocation error for dac_outputs_names
                         ESP_LOGE(TAG, "Error allocating memory for dac_outputs_names[%zu]", i);
@@ -398,7 +364,7 @@ void load_device_configuration(cJSON *device)
     cJSON *one_wire_inputs = cJSON_GetObjectItem(device, "one_wire_inputs");
     if (one_wire_inputs && cJSON_IsArray(one_wire_inputs)) {
         _device.one_wire_inputs_len = cJSON_GetArraySize(one_wire_inputs);
-        _device.one_wire_inputs = malloc(_device.one_wire_inputs_len * sizeof(int));
+        _device.one_wire_inputs = arena_alloc(&config_arena, _device.one_wire_inputs_len * sizeof(int));
         if (_device.one_wire_inputs) {
             for (size_t i = 0; i < _device.one_wire_inputs_len; i++) {
                 cJSON *item = cJSON_GetArrayItem(one_wire_inputs, i);
@@ -416,19 +382,19 @@ void load_device_configuration(cJSON *device)
     // one_wire_inputs_names
     cJSON *one_wire_inputs_names = cJSON_GetObjectItem(device, "one_wire_inputs_names");
     if (one_wire_inputs_names && cJSON_IsArray(one_wire_inputs_names)) {
-        _device.one_wire_inputs_names = malloc(_device.one_wire_inputs_len * sizeof(char **));
-        _device.one_wire_inputs_names_len = malloc(_device.one_wire_inputs_len * sizeof(size_t));
+        _device.one_wire_inputs_names = arena_alloc(&config_arena, _device.one_wire_inputs_len * sizeof(char **));
+        _device.one_wire_inputs_names_len = arena_alloc(&config_arena, _device.one_wire_inputs_len * sizeof(size_t));
         if (_device.one_wire_inputs_names && _device.one_wire_inputs_names_len) {
             for (size_t i = 0; i < _device.one_wire_inputs_len; i++) {
                 cJSON *sub_array = cJSON_GetArrayItem(one_wire_inputs_names, i);
                 if (sub_array && cJSON_IsArray(sub_array)) {
                     _device.one_wire_inputs_names_len[i] = cJSON_GetArraySize(sub_array);
-                    _device.one_wire_inputs_names[i] = malloc(_device.one_wire_inputs_names_len[i] * sizeof(char *));
+                    _device.one_wire_inputs_names[i] = arena_alloc(&config_arena, _device.one_wire_inputs_names_len[i] * sizeof(char *));
                     if (_device.one_wire_inputs_names[i]) {
                         for (size_t j = 0; j < _device.one_wire_inputs_names_len[i]; j++) {
                             cJSON *item = cJSON_GetArrayItem(sub_array, j);
                             if (item && cJSON_IsString(item) && item->valuestring) {
-                                _device.one_wire_inputs_names[i][j] = strdup(item->valuestring);
+                                _device.one_wire_inputs_names[i][j] = arena_strdup(&config_arena, item->valuestring);
                                 if (!_device.one_wire_inputs_names[i][j]) {
                                     // Log memory allocation error for one_wire_inputs_names
                                     ESP_LOGE(TAG, "Error allocating memory for one_wire_inputs_names[%zu][%zu]", i, j);
@@ -456,19 +422,19 @@ void load_device_configuration(cJSON *device)
     // one_wire_inputs_devices_types
     cJSON *one_wire_inputs_devices_types = cJSON_GetObjectItem(device, "one_wire_inputs_devices_types");
     if (one_wire_inputs_devices_types && cJSON_IsArray(one_wire_inputs_devices_types)) {
-        _device.one_wire_inputs_devices_types = malloc(_device.one_wire_inputs_len * sizeof(char **));
-        _device.one_wire_inputs_devices_types_len = malloc(_device.one_wire_inputs_len * sizeof(size_t));
+        _device.one_wire_inputs_devices_types = arena_alloc(&config_arena, _device.one_wire_inputs_len * sizeof(char **));
+        _device.one_wire_inputs_devices_types_len = arena_alloc(&config_arena, _device.one_wire_inputs_len * sizeof(size_t));
         if (_device.one_wire_inputs_devices_types && _device.one_wire_inputs_devices_types_len) {
             for (size_t i = 0; i < _device.one_wire_inputs_len; i++) {
                 cJSON *sub_array = cJSON_GetArrayItem(one_wire_inputs_devices_types, i);
                 if (sub_array && cJSON_IsArray(sub_array)) {
                     _device.one_wire_inputs_devices_types_len[i] = cJSON_GetArraySize(sub_array);
-                    _device.one_wire_inputs_devices_types[i] = malloc(_device.one_wire_inputs_devices_types_len[i] * sizeof(char *));
+                    _device.one_wire_inputs_devices_types[i] = arena_alloc(&config_arena, _device.one_wire_inputs_devices_types_len[i] * sizeof(char *));
                     if (_device.one_wire_inputs_devices_types[i]) {
                         for (size_t j = 0; j < _device.one_wire_inputs_devices_types_len[i]; j++) {
                             cJSON *item = cJSON_GetArrayItem(sub_array, j);
                             if (item && cJSON_IsString(item) && item->valuestring) {
-                                _device.one_wire_inputs_devices_types[i][j] = strdup(item->valuestring);
+                                _device.one_wire_inputs_devices_types[i][j] = arena_strdup(&config_arena, item->valuestring);
                                 if (!_device.one_wire_inputs_devices_types[i][j]) {
                                     // Log memory allocation error for one_wire_inputs_devices_types
                                     ESP_LOGE(TAG, "Error allocating memory for one_wire_inputs_devices_types[%zu][%zu]", i, j);
@@ -496,19 +462,19 @@ void load_device_configuration(cJSON *device)
     // one_wire_inputs_devices_addresses
     cJSON *one_wire_inputs_devices_addresses = cJSON_GetObjectItem(device, "one_wire_inputs_devices_addresses");
     if (one_wire_inputs_devices_addresses && cJSON_IsArray(one_wire_inputs_devices_addresses)) {
-        _device.one_wire_inputs_devices_addresses = malloc(_device.one_wire_inputs_len * sizeof(char **));
-        _device.one_wire_inputs_devices_addresses_len = malloc(_device.one_wire_inputs_len * sizeof(size_t));
+        _device.one_wire_inputs_devices_addresses = arena_alloc(&config_arena, _device.one_wire_inputs_len * sizeof(char **));
+        _device.one_wire_inputs_devices_addresses_len = arena_alloc(&config_arena, _device.one_wire_inputs_len * sizeof(size_t));
         if (_device.one_wire_inputs_devices_addresses && _device.one_wire_inputs_devices_addresses_len) {
             for (size_t i = 0; i < _device.one_wire_inputs_len; i++) {
                 cJSON *sub_array = cJSON_GetArrayItem(one_wire_inputs_devices_addresses, i);
                 if (sub_array && cJSON_IsArray(sub_array)) {
                     _device.one_wire_inputs_devices_addresses_len[i] = cJSON_GetArraySize(sub_array);
-                    _device.one_wire_inputs_devices_addresses[i] = malloc(_device.one_wire_inputs_devices_addresses_len[i] * sizeof(char *));
+                    _device.one_wire_inputs_devices_addresses[i] = arena_alloc(&config_arena, _device.one_wire_inputs_devices_addresses_len[i] * sizeof(char *));
                     if (_device.one_wire_inputs_devices_addresses[i]) {
                         for (size_t j = 0; j < _device.one_wire_inputs_devices_addresses_len[i]; j++) {
                             cJSON *item = cJSON_GetArrayItem(sub_array, j);
                             if (item && cJSON_IsString(item) && item->valuestring) {
-                                _device.one_wire_inputs_devices_addresses[i][j] = strdup(item->valuestring);
+                                _device.one_wire_inputs_devices_addresses[i][j] = arena_strdup(&config_arena, item->valuestring);
                                 if (!_device.one_wire_inputs_devices_addresses[i][j]) {
                                     // Log memory allocation error for one_wire_inputs_devices_addresses
                                     ESP_LOGE(TAG, "Error allocating memory for one_wire_inputs_devices_addresses[%zu][%zu]", i, j);
@@ -555,7 +521,7 @@ void load_device_configuration(cJSON *device)
     cJSON *uart = cJSON_GetObjectItem(device, "UART");
     if (uart && cJSON_IsArray(uart)) {
         _device.uart_len = cJSON_GetArraySize(uart);
-        _device.uart = malloc(_device.uart_len * sizeof(int));
+        _device.uart = arena_alloc(&config_arena, _device.uart_len * sizeof(int));
         if (_device.uart) {
             for (size_t i = 0; i < _device.uart_len; i++) {
                 cJSON *item = cJSON_GetArrayItem(uart, i);
@@ -573,7 +539,7 @@ void load_device_configuration(cJSON *device)
     cJSON *i2c = cJSON_GetObjectItem(device, "I2C");
     if (i2c && cJSON_IsArray(i2c)) {
         _device.i2c_len = cJSON_GetArraySize(i2c);
-        _device.i2c = malloc(_device.i2c_len * sizeof(int));
+        _device.i2c = arena_alloc(&config_arena, _device.i2c_len * sizeof(int));
         if (_device.i2c) {
             for (size_t i = 0; i < _device.i2c_len; i++) {
                 cJSON *item = cJSON_GetArrayItem(i2c, i);
@@ -591,7 +557,7 @@ void load_device_configuration(cJSON *device)
     cJSON *spi = cJSON_GetObjectItem(device, "SPI");
     if (spi && cJSON_IsArray(spi)) {
         _device.spi_len = cJSON_GetArraySize(spi);
-        _device.spi = malloc(_device.spi_len * sizeof(int));
+        _device.spi = arena_alloc(&config_arena, _device.spi_len * sizeof(int));
         if (_device.spi) {
             for (size_t i = 0; i < _device.spi_len; i++) {
                 cJSON *item = cJSON_GetArrayItem(spi, i);
@@ -611,16 +577,29 @@ void load_device_configuration(cJSON *device)
         _device.usb = cJSON_IsTrue(usb);
     }
 
+    // scan_period_ms
+    _device.scan_period_ms = 10;
+    cJSON *scan_period_ms = cJSON_GetObjectItem(device, "scan_period_ms");
+    if (scan_period_ms && cJSON_IsNumber(scan_period_ms) && scan_period_ms->valueint > 0) {
+        _device.scan_period_ms = scan_period_ms->valueint;
+    }
+
+    // parent_encoding (optional, "json" by default; parents must run firmware that accepts CBOR)
+    cJSON *parent_encoding = cJSON_GetObjectItem(device, "parent_encoding");
+    if (parent_encoding && cJSON_IsString(parent_encoding)) {
+        _device.parent_encoding_cbor = strcmp(parent_encoding->valuestring, "cbor") == 0;
+    }
+
     // parent_devices
     cJSON *parent_devices = cJSON_GetObjectItem(device, "parent_devices");
     if (parent_devices && cJSON_IsArray(parent_devices)) {
         _device.parent_devices_len = cJSON_GetArraySize(parent_devices);
-        _device.parent_devices = malloc(_device.parent_devices_len * sizeof(char *));
+        _device.parent_devices = arena_alloc(&config_arena, _device.parent_devices_len * sizeof(char *));
         if (_device.parent_devices) {
             for (size_t i = 0; i < _device.parent_devices_len; i++) {
                 cJSON *item = cJSON_GetArrayItem(parent_devices, i);
                 if (item && cJSON_IsString(item) && item->valuestring) {
-                    _device.parent_devices[i] = strdup(item->valuestring);
+                    _device.parent_devices[i] = arena_strdup(&config_arena, item->valuestring);
                     if (!_device.parent_devices[i]) {
                         // Log memory allocation error for parent_devices
                         ESP_LOGE(TAG, "Error allocating memory for parent_devices[%zu]", i);
@@ -635,56 +614,102 @@ void load_device_configuration(cJSON *device)
                 ESP_LOGE(TAG, "Error allocating memory for parent_devices array");
         }
     }
+
+    // Build the pin name index over the loaded names
+    build_pin_index();
 }
 
-bool find_pin_by_name(const char *pin_name, gpio_num_t *pin) {
-    if (!pin_name || !pin) {
-        return false;
+/**
+ * @brief Drops the pin name index and pin table (their memory belongs to config_arena).
+ */
+static void free_pin_index(void) {
+    name_index_free(&pin_index);
+    pin_table = NULL;
+    pin_table_len = 0;
+}
+
+/**
+ * @brief Adds a named pin to the pin table and index; the first occurrence of a name wins.
+ * @param name Pin name (borrowed from _device).
+ * @param gpio GPIO number of the pin.
+ * @param pin_class Class of the pin.
+ * @param group Index in the class array.
+ * @param index Device index on a one-wire bus.
+ */
+static void add_pin(const char *name, int gpio, PinClass pin_class, size_t group, size_t index) {
+    if (!name) {
+        return;
     }
+    PinInfo *info = &pin_table[pin_table_len];
+    info->gpio = (gpio_num_t)gpio;
+    info->pin_class = pin_class;
+    info->group = (uint16_t)group;
+    info->index = (uint16_t)index;
+    if (name_index_insert(&pin_index, name, (uint32_t)pin_table_len)) {
+        pin_table_len++;
+    }
+}
 
-    // Check digital inputs
-    for (size_t i = 0; i < _device.digital_inputs_names_len && i < _device.digital_inputs_len; i++) {
-        if (_device.digital_inputs_names[i] && strcmp(pin_name, _device.digital_inputs_names[i]) == 0) {
-            *pin = (gpio_num_t)_device.digital_inputs[i];
-            return true;
-        }
+/**
+ * @brief Builds the pin name index from the loaded device configuration.
+ */
+static void build_pin_index(void) {
+    free_pin_index();
+
+    size_t total = _device.digital_inputs_len + _device.digital_outputs_len +
+                   _device.analog_inputs_len + _device.dac_outputs_len;
+    for (size_t i = 0; i < _device.one_wire_inputs_len; i++) {
+        total += _device.one_wire_inputs_names_len ? _device.one_wire_inputs_names_len[i] : 0;
     }
 
-    // Check digital outputs
-    for (size_t i = 0; i < _device.digital_outputs_names_len && i < _device.digital_outputs_len; i++) {
-        if (_device.digital_outputs_names[i] && strcmp(pin_name, _device.digital_outputs_names[i]) == 0) {
-            *pin = (gpio_num_t)_device.digital_outputs[i];
-            return true;
-        }
+    pin_table = arena_calloc(&config_arena, total ? total : 1, sizeof(PinInfo));
+    if (!pin_table || !name_index_init(&pin_index, total, &config_arena)) {
+        // Log memory allocation error for the pin index
+        ESP_LOGE(TAG, "Error allocating memory for pin index");
+        free_pin_index();
+        return;
     }
 
-    // Check analog inputs
+    // Same precedence as the configuration arrays: inputs, outputs, analog, DAC, OneWire
+    for (size_t i = 0; i < _device.digital_inputs_names_len && i < _device.digital_inputs_len; i++) {
+        add_pin(_device.digital_inputs_names[i], _device.digital_inputs[i], PIN_CLASS_DIGITAL_INPUT, i, 0);
+    }
+    for (size_t i = 0; i < _device.digital_outputs_names_len && i < _device.digital_outputs_len; i++) {
+        add_pin(_device.digital_outputs_names[i], _device.digital_outputs[i], PIN_CLASS_DIGITAL_OUTPUT, i, 0);
+    }
     for (size_t i = 0; i < _device.analog_inputs_names_len && i < _device.analog_inputs_len; i++) {
-        if (_device.analog_inputs_names[i] && strcmp(pin_name, _device.analog_inputs_names[i]) == 0) {
-            *pin = (gpio_num_t)_device.analog_inputs[i];
-            return true;
-        }
+        add_pin(_device.analog_inputs_names[i], _device.analog_inputs[i], PIN_CLASS_ANALOG_INPUT, i, 0);
     }
-
-    // Check DAC outputs
     for (size_t i = 0; i < _device.dac_outputs_names_len && i < _device.dac_outputs_len; i++) {
-        if (_device.dac_outputs_names[i] && strcmp(pin_name, _device.dac_outputs_names[i]) == 0) {
-            *pin = (gpio_num_t)_device.dac_outputs[i];
-            return true;
-        }
+        add_pin(_device.dac_outputs_names[i], _device.dac_outputs[i], PIN_CLASS_DAC_OUTPUT, i, 0);
     }
-
-    // Check OneWire inputs
     for (size_t i = 0; i < _device.one_wire_inputs_len; i++) {
+        if (!_device.one_wire_inputs_names || !_device.one_wire_inputs_names[i]) continue;
         for (size_t j = 0; j < _device.one_wire_inputs_names_len[i]; j++) {
-            if (_device.one_wire_inputs_names[i][j] && strcmp(pin_name, _device.one_wire_inputs_names[i][j]) == 0) {
-                *pin = (gpio_num_t)_device.one_wire_inputs[i];
-                return true;
-            }
+            add_pin(_device.one_wire_inputs_names[i][j], _device.one_wire_inputs[i], PIN_CLASS_ONE_WIRE, i, j);
         }
     }
 
-    return false;
+    // Log pin index size
+    ESP_LOGI(TAG, "Pin index built with %zu names", pin_table_len);
+}
+
+bool find_pin_info(const char *pin_name, PinInfo *info) {
+    uint32_t slot;
+    if (!pin_name || !info || !name_index_find(&pin_index, pin_name, &slot)) {
+        return false;
+    }
+    *info = pin_table[slot];
+    return true;
+}
+
+bool find_pin_by_name(const char *pin_name, gpio_num_t *pin) {
+    PinInfo info;
+    if (!pin || !find_pin_info(pin_name, &info)) {
+        return false;
+    }
+    *pin = info.gpio;
+    return true;
 }
 
 // =================== INITIALIZATION DIGITAL I/O ===================
@@ -822,16 +847,218 @@ void init_one_wire_inputs(void) {
     }
 }
 
-// =================== DEVICE INITIALIZATION ===================
-void device_init(cJSON *device)
-{
-    load_device_configuration(device);
+// =================== COMPILED IMAGE ===================
+/**
+ * @brief Writes an int array with its presence flag and length.
+ * @param w Image writer.
+ * @param arr Array to write, or NULL.
+ * @param len Length of the array.
+ */
+static void write_int_array(ImageWriter *w, const int *arr, size_t len) {
+    image_write_u8(w, arr != NULL);
+    image_write_u32(w, (uint32_t)len);
+    for (size_t i = 0; arr && i < len; i++) {
+        image_write_i32(w, arr[i]);
+    }
+}
+
+/**
+ * @brief Reads an int array written by write_int_array() into config_arena.
+ * @param r Image reader.
+ * @param arr Pointer to store the array (NULL if it was absent).
+ * @param len Pointer to store the length.
+ */
+static void read_int_array(ImageReader *r, int **arr, size_t *len) {
+    bool present = image_read_u8(r);
+    *len = image_read_count(r, present ? 4 : 0);
+    *arr = NULL;
+    if (present && !r->failed) {
+        *arr = arena_alloc(&config_arena, *len * sizeof(int));
+        for (size_t i = 0; *arr && i < *len; i++) {
+            (*arr)[i] = image_read_i32(r);
+        }
+        r->failed = r->failed || !*arr;
+    }
+}
+
+/**
+ * @brief Writes a string array with its presence flag and length.
+ * @param w Image writer.
+ * @param arr Array to write, or NULL.
+ * @param len Length of the array.
+ */
+static void write_string_array(ImageWriter *w, char *const *arr, size_t len) {
+    image_write_u8(w, arr != NULL);
+    image_write_u32(w, (uint32_t)len);
+    for (size_t i = 0; arr && i < len; i++) {
+        image_write_string(w, arr[i]);
+    }
+}
+
+/**
+ * @brief Reads a string array written by write_string_array() into config_arena.
+ * @param r Image reader.
+ * @param arr Pointer to store the array (NULL if it was absent).
+ * @param len Pointer to store the length.
+ */
+static void read_string_array(ImageReader *r, char ***arr, size_t *len) {
+    bool present = image_read_u8(r);
+    *len = image_read_count(r, present ? 2 : 0);
+    *arr = NULL;
+    if (present && !r->failed) {
+        *arr = arena_alloc(&config_arena, *len * sizeof(char *));
+        for (size_t i = 0; *arr && i < *len; i++) {
+            const char *str = image_read_string(r);
+            (*arr)[i] = str ? arena_strdup(&config_arena, str) : NULL;
+        }
+        r->failed = r->failed || !*arr;
+    }
+}
+
+/**
+ * @brief Writes a per-bus string array (one-wire names, types or addresses).
+ * @param w Image writer.
+ * @param matrix Array of string arrays, or NULL.
+ * @param lens Array of inner lengths, or NULL.
+ * @param outer_len Number of buses.
+ */
+static void write_string_matrix(ImageWriter *w, char **const *matrix, const size_t *lens, size_t outer_len) {
+    bool present = matrix && lens;
+    image_write_u8(w, present);
+    for (size_t i = 0; present && i < outer_len; i++) {
+        write_string_array(w, matrix[i], lens[i]);
+    }
+}
+
+/**
+ * @brief Reads a per-bus string array written by write_string_matrix() into config_arena.
+ * @param r Image reader.
+ * @param matrix Pointer to store the array of string arrays.
+ * @param lens Pointer to store the array of inner lengths.
+ * @param outer_len Number of buses.
+ */
+static void read_string_matrix(ImageReader *r, char ****matrix, size_t **lens, size_t outer_len) {
+    *matrix = NULL;
+    *lens = NULL;
+    if (!image_read_u8(r) || r->failed) {
+        return;
+    }
+    *matrix = arena_alloc(&config_arena, outer_len * sizeof(char **));
+    *lens = arena_alloc(&config_arena, outer_len * sizeof(size_t));
+    if (!*matrix || !*lens) {
+        r->failed = true;
+        return;
+    }
+    for (size_t i = 0; i < outer_len; i++) {
+        read_string_array(r, &(*matrix)[i], &(*lens)[i]);
+    }
+}
 
+void device_config_write_image(ImageWriter *w) {
+    image_write_string(w, _device.device_name);
+    image_write_f64(w, _device.logic_voltage);
+    write_int_array(w, _device.digital_inputs, _device.digital_inputs_len);
+    write_string_array(w, _device.digital_inputs_names, _device.digital_inputs_names_len);
+    write_int_array(w, _device.digital_outputs, _device.digital_outputs_len);
+    write_string_array(w, _device.digital_outputs_names, _device.digital_outputs_names_len);
+    write_int_array(w, _device.analog_inputs, _device.analog_inputs_len);
+    write_string_array(w, _device.analog_inputs_names, _device.analog_inputs_names_len);
+    write_int_array(w, _device.dac_outputs, _device.dac_outputs_len);
+    write_string_array(w, _device.dac_outputs_names, _device.dac_outputs_names_len);
+    write_int_array(w, _device.one_wire_inputs, _device.one_wire_inputs_len);
+    write_string_matrix(w, _device.one_wire_inputs_names, _device.one_wire_inputs_names_len, _device.one_wire_inputs_len);
+    write_string_matrix(w, _device.one_wire_inputs_devices_types, _device.one_wire_inputs_devices_types_len, _device.one_wire_inputs_len);
+    write_string_matrix(w, _device.one_wire_inputs_devices_addresses, _device.one_wire_inputs_devices_addresses_len, _device.one_wire_inputs_len);
+    image_write_i32(w, _device.pwm_channels);
+    image_write_i32(w, _device.max_hardware_timers);
+    image_write_u8(w, _device.has_rtos);
+    write_int_array(w, _device.uart, _device.uart_len);
+    write_int_array(w, _device.i2c, _device.i2c_len);
+    write_int_array(w, _device.spi, _device.spi_len);
+    image_write_u8(w, _device.usb);
+    image_write_i32(w, _device.scan_period_ms);
+    write_string_array(w, _device.parent_devices, _device.parent_devices_len);
+    image_write_u8(w, _device.parent_encoding_cbor);
+    write_int_array(w, _device.interrupt_inputs, _device.interrupt_inputs_len);
+}
+
+/**
+ * @brief Loads the device configuration from a compiled image.
+ * @param r Image reader positioned at the device section.
+ * @return bool True on success, false if the image is malformed.
+ */
+static bool load_device_image(ImageReader *r) {
+    // Drop the pin index (it borrows device names) and clear the previous device
+    free_pin_index();
+    free_device(&_device);
+
+    const char *device_name = image_read_string(r);
+    _device.device_name = device_name ? arena_strdup(&config_arena, device_name) : NULL;
+    _device.logic_voltage = image_read_f64(r);
+    read_int_array(r, &_device.digital_inputs, &_device.digital_inputs_len);
+    read_string_array(r, &_device.digital_inputs_names, &_device.digital_inputs_names_len);
+    read_int_array(r, &_device.digital_outputs, &_device.digital_outputs_len);
+    read_string_array(r, &_device.digital_outputs_names, &_device.digital_outputs_names_len);
+    read_int_array(r, &_device.analog_inputs, &_device.analog_inputs_len);
+    read_string_array(r, &_device.analog_inputs_names, &_device.analog_inputs_names_len);
+    read_int_array(r, &_device.dac_outputs, &_device.dac_outputs_len);
+    read_string_array(r, &_device.dac_outputs_names, &_device.dac_outputs_names_len);
+    read_int_array(r, &_device.one_wire_inputs, &_device.one_wire_inputs_len);
+    read_string_matrix(r, &_device.one_wire_inputs_names, &_device.one_wire_inputs_names_len, _device.one_wire_inputs_len);
+    read_string_matrix(r, &_device.one_wire_inputs_devices_types, &_device.one_wire_inputs_devices_types_len, _device.one_wire_inputs_len);
+    read_string_matrix(r, &_device.one_wire_inputs_devices_addresses, &_device.one_wire_inputs_devices_addresses_len, _device.one_wire_inputs_len);
+    _device.pwm_channels = image_read_i32(r);
+    _device.max_hardware_timers = image_read_i32(r);
+    _device.has_rtos = image_read_u8(r);
+    read_int_array(r, &_device.uart, &_device.uart_len);
+    read_int_array(r, &_device.i2c, &_device.i2c_len);
+    read_int_array(r, &_device.spi, &_device.spi_len);
+    _device.usb = image_read_u8(r);
+    _device.scan_period_ms = image_read_i32(r);
+    read_string_array(r, &_device.parent_devices, &_device.parent_devices_len);
+    _device.parent_encoding_cbor = image_read_u8(r);
+    read_int_array(r, &_device.interrupt_inputs, &_device.interrupt_inputs_len);
+
+    if (r->failed) {
+        // Log malformed device section and leave an empty device
+        ESP_LOGE(TAG, "Malformed device section in configuration image");
+        free_device(&_device);
+        return false;
+    }
+
+    // Build the pin name index over the loaded names
+    build_pin_index();
+    return true;
+}
+
+// =================== DEVICE INITIALIZATION ===================
+/**
+ * @brief Configures all device pins and the process image for the loaded configuration.
+ */
+static void device_setup_pins(void) {
     init_digital_inputs();
     init_digital_outputs();
     init_analog_inputs();
     init_analog_outputs();
     init_one_wire_inputs();
+
+    // Rebuild process image masks for the configured pins
+    process_image_init();
+}
+
+void device_init(cJSON *device)
+{
+    load_device_configuration(device);
+    device_setup_pins();
+}
+
+bool device_init_from_image(ImageReader *r)
+{
+    if (!load_device_image(r)) {
+        return false;
+    }
+    device_setup_pins();
+    return true;
 }
 
 // ========================= DIGITAL I/O ===========================
@@ -904,33 +1131,27 @@ float get_one_wire_value(const char *pin_name) {
         return -1.0f;
     }
 
-    // Find the corresponding OneWire pin and device index
-    for (size_t i = 0; i < _device.one_wire_inputs_len; i++) {
-        if (_device.one_wire_inputs_names[i]) {
-            for (size_t j = 0; j < _device.one_wire_inputs_names_len[i]; j++) {
-                if (_device.one_wire_inputs_names[i][j] && strcmp(pin_name, _device.one_wire_inputs_names[i][j]) == 0) {
-                    // Found the name, check type and address
-                    if (j < _device.one_wire_inputs_devices_types_len[i] && j < _device.one_wire_inputs_devices_addresses_len[i]  &&  i < _device.one_wire_inputs_len) {
-                        const char *sensor_type = _device.one_wire_inputs_devices_types[i][j];
-                        const char *sensor_address = _device.one_wire_inputs_devices_addresses[i][j];
-                        gpio_num_t pin = (gpio_num_t)_device.one_wire_inputs[i];
-                        if (sensor_type && sensor_address) {
-                            // Call external function to read the sensor
-                            float value = read_one_wire_sensor(sensor_type, sensor_address, pin);
-                            return value;
-                            return 0; // Note: This line is unreachable due to the previous return
-                        } else {
-                            // Log error if sensor type or address is missing
-                            ESP_LOGE(TAG, "Missing type or address for OneWire sensor %s", pin_name);
-                            return -1.0f;
-                        }
-                    } else {
-                        // Log error if array lengths do not match
-                        ESP_LOGE(TAG, "Array length mismatch for OneWire sensor %s", pin_name);
-                        return -1.0f;
-                    }
-                }
+    // Find the corresponding OneWire bus and device index
+    PinInfo info;
+    if (find_pin_info(pin_name, &info) && info.pin_class == PIN_CLASS_ONE_WIRE) {
+        size_t i = info.group;
+        size_t j = info.index;
+        // Found the name, check type and address
+        if (j < _device.one_wire_inputs_devices_types_len[i] && j < _device.one_wire_inputs_devices_addresses_len[i]) {
+            const char *sensor_type = _device.one_wire_inputs_devices_types[i][j];
+            const char *sensor_address = _device.one_wire_inputs_devices_addresses[i][j];
+            if (sensor_type && sensor_address) {
+                // Call external function to read the sensor
+                return read_one_wire_sensor(sensor_type, sensor_address, info.gpio);
+            } else {
+                // Log error if sensor type or address is missing
+                ESP_LOGE(TAG, "Missing type or address for OneWire sensor %s", pin_name);
+                return -1.0f;
             }
+        } else {
+            // Log error if array lengths do not match
+            ESP_LOGE(TAG, "Array length mismatch for OneWire sensor %s", pin_name);
+            return -1.0f;
         }
     }
 
@@ -4,6 +4,7 @@
 #include "driver/gpio.h"
 #include "cJSON.h"
 #include "esp_log.h"
+#include "config_image.h"
 
 /**
  * @brief Structure defining the device configuration.
@@ -17,6 +18,8 @@ typedef struct {
     size_t digital_inputs_len;    ///< Length of the digital inputs array.
     char **digital_inputs_names;  ///< Array of names for digital inputs.
     size_t digital_inputs_names_len; ///< Length of the digital inputs names array.
+    int *interrupt_inputs;        ///< Digital input GPIO pins captured by interrupt instead of polling.
+    size_t interrupt_inputs_len;  ///< Length of the interrupt inputs array.
     int *digital_outputs;         ///< Array of digital output GPIO pins.
     size_t digital_outputs_len;   ///< Length of the digital outputs array.
     char **digital_outputs_names; ///< Array of names for digital outputs.
@@ -53,11 +56,34 @@ typedef struct {
     int *spi;                     ///< Array of SPI interface pins.
     size_t spi_len;               ///< Length of the SPI array.
     bool usb;                     ///< Indicates if the device has USB support.
+    int scan_period_ms;           ///< PLC scan cycle period in milliseconds (optional, defaults to 10).
 
     char **parent_devices;        ///< Array of parent device identifiers.
     size_t parent_devices_len;    ///< Length of the parent devices array.
+    bool parent_encoding_cbor;    ///< Send parent updates as CBOR ("parent_encoding": "cbor") instead of JSON.
 } Device;
 
+/**
+ * @brief Class of a named device pin.
+ */
+typedef enum {
+    PIN_CLASS_DIGITAL_INPUT,  ///< Entry of digital_inputs.
+    PIN_CLASS_DIGITAL_OUTPUT, ///< Entry of digital_outputs.
+    PIN_CLASS_ANALOG_INPUT,   ///< Entry of analog_inputs.
+    PIN_CLASS_DAC_OUTPUT,     ///< Entry of dac_outputs.
+    PIN_CLASS_ONE_WIRE        ///< Device on one of the one_wire_inputs buses.
+} PinClass;
+
+/**
+ * @brief Resolved information about a named device pin.
+ */
+typedef struct {
+    gpio_num_t gpio;          ///< GPIO number of the pin (bus GPIO for one-wire devices).
+    PinClass pin_class;       ///< Class of the pin.
+    uint16_t group;           ///< Index in the class array (one-wire bus index).
+    uint16_t index;           ///< Device index on the one-wire bus, 0 otherwise.
+} PinInfo;
+
 /**
  * @brief Global variable holding the device configuration.
  */
@@ -76,12 +102,33 @@ void print_device_info(void);
  */
 bool find_pin_by_name(const char *pin_name, gpio_num_t *pin);
 
+/**
+ * @brief Finds the resolved information of a pin based on its name.
+ * @param pin_name Name of the pin to find.
+ * @param info Pointer to store the pin information.
+ * @return bool True if the pin is found, false otherwise.
+ */
+bool find_pin_info(const char *pin_name, PinInfo *info);
+
 /**
  * @brief Initializes the device configuration from a JSON object.
  * @param device JSON object containing the device configuration.
  */
 void device_init(cJSON *device);
 
+/**
+ * @brief Initializes the device configuration from a compiled configuration image.
+ * @param r Image reader positioned at the device section.
+ * @return bool True on success, false if the image is malformed.
+ */
+bool device_init_from_image(ImageReader *r);
+
+/**
+ * @brief Appends the device configuration to a compiled configuration image.
+ * @param w Image writer.
+ */
+void device_config_write_image(ImageWriter *w);
+
 /**
  * @brief Gets the value of a digital input pin by its name.
  * @param pin_name Name of the digital input pin.
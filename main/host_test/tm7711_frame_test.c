@@ -0,0 +1,118 @@
+/*
+ * Host check of the TM7711 framing: a simulated chip is clocked the way the SPI backend clocks
+ * it (mode 1 at TM7711_SPI_CLOCK_HZ), and the received bits are decoded with tm7711_frame_decode.
+ * Not part of the firmware build; run from the main directory with
+ *
+ *     gcc -std=gnu11 -Wall -I. host_test/tm7711_frame_test.c tm7711_frame.c -o tm7711_frame_test && ./tm7711_frame_test
+ */
+#include "tm7711_frame.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief Number of failed checks.
+ */
+static int failures = 0;
+
+/**
+ * @brief Reports a failed check without stopping the run.
+ */
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+/**
+ * @brief State of the simulated chip during a readout.
+ */
+typedef struct {
+    uint32_t sample;        ///< Conversion result shifted out MSB first.
+    int bit;                ///< Data bits shifted out so far.
+    int mode_pulses;        ///< PD_SCK pulses after the data bits, which select the next mode.
+    int dout;               ///< Level of DOUT.
+    double dout_valid_ns;   ///< Time from which DOUT holds the current bit.
+    bool powered_down;      ///< PD_SCK stayed high long enough to power the chip down.
+    bool sampled_early;     ///< DOUT was sampled before it settled.
+} SimulatedChip;
+
+/**
+ * @brief Clocks a readout out of the simulated chip like an SPI mode 1 master.
+ *
+ * On each rising edge of PD_SCK the chip drives the next bit on DOUT within
+ * TM7711_DOUT_VALID_MAX_NS; the master samples DOUT on the falling edge.
+ * @param chip Pointer to the simulated chip.
+ * @param clock_hz PD_SCK frequency.
+ * @param bits Number of PD_SCK pulses.
+ * @param rx Receives the sampled bits, MSB first; 4 bytes.
+ */
+static void clock_readout(SimulatedChip *chip, uint32_t clock_hz, int bits, uint8_t *rx) {
+    double half_ns = 1e9 / clock_hz / 2;
+    double t = 0;
+    memset(rx, 0, 4);
+    for (int i = 0; i < bits; i++) {
+        // Rising edge: the next data bit, or DOUT pulled high during the mode pulses
+        if (chip->bit < TM7711_DATA_BITS) {
+            chip->dout = (chip->sample >> (TM7711_DATA_BITS - 1 - chip->bit)) & 1;
+            chip->bit++;
+        } else {
+            chip->dout = 1;
+            chip->mode_pulses++;
+        }
+        chip->dout_valid_ns = t + TM7711_DOUT_VALID_MAX_NS;
+        if (half_ns >= 60000) chip->powered_down = true;
+
+        // Falling edge: the master samples DOUT
+        t += half_ns;
+        if (t < chip->dout_valid_ns) chip->sampled_early = true;
+        if (chip->dout) rx[i / 8] |= 0x80 >> (i % 8);
+        t += half_ns;
+    }
+}
+
+/**
+ * @brief Checks the clock limits of tm7711_clock_valid.
+ */
+static void test_clock_valid(void) {
+    CHECK(tm7711_clock_valid(TM7711_SPI_CLOCK_HZ));
+    CHECK(tm7711_clock_valid(20000));
+    CHECK(!tm7711_clock_valid(0));
+    CHECK(!tm7711_clock_valid(5000));      // High phase long enough to power the chip down
+    CHECK(!tm7711_clock_valid(5000000));   // Phases shorter than the datasheet minimum
+}
+
+/**
+ * @brief Reads samples in every mode and checks the decoded value and the mode pulses.
+ */
+static void test_readout(void) {
+    const unsigned char modes[] = { CH1_10HZ, CH1_40HZ, CH2_TEMP };
+    const int mode_pulses[] = { 1, 3, 2 };
+    const uint32_t samples[] = { 0x000000, 0x000001, 0x800000, 0xFFFFFF, 0xABCDEF, 0x123456 };
+
+    for (size_t m = 0; m < sizeof(modes); m++) {
+        int bits = tm7711_frame_bits(modes[m]);
+        CHECK(bits > TM7711_DATA_BITS && bits <= 32);
+        for (size_t s = 0; s < sizeof(samples) / sizeof(samples[0]); s++) {
+            SimulatedChip chip = { .sample = samples[s] };
+            uint8_t rx[4];
+            clock_readout(&chip, TM7711_SPI_CLOCK_HZ, bits, rx);
+            CHECK(tm7711_frame_decode(rx) == samples[s]);
+            CHECK(chip.mode_pulses == mode_pulses[m]);
+            CHECK(!chip.powered_down);
+            CHECK(!chip.sampled_early);
+        }
+    }
+    CHECK(tm7711_frame_bits(0) == 0);
+}
+
+int main(void) {
+    test_clock_valid();
+    test_readout();
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("tm7711_frame: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "json_stream.h"
+#include <string.h>
+
+void json_stream_reset(JsonStream *stream) {
+    memset(stream, 0, sizeof(*stream));
+    stream->status = JSON_STREAM_INCOMPLETE;
+}
+
+JsonStreamStatus json_stream_feed(JsonStream *stream, const char *data, size_t len) {
+    for (size_t i = 0; i < len && stream->status == JSON_STREAM_INCOMPLETE; i++) {
+        char c = data[i];
+        stream->consumed++;
+
+        if (stream->in_string) {
+            if (stream->escape) {
+                stream->escape = false;
+            } else if (c == '\\') {
+                stream->escape = true;
+            } else if (c == '"') {
+                stream->in_string = false;
+            }
+            continue;
+        }
+
+        switch (c) {
+            case '"':
+                if (!stream->started) {
+                    stream->status = JSON_STREAM_ERROR;
+                }
+                stream->in_string = true;
+                break;
+            case '{':
+            case '[':
+                // Push the container kind
+                if (stream->depth >= JSON_STREAM_MAX_DEPTH) {
+                    stream->status = JSON_STREAM_ERROR;
+                    break;
+                }
+                stream->kinds = (stream->kinds << 1) | (c == '{' ? 1u : 0u);
+                stream->depth++;
+                stream->started = true;
+                break;
+            case '}':
+            case ']':
+                // Pop and check that the closer matches the opener
+                if (stream->depth == 0 || (stream->kinds & 1u) != (c == '}' ? 1u : 0u)) {
+                    stream->status = JSON_STREAM_ERROR;
+                    break;
+                }
+                stream->kinds >>= 1;
+                stream->depth--;
+                if (stream->depth == 0) {
+                    stream->status = JSON_STREAM_COMPLETE;
+                }
+                break;
+            case ' ':
+            case '\t':
+            case '\r':
+            case '\n':
+                break;
+            default:
+                // Scalars are validated by the final parse; only a bare top-level value is rejected here
+                if (!stream->started) {
+                    stream->status = JSON_STREAM_ERROR;
+                }
+                break;
+        }
+    }
+    return stream->status;
+}
+
+/**
+ * @brief FNV-1a 64-bit offset basis.
+ */
+#define FINGERPRINT_BASIS 14695981039346656037ull
+
+/**
+ * @brief FNV-1a 64-bit prime.
+ */
+#define FINGERPRINT_PRIME 1099511628211ull
+
+/**
+ * @brief Folds bytes into a fingerprint.
+ * @param hash Fingerprint so far.
+ * @param data Bytes to add.
+ * @param len Number of bytes.
+ * @return uint64_t Updated fingerprint.
+ */
+static uint64_t fingerprint_bytes(uint64_t hash, const void *data, size_t len) {
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= FINGERPRINT_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief Folds a JSON value and its children into a fingerprint.
+ * @param hash Fingerprint so far.
+ * @param item Parsed value.
+ * @return uint64_t Updated fingerprint.
+ */
+static uint64_t fingerprint_item(uint64_t hash, const cJSON *item) {
+    // Type without the reference flags; keys and strings include their terminator
+    uint8_t type = (uint8_t)(item->type & 0xFF);
+    hash = fingerprint_bytes(hash, &type, 1);
+    if (item->string) {
+        hash = fingerprint_bytes(hash, item->string, strlen(item->string) + 1);
+    }
+    if (cJSON_IsString(item) && item->valuestring) {
+        hash = fingerprint_bytes(hash, item->valuestring, strlen(item->valuestring) + 1);
+    } else if (cJSON_IsNumber(item)) {
+        hash = fingerprint_bytes(hash, &item->valuedouble, sizeof(item->valuedouble));
+    } else if (cJSON_IsArray(item) || cJSON_IsObject(item)) {
+        for (const cJSON *child = item->child; child; child = child->next) {
+            hash = fingerprint_item(hash, child);
+        }
+        // Close the container so [[1],2] and [[1,2]] differ
+        uint8_t end = 0xFF;
+        hash = fingerprint_bytes(hash, &end, 1);
+    }
+    return hash;
+}
+
+uint64_t json_fingerprint(const cJSON *item) {
+    return item ? fingerprint_item(FINGERPRINT_BASIS, item) : FINGERPRINT_BASIS;
+}
@@ -0,0 +1,68 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cJSON.h>
+
+/**
+ * @brief Maximum container nesting depth tracked by the stream scanner.
+ */
+#define JSON_STREAM_MAX_DEPTH 64
+
+/**
+ * @brief Result of feeding a chunk to the stream scanner.
+ */
+typedef enum {
+    JSON_STREAM_INCOMPLETE, ///< More data is needed to close the top-level value.
+    JSON_STREAM_COMPLETE,   ///< The top-level value is closed.
+    JSON_STREAM_ERROR       ///< The data cannot be the start of a valid JSON document.
+} JsonStreamStatus;
+
+/**
+ * @brief Resumable structural scanner for a JSON document received in chunks.
+ *
+ * Each byte is inspected exactly once; strings and escapes are tracked so that
+ * brackets inside string values are ignored, and the bracket kinds are checked
+ * with a bit stack so mismatched closers are rejected early.
+ */
+typedef struct {
+    uint64_t kinds;         ///< Bit stack of open containers (1 = object, 0 = array).
+    uint16_t depth;         ///< Current nesting depth.
+    bool started;           ///< True once the top-level '{' or '[' was seen.
+    bool in_string;         ///< True while inside a string literal.
+    bool escape;            ///< True if the previous string byte was a backslash.
+    JsonStreamStatus status; ///< Status after the last consumed byte.
+    size_t consumed;        ///< Total bytes consumed, including the closing bracket.
+} JsonStream;
+
+/**
+ * @brief Resets a scanner to wait for a new document.
+ * @param stream Pointer to the scanner.
+ */
+void json_stream_reset(JsonStream *stream);
+
+/**
+ * @brief Feeds the next chunk of the document to the scanner.
+ *
+ * Bytes after the closing bracket of the top-level value are ignored.
+ * @param stream Pointer to the scanner.
+ * @param data Chunk data.
+ * @param len Chunk length in bytes.
+ * @return JsonStreamStatus Status of the document after this chunk.
+ */
+JsonStreamStatus json_stream_feed(JsonStream *stream, const char *data, size_t len);
+
+/**
+ * @brief Computes a 64-bit fingerprint of a parsed JSON value.
+ *
+ * Covers types, keys, strings, numbers and element order, so two values have the same
+ * fingerprint exactly when they serialize to the same JSON (barring hash collisions).
+ * Used to find the sections and wires that changed between two configurations.
+ * @param item Parsed value, or NULL.
+ * @return uint64_t Fingerprint of the value.
+ */
+uint64_t json_fingerprint(const cJSON *item);
+
+#endif // JSON_STREAM_H
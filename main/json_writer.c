@@ -0,0 +1,192 @@
+#include "json_writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include "esp_log.h"
+
+/**
+ * @brief Tag for logging messages from the JSON writer module.
+ */
+static const char *TAG = "JSON_WRITER";
+
+/**
+ * @brief Appends bytes to the document, counting those that do not fit.
+ * @param w Pointer to the writer.
+ * @param data Bytes to append.
+ * @param len Number of bytes.
+ */
+static void put(JsonWriter *w, const char *data, size_t len) {
+    if (w->buf && w->len < w->size) {
+        size_t room = w->size - w->len;
+        memcpy(w->buf + w->len, data, len < room ? len : room);
+    }
+    w->len += len;
+}
+
+/**
+ * @brief Appends a single character to the document.
+ * @param w Pointer to the writer.
+ * @param c Character to append.
+ */
+static void put_char(JsonWriter *w, char c) {
+    if (w->buf && w->len < w->size) {
+        w->buf[w->len] = c;
+    }
+    w->len++;
+}
+
+/**
+ * @brief Writes the separator before a value if one is needed at this level.
+ * @param w Pointer to the writer.
+ */
+static void begin_value(JsonWriter *w) {
+    if (w->need_comma) put_char(w, ',');
+    w->need_comma = true;
+}
+
+/**
+ * @brief Writes a quoted and escaped string.
+ * @param w Pointer to the writer.
+ * @param str String to write.
+ */
+static void put_quoted(JsonWriter *w, const char *str) {
+    put_char(w, '"');
+    const char *run = str;
+    for (const char *p = str; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        // Flush the unescaped run before the escape sequence
+        put(w, run, (size_t)(p - run));
+        run = p + 1;
+        switch (c) {
+            case '"': put(w, "\\\"", 2); break;
+            case '\\': put(w, "\\\\", 2); break;
+            case '\b': put(w, "\\b", 2); break;
+            case '\f': put(w, "\\f", 2); break;
+            case '\n': put(w, "\\n", 2); break;
+            case '\r': put(w, "\\r", 2); break;
+            case '\t': put(w, "\\t", 2); break;
+            default: {
+                char esc[7];
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                put(w, esc, 6);
+                break;
+            }
+        }
+    }
+    put(w, run, strlen(run));
+    put_char(w, '"');
+}
+
+void json_writer_init(JsonWriter *w, char *buf, size_t size) {
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->need_comma = false;
+}
+
+size_t json_writer_finish(JsonWriter *w) {
+    if (w->buf && w->size > 0) {
+        w->buf[w->len < w->size ? w->len : w->size - 1] = '\0';
+    }
+    return w->len;
+}
+
+void json_writer_begin_object(JsonWriter *w) {
+    begin_value(w);
+    put_char(w, '{');
+    w->need_comma = false;
+}
+
+void json_writer_end_object(JsonWriter *w) {
+    put_char(w, '}');
+    w->need_comma = true;
+}
+
+void json_writer_begin_array(JsonWriter *w) {
+    begin_value(w);
+    put_char(w, '[');
+    w->need_comma = false;
+}
+
+void json_writer_end_array(JsonWriter *w) {
+    put_char(w, ']');
+    w->need_comma = true;
+}
+
+void json_writer_key(JsonWriter *w, const char *key) {
+    begin_value(w);
+    put_quoted(w, key ? key : "");
+    put_char(w, ':');
+    w->need_comma = false;
+}
+
+void json_writer_string(JsonWriter *w, const char *value) {
+    begin_value(w);
+    if (value) put_quoted(w, value);
+    else put(w, "null", 4);
+}
+
+void json_writer_number(JsonWriter *w, double value) {
+    begin_value(w);
+    char num[26];
+    int len;
+
+    // Same rules as cJSON: integers without a fraction, otherwise the shortest exact form
+    if (isnan(value) || isinf(value)) {
+        len = snprintf(num, sizeof(num), "null");
+    } else if (value >= INT_MIN && value <= INT_MAX && value == (double)(int)value) {
+        len = snprintf(num, sizeof(num), "%d", (int)value);
+    } else {
+        len = snprintf(num, sizeof(num), "%1.15g", value);
+        if (strtod(num, NULL) != value) {
+            len = snprintf(num, sizeof(num), "%1.17g", value);
+        }
+    }
+    put(w, num, (size_t)len);
+}
+
+void json_writer_bool(JsonWriter *w, bool value) {
+    begin_value(w);
+    if (value) put(w, "true", 4);
+    else put(w, "false", 5);
+}
+
+void json_writer_add_string(JsonWriter *w, const char *key, const char *value) {
+    json_writer_key(w, key);
+    json_writer_string(w, value);
+}
+
+void json_writer_add_number(JsonWriter *w, const char *key, double value) {
+    json_writer_key(w, key);
+    json_writer_number(w, value);
+}
+
+void json_writer_add_bool(JsonWriter *w, const char *key, bool value) {
+    json_writer_key(w, key);
+    json_writer_bool(w, value);
+}
+
+bool json_buffer_fill(JsonBuffer *jb, JsonWriteFn write) {
+    size_t len = write(jb->data, jb->capacity);
+    if (len == 0) return false;
+
+    if (len >= jb->capacity) {
+        // Grow with headroom so small fluctuations do not reallocate again
+        size_t capacity = len + 1 + len / 4;
+        char *data = realloc(jb->data, capacity);
+        if (!data) {
+            ESP_LOGE(TAG, "Failed to grow JSON buffer to %u bytes", (unsigned)capacity);
+            return false;
+        }
+        jb->data = data;
+        jb->capacity = capacity;
+        len = write(jb->data, jb->capacity);
+        if (len == 0 || len >= jb->capacity) return false;
+    }
+    jb->len = len;
+    return true;
+}
@@ -0,0 +1,138 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Streaming JSON formatter writing straight into a caller-provided buffer.
+ *
+ * No tree is built: values are formatted in a single pass as they are added.
+ * Like snprintf, the writer keeps counting once the buffer is full, so the
+ * length returned by json_writer_finish tells the caller how much space the
+ * whole document needs.
+ */
+typedef struct {
+    char *buf;        ///< Output buffer, may be NULL to only measure.
+    size_t size;      ///< Size of the output buffer in bytes.
+    size_t len;       ///< Length of the document so far, including bytes that did not fit.
+    bool need_comma;  ///< True if a value was already written at the current level.
+} JsonWriter;
+
+/**
+ * @brief Grow-only heap buffer reused between serializations.
+ */
+typedef struct {
+    char *data;       ///< NUL-terminated document, or NULL before the first fill.
+    size_t capacity;  ///< Allocated size of data in bytes.
+    size_t len;       ///< Length of the last document, excluding the terminator.
+} JsonBuffer;
+
+/**
+ * @brief Function formatting a document into a buffer, with snprintf-style return value.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return size_t Length of the full document, or 0 if there is nothing to write.
+ */
+typedef size_t (*JsonWriteFn)(char *buf, size_t size);
+
+/**
+ * @brief Starts a document in the given buffer.
+ * @param w Pointer to the writer.
+ * @param buf Output buffer, or NULL to only measure.
+ * @param size Size of the output buffer.
+ */
+void json_writer_init(JsonWriter *w, char *buf, size_t size);
+
+/**
+ * @brief Terminates the document.
+ * @param w Pointer to the writer.
+ * @return size_t Length of the full document; it was truncated if this is >= the buffer size.
+ */
+size_t json_writer_finish(JsonWriter *w);
+
+/**
+ * @brief Opens an object, as an array element or after json_writer_key.
+ * @param w Pointer to the writer.
+ */
+void json_writer_begin_object(JsonWriter *w);
+
+/**
+ * @brief Closes the current object.
+ * @param w Pointer to the writer.
+ */
+void json_writer_end_object(JsonWriter *w);
+
+/**
+ * @brief Opens an array, as an array element or after json_writer_key.
+ * @param w Pointer to the writer.
+ */
+void json_writer_begin_array(JsonWriter *w);
+
+/**
+ * @brief Closes the current array.
+ * @param w Pointer to the writer.
+ */
+void json_writer_end_array(JsonWriter *w);
+
+/**
+ * @brief Writes an object key; the next value written belongs to it.
+ * @param w Pointer to the writer.
+ * @param key Key string (escaped as needed).
+ */
+void json_writer_key(JsonWriter *w, const char *key);
+
+/**
+ * @brief Writes a string value; NULL is written as null.
+ * @param w Pointer to the writer.
+ * @param value String value.
+ */
+void json_writer_string(JsonWriter *w, const char *value);
+
+/**
+ * @brief Writes a numeric value, formatted the same way cJSON prints numbers.
+ * @param w Pointer to the writer.
+ * @param value Numeric value.
+ */
+void json_writer_number(JsonWriter *w, double value);
+
+/**
+ * @brief Writes a boolean value.
+ * @param w Pointer to the writer.
+ * @param value Boolean value.
+ */
+void json_writer_bool(JsonWriter *w, bool value);
+
+/**
+ * @brief Writes a string member of the current object.
+ * @param w Pointer to the writer.
+ * @param key Member name.
+ * @param value String value.
+ */
+void json_writer_add_string(JsonWriter *w, const char *key, const char *value);
+
+/**
+ * @brief Writes a numeric member of the current object.
+ * @param w Pointer to the writer.
+ * @param key Member name.
+ * @param value Numeric value.
+ */
+void json_writer_add_number(JsonWriter *w, const char *key, double value);
+
+/**
+ * @brief Writes a boolean member of the current object.
+ * @param w Pointer to the writer.
+ * @param key Member name.
+ * @param value Boolean value.
+ */
+void json_writer_add_bool(JsonWriter *w, const char *key, bool value);
+
+/**
+ * @brief Formats a document into a reusable buffer, growing it once if the document does not fit.
+ * @param jb Pointer to the buffer; jb->data and jb->len hold the document on success.
+ * @param write Function formatting the document.
+ * @return bool True if a non-empty document was written, false if there was nothing to write or on allocation failure.
+ */
+bool json_buffer_fill(JsonBuffer *jb, JsonWriteFn write);
+
+#endif // JSON_WRITER_H
@@ -9,453 +9,426 @@
 
 #include "device_config.h"
 #include "variables.h"
+#include "timer_wheel.h"
 
 /**
  * @brief Tag for logging messages from the ladder logic module.
  */
 static const char *TAG = "LADDER";
 
-/**
- * @brief Structure to track the previous state for one-shot positive coils.
- */
-typedef struct {
-    char var_name[MAX_VAR_NAME_LENGTH]; ///< Name of the variable.
-    bool prev_state;                    ///< Previous state of the variable.
-} OneShotState;
-
-/**
- * @brief Structure to track the state of timers.
- */
-typedef struct {
-    char var_name[MAX_VAR_NAME_LENGTH]; ///< Name of the timer variable.
-    int64_t start_time;                 ///< Start time in microseconds.
-    bool running;                       ///< Indicates if the timer is active.
-} TimerState;
-
-/**
- * @brief Array to store one-shot states.
- */
-static OneShotState one_shot_states[MAX_ONE_SHOT_STATES] = {0};
 
 /**
- * @brief Current number of one-shot states.
- */
-static size_t one_shot_count = 0;
-
-/**
- * @brief Array to store timer states.
- */
-static TimerState timer_states[MAX_TIMER_STATES] = {0};
-
-/**
- * @brief Current number of timer states.
- */
-static size_t timer_state_count = 0;
-
-/**
- * @brief Helper function to find or add a one-shot state for a variable.
- * @param var_name Name of the variable.
- * @return bool* Pointer to the previous state, or NULL if the limit is exceeded.
- */
-static bool *get_one_shot_state(const char *var_name) {
-    // Check if the state already exists
-    for (size_t i = 0; i < one_shot_count; i++) {
-        if (strcmp(one_shot_states[i].var_name, var_name) == 0) {
-            return &one_shot_states[i].prev_state;
-        }
-    }
-    // Add a new state if within limits
-    if (one_shot_count < MAX_ONE_SHOT_STATES) {
-        strncpy(one_shot_states[one_shot_count].var_name, var_name, MAX_VAR_NAME_LENGTH - 1);
-        one_shot_states[one_shot_count].var_name[MAX_VAR_NAME_LENGTH - 1] = '\0';
-        one_shot_states[one_shot_count].prev_state = false;
-        one_shot_count++;
-        return &one_shot_states[one_shot_count - 1].prev_state;
-    }
-    ESP_LOGE(TAG, "Too many one-shot states for %s", var_name);
-    return NULL;
-}
-
-/**
- * @brief Helper function to find or add a timer state for a variable.
- * @param var_name Name of the timer variable.
- * @return TimerState* Pointer to the timer state, or NULL if the limit is exceeded.
- */
-static TimerState *get_timer_state(const char *var_name) {
-    // Check if the state already exists
-    for (size_t i = 0; i < timer_state_count; i++) {
-        if (strcmp(timer_states[i].var_name, var_name) == 0) {
-            return &timer_states[i];
-        }
-    }
-    // Add a new state if within limits
-    if (timer_state_count < MAX_TIMER_STATES) {
-        strncpy(timer_states[timer_state_count].var_name, var_name, MAX_VAR_NAME_LENGTH - 1);
-        timer_states[timer_state_count].var_name[MAX_VAR_NAME_LENGTH - 1] = '\0';
-        timer_states[timer_state_count].start_time = 0;
-        timer_states[timer_state_count].running = false;
-        timer_state_count++;
-        return &timer_states[timer_state_count - 1];
-    }
-    ESP_LOGE(TAG, "Too many timer states for %s", var_name);
-    return NULL;
-}
-
-/**
- * @brief Detects a rising edge (transition from false to true) for a variable.
- * @param var_name Name of the variable.
+ * @brief Detects a rising edge (transition from false to true) of a condition.
+ * @param prev_state Edge state slot of the instruction, holding the previous condition.
  * @param condition Current condition to evaluate.
  * @return bool True if a rising edge is detected, false otherwise.
  */
-bool r_trig(const char *var_name, bool condition) {
-    bool *prev_state = get_one_shot_state(var_name);
-    if (!prev_state) {
-        return false;
-    }
-
+bool r_trig(bool *prev_state, bool condition) {
     bool result = condition && !(*prev_state);
     *prev_state = condition;
-
-    // Log the rising edge detection (commented out)
-    // ESP_LOGI(TAG, "R_TRIG: %s condition=%d, result=%d", var_name, condition, result);
     return result;
 }
 
 /**
- * @brief Detects a falling edge (transition from true to false) for a variable.
- * @param var_name Name of the variable.
+ * @brief Detects a falling edge (transition from true to false) of a condition.
+ * @param prev_state Edge state slot of the instruction, holding the previous condition.
  * @param condition Current condition to evaluate.
  * @return bool True if a falling edge is detected, false otherwise.
  */
-bool f_trig(const char *var_name, bool condition) {
-    bool *prev_state = get_one_shot_state(var_name);
-    if (!prev_state) {
-        return false;
-    }
-
+bool f_trig(bool *prev_state, bool condition) {
     bool result = !condition && (*prev_state);
     *prev_state = condition;
-
-    // Log the falling edge detection (commented out)
-    // ESP_LOGI(TAG, "F_TRIG: %s condition=%d, result=%d", var_name, condition, result);
     return result;
 }
 
 // ============== CONTACTS ===============
-bool no_contact(const char *var_name) {
-    bool result = read_variable(var_name);
+bool no_contact(VariableHandle var) {
+    bool result = read_variable_handle(var);
     // Log the NO contact state (commented out)
-    // ESP_LOGI(TAG, "NO Contact: %s value=%d", var_name, result);
+    // ESP_LOGI(TAG, "NO Contact: %s value=%d", get_variable_name(var), result);
     return !result;
 }
 
-bool nc_contact(const char *var_name) {
-    bool result = read_variable(var_name);
+bool nc_contact(VariableHandle var) {
+    bool result = read_variable_handle(var);
     // Log the NC contact state (commented out)
-    // ESP_LOGI(TAG, "NC Contact: %s value=%d", var_name, result);
+    // ESP_LOGI(TAG, "NC Contact: %s value=%d", get_variable_name(var), result);
     return result;
 }
 
 // =============== COILS =================
-void coil(const char *var_name, bool condition) {
+void coil(VariableHandle var, bool condition) {
     // Log the coil operation (commented out)
-    // ESP_LOGI(TAG, "Coil: %s value=%d", var_name, condition);
-    write_variable(var_name, condition);
+    // ESP_LOGI(TAG, "Coil: %s value=%d", get_variable_name(var), condition);
+    write_variable_handle(var, condition);
 }
 
-void one_shot_positive_coil(const char *var_name, bool condition) {
-    bool *prev_state = get_one_shot_state(var_name);
-    if (!prev_state) {
-        return;
-    }
-
-    bool output = condition && !(*prev_state);
-    *prev_state = condition;
+void one_shot_positive_coil(VariableHandle var, bool condition, bool *edge) {
+    bool output = r_trig(edge, condition);
 
     // Log the one-shot positive coil operation (commented out)
-    // ESP_LOGI(TAG, "One Shot Positive Coil: %s value=%d", var_name, output);
-    write_variable(var_name, output);
+    // ESP_LOGI(TAG, "One Shot Positive Coil: %s value=%d", get_variable_name(var), output);
+    write_variable_handle(var, output);
 }
 
-void set_coil(const char *var_name, bool condition) {
+void set_coil(VariableHandle var, bool condition) {
     if (condition) {
         // Log the set coil operation (commented out)
-        // ESP_LOGI(TAG, "Set Coil: %s value=%d", var_name, condition);
-        write_variable(var_name, true);
+        // ESP_LOGI(TAG, "Set Coil: %s value=%d", get_variable_name(var), condition);
+        write_variable_handle(var, true);
     }
 }
 
-void reset_coil(const char *var_name, bool condition) {
+void reset_coil(VariableHandle var, bool condition) {
     if (condition) {
         // Log the reset coil operation (commented out)
-        // ESP_LOGI(TAG, "Reset Coil: %s value=%d", var_name, condition);
-        write_variable(var_name, false);
+        // ESP_LOGI(TAG, "Reset Coil: %s value=%d", get_variable_name(var), condition);
+        write_variable_handle(var, false);
     }
 }
 
 // ============== MATH ===============
-void add(const char *var_name_a, const char *var_name_b, const char *var_name_c, bool condition) {
-    if (r_trig(var_name_c, condition)) {
-        double a = read_numeric_variable(var_name_a);
-        double b = read_numeric_variable(var_name_b);
+void add(VariableHandle var_a, VariableHandle var_b, VariableHandle var_c, bool condition, bool *edge) {
+    if (r_trig(edge, condition)) {
+        double a = read_numeric_variable_handle(var_a);
+        double b = read_numeric_variable_handle(var_b);
         // Log the add operation (commented out)
-        // ESP_LOGI(TAG, "Add: %s (%f) + %s (%f) => %s (%f)", var_name_a, a, var_name_b, b, var_name_c, a + b);
-        write_numeric_variable(var_name_c, a + b);
+        // ESP_LOGI(TAG, "Add: %s (%f) + %s (%f) => %s (%f)", get_variable_name(var_a), a, get_variable_name(var_b), b, get_variable_name(var_c), a + b);
+        write_numeric_variable_handle(var_c, a + b);
     }
 }
 
-void subtract(const char *var_name_a, const char *var_name_b, const char *var_name_c, bool condition) {
-    if (r_trig(var_name_c, condition))
+void subtract(VariableHandle var_a, VariableHandle var_b, VariableHandle var_c, bool condition, bool *edge) {
+    if (r_trig(edge, condition))
     {
-        double a = read_numeric_variable(var_name_a);
-        double b = read_numeric_variable(var_name_b);
+        double a = read_numeric_variable_handle(var_a);
+        double b = read_numeric_variable_handle(var_b);
         // Log the subtract operation (commented out)
-        // ESP_LOGI(TAG, "Subtract: %s (%f) - %s (%f) => %s (%f)", var_name_a, a, var_name_b, b, var_name_c, a - b);
-        write_numeric_variable(var_name_c, a - b);
+        // ESP_LOGI(TAG, "Subtract: %s (%f) - %s (%f) => %s (%f)", get_variable_name(var_a), a, get_variable_name(var_b), b, get_variable_name(var_c), a - b);
+        write_numeric_variable_handle(var_c, a - b);
     }
 }
 
-void multiply(const char *var_name_a, const char *var_name_b, const char *var_name_c, bool condition) {
-    if (r_trig(var_name_c, condition)) {
-        double a = read_numeric_variable(var_name_a);
-        double b = read_numeric_variable(var_name_b);
+void multiply(VariableHandle var_a, VariableHandle var_b, VariableHandle var_c, bool condition, bool *edge) {
+    if (r_trig(edge, condition)) {
+        double a = read_numeric_variable_handle(var_a);
+        double b = read_numeric_variable_handle(var_b);
         // Log the multiply operation (commented out)
-        // ESP_LOGI(TAG, "Multiply: %s (%f) * %s (%f) => %s (%f)", var_name_a, a, var_name_b, b, var_name_c, a * b);
-        write_numeric_variable(var_name_c, a * b);
+        // ESP_LOGI(TAG, "Multiply: %s (%f) * %s (%f) => %s (%f)", get_variable_name(var_a), a, get_variable_name(var_b), b, get_variable_name(var_c), a * b);
+        write_numeric_variable_handle(var_c, a * b);
     }
 }
 
-void divide(const char *var_name_a, const char *var_name_b, const char *var_name_c, bool condition) {
-    if (r_trig(var_name_c, condition)) {
-        double a = read_numeric_variable(var_name_a);
-        double b = read_numeric_variable(var_name_b);
+void divide(VariableHandle var_a, VariableHandle var_b, VariableHandle var_c, bool condition, bool *edge) {
+    if (r_trig(edge, condition)) {
+        double a = read_numeric_variable_handle(var_a);
+        double b = read_numeric_variable_handle(var_b);
 
         // Check for division by zero
         if (fabs(b) < 1e-6) {
             // Log division by zero error
-            ESP_LOGE(TAG, "Division by zero for %s", var_name_b);
+            ESP_LOGE(TAG, "Division by zero for %s", get_variable_name(var_b));
             return;
         }
 
         // Log the divide operation (commented out)
-        // ESP_LOGI(TAG, "Divide: %s (%f) / %s (%f) => %s (%f)", var_name_a, a, var_name_b, b, var_name_c, a / b);
-        write_numeric_variable(var_name_c, a / b);
+        // ESP_LOGI(TAG, "Divide: %s (%f) / %s (%f) => %s (%f)", get_variable_name(var_a), a, get_variable_name(var_b), b, get_variable_name(var_c), a / b);
+        write_numeric_variable_handle(var_c, a / b);
     }
 }
 
-void move(const char *var_name_a, const char *var_name_b, bool condition) {
-    double a = read_numeric_variable(var_name_a);
+void move(VariableHandle var_a, VariableHandle var_b, bool condition) {
+    double a = read_numeric_variable_handle(var_a);
     // Log the move operation (commented out)
-    // ESP_LOGI(TAG, "Move: %s (%f) => %s (%f)", var_name_a, a, var_name_b, a);
-    write_numeric_variable(var_name_b, a);
+    // ESP_LOGI(TAG, "Move: %s (%f) => %s (%f)", get_variable_name(var_a), a, get_variable_name(var_b), a);
+    write_numeric_variable_handle(var_b, a);
 }
 
 // ============== COMPARE ===============
-bool greater(const char *var_name_a, const char *var_name_b) {
-    double a = read_numeric_variable(var_name_a);
-    double b = read_numeric_variable(var_name_b);
+bool greater(VariableHandle var_a, VariableHandle var_b) {
+    double a = read_numeric_variable_handle(var_a);
+    double b = read_numeric_variable_handle(var_b);
     // Log the greater comparison (commented out)
-    // ESP_LOGI(TAG, "Greater: %s (%f) > %s (%f): %d", var_name_a, a, var_name_b, b, a > b);
+    // ESP_LOGI(TAG, "Greater: %s (%f) > %s (%f): %d", get_variable_name(var_a), a, get_variable_name(var_b), b, a > b);
     return a > b;
 }
 
-bool less(const char *var_name_a, const char *var_name_b) {
-    double a = read_numeric_variable(var_name_a);
-    double b = read_numeric_variable(var_name_b);
+bool less(VariableHandle var_a, VariableHandle var_b) {
+    double a = read_numeric_variable_handle(var_a);
+    double b = read_numeric_variable_handle(var_b);
     // Log the less comparison (commented out)
-    // ESP_LOGI(TAG, "Less: %s (%f) < %s (%f): %d", var_name_a, a, var_name_b, b, a < b);
+    // ESP_LOGI(TAG, "Less: %s (%f) < %s (%f): %d", get_variable_name(var_a), a, get_variable_name(var_b), b, a < b);
     return a < b;
 }
 
-bool greater_or_equal(const char *var_name_a, const char *var_name_b) {
-    double a = read_numeric_variable(var_name_a);
-    double b = read_numeric_variable(var_name_b);
+bool greater_or_equal(VariableHandle var_a, VariableHandle var_b) {
+    double a = read_numeric_variable_handle(var_a);
+    double b = read_numeric_variable_handle(var_b);
     // Log the greater or equal comparison (commented out)
-    // ESP_LOGI(TAG, "Greater Or Equal: %s (%f) >= %s (%f): %d", var_name_a, a, var_name_b, b, a >= b);
+    // ESP_LOGI(TAG, "Greater Or Equal: %s (%f) >= %s (%f): %d", get_variable_name(var_a), a, get_variable_name(var_b), b, a >= b);
     return a >= b;
 }
 
-bool less_or_equal(const char *var_name_a, const char *var_name_b) {
-    double a = read_numeric_variable(var_name_a);
-    double b = read_numeric_variable(var_name_b);
+bool less_or_equal(VariableHandle var_a, VariableHandle var_b) {
+    double a = read_numeric_variable_handle(var_a);
+    double b = read_numeric_variable_handle(var_b);
     // Log the less or equal comparison (commented out)
-    // ESP_LOGI(TAG, "Less Or Equal: %s (%f) <= %s (%f): %d", var_name_a, a, var_name_b, b, a <= b);
+    // ESP_LOGI(TAG, "Less Or Equal: %s (%f) <= %s (%f): %d", get_variable_name(var_a), a, get_variable_name(var_b), b, a <= b);
     return a <= b;
 }
 
-bool equal(const char *var_name_a, const char *var_name_b) {
-    double a = read_numeric_variable(var_name_a);
-    double b = read_numeric_variable(var_name_b);
+bool equal(VariableHandle var_a, VariableHandle var_b) {
+    double a = read_numeric_variable_handle(var_a);
+    double b = read_numeric_variable_handle(var_b);
     // Log the equal comparison (commented out)
-    // ESP_LOGI(TAG, "Equal: %s (%f) == %s (%f): %d", var_name_a, a, var_name_b, b, a == b);
+    // ESP_LOGI(TAG, "Equal: %s (%f) == %s (%f): %d", get_variable_name(var_a), a, get_variable_name(var_b), b, a == b);
     return a == b;
 }
 
-bool not_equal(const char *var_name_a, const char *var_name_b) {
-    double a = read_numeric_variable(var_name_a);
-    double b = read_numeric_variable(var_name_b);
+bool not_equal(VariableHandle var_a, VariableHandle var_b) {
+    double a = read_numeric_variable_handle(var_a);
+    double b = read_numeric_variable_handle(var_b);
     // Log the not equal comparison (commented out)
-    // ESP_LOGI(TAG, "Not Equal: %s (%f) != %s (%f): %d", var_name_a, a, var_name_b, b, a != b);
+    // ESP_LOGI(TAG, "Not Equal: %s (%f) != %s (%f): %d", get_variable_name(var_a), a, get_variable_name(var_b), b, a != b);
     return a != b;
 }
 
 // ======= COUNTERS / TIMERS ============
-void count_up(const char *var_name, bool condition) {
-    if (r_trig(var_name, condition)) {
-        VariableNode *node = find_variable(var_name);
+void count_up(VariableHandle var, bool condition, bool *edge) {
+    if (r_trig(edge, condition)) {
+        VariableNode *node = get_variable_node(var);
+        if (!node || node->type != VAR_TYPE_COUNTER) return;
         Counter *c = (Counter *)node->data;
         c->cv += 1.0; // Increment CV by 1.0
         c->qu = (c->cv >= c->pv); // Update QU
         c->qd = (c->cv <= 0.0);  // Update QD
+        mark_variable_dirty(var);
         // Log the counter increment (commented out)
-        // ESP_LOGI(TAG, "Counter: %s (cv: %f) incremented", var_name, c->cv);
+        // ESP_LOGI(TAG, "Counter: %s (cv: %f) incremented", get_variable_name(var), c->cv);
     }
 }
 
-void count_down(const char *var_name, bool condition) {
-    if (r_trig(var_name, condition)) {
-        VariableNode *node = find_variable(var_name);
+void count_down(VariableHandle var, bool condition, bool *edge) {
+    if (r_trig(edge, condition)) {
+        VariableNode *node = get_variable_node(var);
+        if (!node || node->type != VAR_TYPE_COUNTER) return;
         Counter *c = (Counter *)node->data;
         c->cv -= 1.0; // Decrement CV by 1.0
         c->qu = (c->cv >= c->pv); // Update QU
         c->qd = (c->cv <= 0.0);  // Update QD
+        mark_variable_dirty(var);
         // Log the counter decrement (commented out)
-        // ESP_LOGI(TAG, "Counter: %s (cv: %f) decremented", var_name, c->cv);
+        // ESP_LOGI(TAG, "Counter: %s (cv: %f) decremented", get_variable_name(var), c->cv);
     }
 }
 
-bool timer_on(const char *var_name, bool condition) {
-    VariableNode *node = find_variable(var_name);
+void count_edges(VariableHandle var, VariableHandle input, bool rising, bool up, bool condition, bool *edge) {
+    if (!variable_is_captured_input(input)) {
+        // The interrupt could not be attached: count once per scan like the plain counter
+        if (up) count_up(var, condition, edge);
+        else count_down(var, condition, edge);
+        return;
+    }
+    uint32_t edges = read_input_edges_handle(input, rising);
+    if (edges == 0) return;
+    VariableNode *node = get_variable_node(var);
+    if (!node || node->type != VAR_TYPE_COUNTER) return;
+    Counter *c = (Counter *)node->data;
+    c->cv += up ? (double)edges : -(double)edges; // Every edge since the last scan counts once
+    c->qu = (c->cv >= c->pv); // Update QU
+    c->qd = (c->cv <= 0.0);  // Update QD
+    mark_variable_dirty(var);
+}
 
-    Timer *t = (Timer *)node->data;
-    TimerState *state = get_timer_state(var_name);
-    if (!state) {
-        // Log failure to get timer state
-        ESP_LOGE(TAG, "Failed to get state for timer %s", var_name);
+/**
+ * @brief Converts a delay to whole wheel milliseconds, saturating long delays.
+ * @param ms Delay in milliseconds.
+ * @return uint32_t Delay rounded up to the next millisecond.
+ */
+static uint32_t wheel_delay(double ms) {
+    return ms >= (double)UINT32_MAX ? UINT32_MAX : (uint32_t)ceil(ms);
+}
+
+/**
+ * @brief Starts the delay of a timer on the timer wheel.
+ * @param t Pointer to the timer.
+ * @param off_delay True for an off-delay timer, false for an on-delay timer.
+ */
+static void timer_start(Timer *t, bool off_delay) {
+    t->start_us = esp_timer_get_time();
+    t->armed_pt = t->pt;
+    t->running = true;
+    t->off_delay = off_delay;
+    t->et = 0;
+    timer_wheel_schedule(t->base.index, wheel_delay(t->pt));
+}
+
+/**
+ * @brief Stops the delay of a timer if it is running.
+ * @param t Pointer to the timer.
+ */
+static void timer_stop(Timer *t) {
+    if (t->running) {
+        timer_wheel_cancel(t->base.index);
+        t->running = false;
+    }
+}
+
+/**
+ * @brief Ends the delay of a timer once PT has elapsed.
+ * @param t Pointer to the timer.
+ * @return bool True if the delay ended, false if it was re-armed for the remaining time.
+ */
+static bool timer_finish(Timer *t) {
+    double elapsed = (double)(esp_timer_get_time() - t->start_us) / 1000.0; // Microseconds to milliseconds
+    if (elapsed < t->pt) {
+        // PT was raised while running, or the delay was longer than the wheel can arm at once
+        t->armed_pt = t->pt;
+        timer_wheel_schedule(t->base.index, wheel_delay(t->pt - elapsed));
         return false;
     }
+    t->running = false;
+    t->et = t->pt;
+    t->q = !t->off_delay; // TON turns on, TOF turns off
+    return true;
+}
 
-    // Update input
-    t->in = condition;
+/**
+ * @brief Applies a PT changed while the timer is running.
+ * @param t Pointer to the running timer.
+ */
+static void timer_follow_preset(Timer *t) {
+    if (t->pt != t->armed_pt) {
+        timer_finish(t);
+    }
+}
 
-    // If PT <= 0, timer does not run
-    if (t->pt <= 0) {
-        t->et = 0;
-        t->q = false;
-        state->running = false;
-        // Log timer stopped due to invalid PT (commented out)
-        // ESP_LOGI(TAG, "TON: %s PT<=0, Q=false, ET=0", var_name);
-        return false;
+/**
+ * @brief Applies a timer expiry reported by the timer wheel.
+ * @param index Index of the timer variable.
+ */
+static void timer_expired(uint16_t index) {
+    VariableHandle var = { .index = index, .type = VAR_TYPE_TIMER, .member = VAR_MEMBER_Q };
+    VariableNode *node = get_variable_node(var);
+    if (!node || node->type != VAR_TYPE_TIMER) return;
+
+    Timer *t = (Timer *)node->data;
+    if (t->running && timer_finish(t)) {
+        mark_variable_dirty(var);
+        // Log timer expiry (commented out)
+        // ESP_LOGI(TAG, "Timer: %s expired, Q=%d", get_variable_name(var), t->q);
     }
+}
 
-    if (condition) {
-        if (!state->running && !t->q) { // Start timer only if not active and Q is false
-            state->start_time = esp_timer_get_time();
-            state->running = true;
-            // Log timer start (commented out)
-            // ESP_LOGI(TAG, "TON: %s started", var_name);
+void ladder_elements_dispatch_timers(void) {
+    timer_wheel_dispatch(timer_expired);
+}
+
+void ladder_elements_reset_states(void) {
+    // Timer ids are variable indices; the wheel drops the delays of the previous variables
+    if (!timer_wheel_reset(get_variables_count())) {
+        return;
+    }
+    // Timers carried over by a variables reload keep running for the time they have left
+    for (size_t i = 0; i < variable_store.timer_count; i++) {
+        Timer *t = &variable_store.timers[i];
+        if (t->running) {
+            double elapsed = (double)(esp_timer_get_time() - t->start_us) / 1000.0; // Microseconds to milliseconds
+            t->armed_pt = t->pt;
+            timer_wheel_schedule(t->base.index, elapsed < t->pt ? wheel_delay(t->pt - elapsed) : 0);
         }
+    }
+}
 
-        if (state->running) {
-            // Calculate elapsed time
-            int64_t current_time = esp_timer_get_time();
-            t->et = (double)(current_time - state->start_time) / 1000.0; // Microseconds to milliseconds
-            if (t->et > t->pt) {
-                t->et = t->pt; // Limit ET to PT
-                state->running = false; // Stop further counting
-            }
+bool timer_on(VariableHandle var, bool condition) {
+    VariableNode *node = get_variable_node(var);
+    if (!node || node->type != VAR_TYPE_TIMER) return false;
+
+    Timer *t = (Timer *)node->data;
+    bool prev_in = t->in, prev_q = t->q;
+    double prev_et = t->et;
 
-            // Check if PT is reached
-            t->q = (t->et >= t->pt);
+    // Update input
+    t->in = condition;
+
+    if (t->pt <= 0) {
+        // If PT <= 0, timer does not run
+        timer_stop(t);
+        t->et = 0;
+        t->q = false;
+    } else if (condition) {
+        if (!t->running && !t->q) {
+            // Start timer only if not active and Q is false; the wheel sets Q when PT is reached
+            timer_start(t, false);
+        } else if (t->running) {
+            timer_follow_preset(t);
         } else {
             // If timer is stopped (ET >= PT), maintain Q=true and ET=PT
             t->et = t->pt;
-            t->q = true;
         }
-
-        // Log timer state (commented out)
-        // ESP_LOGI(TAG, "TON: %s IN=%d, ET=%f, Q=%d", var_name, t->in, t->et, t->q);
     } else {
         // Reset timer
+        timer_stop(t);
         t->et = 0;
         t->q = false;
-        state->running = false;
-        // Log timer stop (commented out)
-        // ESP_LOGI(TAG, "TON: %s stopped, Q=false, ET=0", var_name);
     }
 
+    if (t->in != prev_in || t->q != prev_q || t->et != prev_et) {
+        mark_variable_dirty(var);
+    }
+    // Log timer state (commented out)
+    // ESP_LOGI(TAG, "TON: %s IN=%d, ET=%f, Q=%d", get_variable_name(var), t->in, t->et, t->q);
     return t->q;
 }
 
-bool timer_off(const char *var_name, bool condition) {
-    VariableNode *node = find_variable(var_name);
+bool timer_off(VariableHandle var, bool condition) {
+    VariableNode *node = get_variable_node(var);
+    if (!node || node->type != VAR_TYPE_TIMER) return false;
 
     Timer *t = (Timer *)node->data;
-    TimerState *state = get_timer_state(var_name);
-    if (!state) {
-        // Log failure to get timer state
-        ESP_LOGE(TAG, "Failed to get state for timer %s", var_name);
-        return false;
-    }
+    bool prev_in = t->in, prev_q = t->q;
+    double prev_et = t->et;
 
     // Update input
     t->in = condition;
 
-    // If PT <= 0, timer does not run
     if (t->pt <= 0) {
+        // If PT <= 0, timer does not run
+        timer_stop(t);
         t->et = 0;
         t->q = condition;
-        state->running = false;
-        // Log timer stopped due to invalid PT (commented out)
-        // ESP_LOGI(TAG, "TOF: %s PT<=0, Q=%d, ET=0", var_name, t->q);
-        return t->q;
-    }
-
-    if (condition) {
+    } else if (condition) {
         // When IN=true, Q=true and timer does not run
+        timer_stop(t);
         t->q = true;
         t->et = 0;
-        state->running = false;
-        // Log timer state when input is true (commented out)
-        // ESP_LOGI(TAG, "TOF: %s IN=true, Q=true, ET=0", var_name);
-    } else {
-        if (!state->running && t->q) { // Start timer only if Q is true
-            state->start_time = esp_timer_get_time();
-            state->running = true;
-            // Log timer start (commented out)
-            // ESP_LOGI(TAG, "TOF: %s started", var_name);
-        }
-
-        if (state->running) {
-            // Calculate elapsed time
-            int64_t current_time = esp_timer_get_time();
-            t->et = (double)(current_time - state->start_time) / 1000.0; // Microseconds to milliseconds
-            if (t->et > t->pt) {
-                t->et = t->pt; // Limit ET to PT
-                state->running = false; // Stop further counting
-            }
-
-            // Q remains true while ET < PT
-            t->q = (t->et < t->pt);
-        } else if (!t->q) {
-            // If timer is not running and Q=false, maintain ET=0
-            t->et = 0;
-        }
-
-        // Log timer state (commented out)
-        // ESP_LOGI(TAG, "TOF: %s IN=%d, ET=%f, Q=%d", var_name, t->in, t->et, t->q);
+    } else if (!t->running && t->q) {
+        // Start timer only if Q is true; the wheel clears Q when PT is reached
+        timer_start(t, true);
+    } else if (t->running) {
+        timer_follow_preset(t);
+    } else if (!t->q) {
+        // If timer is not running and Q=false, maintain ET=0
+        t->et = 0;
     }
 
+    if (t->in != prev_in || t->q != prev_q || t->et != prev_et) {
+        mark_variable_dirty(var);
+    }
+    // Log timer state (commented out)
+    // ESP_LOGI(TAG, "TOF: %s IN=%d, ET=%f, Q=%d", get_variable_name(var), t->in, t->et, t->q);
     return t->q;
 }
 
-void reset(const char *var_name, bool condition) {
-    if (r_trig(var_name, condition)) {
-        VariableNode *node = find_variable(var_name);
+void reset(VariableHandle var, bool condition, bool *edge) {
+    if (r_trig(edge, condition)) {
+        VariableNode *node = get_variable_node(var);
+        if (!node) return;
 
         if (node->type == VAR_TYPE_COUNTER) {
             Counter *c = (Counter *)node->data;
             bool action_taken = false;
+            sync_counter_pulses(c); // Pulses before the reset are cleared with it
 
             if (c->cu) {
                 c->cv = 0.0;
@@ -469,20 +442,19 @@ void reset(const char *var_name, bool condition) {
             if (action_taken) {
                 c->qu = (c->cv >= c->pv);
                 c->qd = (c->cv <= 0.0);
+                mark_variable_dirty(var);
             } 
             // Log counter reset
-            ESP_LOGI(TAG, "Counter: %s reset (cv: %f)", var_name, c->cv);
+            ESP_LOGI(TAG, "Counter: %s reset (cv: %f)", get_variable_name(var), c->cv);
         } else if (node->type == VAR_TYPE_TIMER) {
             Timer *t = (Timer *)node->data;
-            TimerState *state = get_timer_state(var_name);
-            if (state) {
-                t->et = 0;
-                t->q = false;
-                t->in = false;
-                state->running = false;
-                // Log timer reset
-                ESP_LOGI(TAG, "Timer: %s reset (ET=0, Q=false, IN=false)", var_name);
-            }
+            timer_stop(t);
+            t->et = 0;
+            t->q = false;
+            t->in = false;
+            mark_variable_dirty(var);
+            // Log timer reset
+            ESP_LOGI(TAG, "Timer: %s reset (ET=0, Q=false, IN=false)", get_variable_name(var));
         } 
     }
 }
\ No newline at end of file
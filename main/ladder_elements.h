@@ -2,186 +2,216 @@
 #define LADDER_ELEMENTS_H
 
 #include <stdbool.h>
+#include "variables.h"
 
 /**
- * @brief Maximum number of variables that can detect a rising edge (for mathematical operations, coils, one-shot coils, counters, timers, reset).
+ * @brief Re-keys the timer states to the current variables; must be called whenever variable handles are re-resolved.
+ *
+ * Pending delays of the previous variables are dropped, and timers that are still running
+ * (carried over by a variables reload) are re-armed for the time they have left. Edge
+ * states live in the compiled rungs, one slot per edge-detecting instruction.
  */
-#define MAX_ONE_SHOT_STATES 64
+void ladder_elements_reset_states(void);
 
 /**
- * @brief Maximum number of timer states.
+ * @brief Applies the timer expiries reported by the timer wheel since the previous call.
+ *
+ * Called by the scan cycle before the rungs run, so Q changes when PT is reached rather
+ * than on the first scan that happens to evaluate the timer afterwards.
  */
-#define MAX_TIMER_STATES 32
+void ladder_elements_dispatch_timers(void);
 
 /**
  * @brief Normally Open (NO) Contact: Returns true (active) when the associated signal is true, otherwise false (inactive).
- * @param var_name Name of the variable to check.
+ * @param var Handle of the variable to check.
  * @return bool True if the signal is active, false otherwise.
  */
-bool no_contact(const char *var_name);
+bool no_contact(VariableHandle var);
 
 /**
  * @brief Normally Closed (NC) Contact: Returns true (active) when the associated signal is false (inactive), otherwise false (inactive).
- * @param var_name Name of the variable to check.
+ * @param var Handle of the variable to check.
  * @return bool True if the signal is inactive, false otherwise.
  */
-bool nc_contact(const char *var_name);
+bool nc_contact(VariableHandle var);
 
 /**
  * @brief Coil: Writes the current value (true/false) to the target variable.
- * @param var_name Name of the target variable.
+ * @param var Handle of the target variable.
  * @param condition The condition value to write.
  */
-void coil(const char *var_name, bool condition);
+void coil(VariableHandle var, bool condition);
 
 /**
  * @brief One Shot Positive Coil: Writes true only on the rising edge (first time the signal becomes true), otherwise false.
- * @param var_name Name of the target variable.
+ * @param var Handle of the target variable.
  * @param condition The condition to evaluate for the rising edge.
+ * @param edge Edge state slot of the instruction.
  */
-void one_shot_positive_coil(const char *var_name, bool condition);
+void one_shot_positive_coil(VariableHandle var, bool condition, bool *edge);
 
 /**
  * @brief Set Coil: Writes true when the signal is true and retains the value until reset.
- * @param var_name Name of the target variable.
+ * @param var Handle of the target variable.
  * @param condition The condition to set the coil.
  */
-void set_coil(const char *var_name, bool condition);
+void set_coil(VariableHandle var, bool condition);
 
 /**
  * @brief Reset Coil: Writes false when the signal is true and retains the value until set.
- * @param var_name Name of the target variable.
+ * @param var Handle of the target variable.
  * @param condition The condition to reset the coil.
  */
-void reset_coil(const char *var_name, bool condition);
+void reset_coil(VariableHandle var, bool condition);
 
 /**
  * @brief Add: Performs addition (A + B = C).
- * @param var_name_a Name of the first input variable.
- * @param var_name_b Name of the second input variable.
- * @param var_name_c Name of the output variable.
+ * @param var_a Handle of the first input variable.
+ * @param var_b Handle of the second input variable.
+ * @param var_c Handle of the output variable.
  * @param condition Condition to enable the operation.
+ * @param edge Edge state slot of the instruction.
  */
-void add(const char *var_name_a, const char *var_name_b, const char *var_name_c, bool condition);
+void add(VariableHandle var_a, VariableHandle var_b, VariableHandle var_c, bool condition, bool *edge);
 
 /**
  * @brief Subtract: Performs subtraction (A - B = C).
- * @param var_name_a Name of the first input variable.
- * @param var_name_b Name of the second input variable.
- * @param var_name_c Name of the output variable.
+ * @param var_a Handle of the first input variable.
+ * @param var_b Handle of the second input variable.
+ * @param var_c Handle of the output variable.
  * @param condition Condition to enable the operation.
+ * @param edge Edge state slot of the instruction.
  */
-void subtract(const char *var_name_a, const char *var_name_b, const char *var_name_c, bool condition);
+void subtract(VariableHandle var_a, VariableHandle var_b, VariableHandle var_c, bool condition, bool *edge);
 
 /**
  * @brief Multiply: Performs multiplication (A * B = C).
- * @param var_name_a Name of the first input variable.
- * @param var_name_b Name of the second input variable.
- * @param var_name_c Name of the output variable.
+ * @param var_a Handle of the first input variable.
+ * @param var_b Handle of the second input variable.
+ * @param var_c Handle of the output variable.
  * @param condition Condition to enable the operation.
+ * @param edge Edge state slot of the instruction.
  */
-void multiply(const char *var_name_a, const char *var_name_b, const char *var_name_c, bool condition);
+void multiply(VariableHandle var_a, VariableHandle var_b, VariableHandle var_c, bool condition, bool *edge);
 
 /**
  * @brief Divide: Performs division (A / B = C).
- * @param var_name_a Name of the first input variable.
- * @param var_name_b Name of the second input variable.
- * @param var_name_c Name of the output variable.
+ * @param var_a Handle of the first input variable.
+ * @param var_b Handle of the second input variable.
+ * @param var_c Handle of the output variable.
  * @param condition Condition to enable the operation.
+ * @param edge Edge state slot of the instruction.
  */
-void divide(const char *var_name_a, const char *var_name_b, const char *var_name_c, bool condition);
+void divide(VariableHandle var_a, VariableHandle var_b, VariableHandle var_c, bool condition, bool *edge);
 
 /**
  * @brief Move: Copies the value of A to B.
- * @param var_name_a Name of the source variable.
- * @param var_name_b Name of the destination variable.
+ * @param var_a Handle of the source variable.
+ * @param var_b Handle of the destination variable.
  * @param condition Condition to enable the operation.
  */
-void move(const char *var_name_a, const char *var_name_b, bool condition);
+void move(VariableHandle var_a, VariableHandle var_b, bool condition);
 
 /**
  * @brief Greater: Checks if A is greater than B (A > B).
- * @param var_name_a Name of the first variable.
- * @param var_name_b Name of the second variable.
+ * @param var_a Handle of the first variable.
+ * @param var_b Handle of the second variable.
  * @return bool True if A > B, false otherwise.
  */
-bool greater(const char *var_name_a, const char *var_name_b);
+bool greater(VariableHandle var_a, VariableHandle var_b);
 
 /**
  * @brief Less: Checks if A is less than B (A < B).
- * @param var_name_a Name of the first variable.
- * @param var_name_b Name of the second variable.
+ * @param var_a Handle of the first variable.
+ * @param var_b Handle of the second variable.
  * @return bool True if A < B, false otherwise.
  */
-bool less(const char *var_name_a, const char *var_name_b);
+bool less(VariableHandle var_a, VariableHandle var_b);
 
 /**
  * @brief Greater or Equal: Checks if A is greater than or equal to B (A >= B).
- * @param var_name_a Name of the first variable.
- * @param var_name_b Name of the second variable.
+ * @param var_a Handle of the first variable.
+ * @param var_b Handle of the second variable.
  * @return bool True if A >= B, false otherwise.
  */
-bool greater_or_equal(const char *var_name_a, const char *var_name_b);
+bool greater_or_equal(VariableHandle var_a, VariableHandle var_b);
 
 /**
  * @brief Less or Equal: Checks if A is less than or equal to B (A <= B).
- * @param var_name_a Name of the first variable.
- * @param var_name_b Name of the second variable.
+ * @param var_a Handle of the first variable.
+ * @param var_b Handle of the second variable.
  * @return bool True if A <= B, false otherwise.
  */
-bool less_or_equal(const char *var_name_a, const char *var_name_b);
+bool less_or_equal(VariableHandle var_a, VariableHandle var_b);
 
 /**
  * @brief Equal: Checks if A is equal to B (A == B).
- * @param var_name_a Name of the first variable.
- * @param var_name_b Name of the second variable.
+ * @param var_a Handle of the first variable.
+ * @param var_b Handle of the second variable.
  * @return bool True if A == B, false otherwise.
  */
-bool equal(const char *var_name_a, const char *var_name_b);
+bool equal(VariableHandle var_a, VariableHandle var_b);
 
 /**
  * @brief Not Equal: Checks if A is not equal to B (A != B).
- * @param var_name_a Name of the first variable.
- * @param var_name_b Name of the second variable.
+ * @param var_a Handle of the first variable.
+ * @param var_b Handle of the second variable.
  * @return bool True if A != B, false otherwise.
  */
-bool not_equal(const char *var_name_a, const char *var_name_b);
+bool not_equal(VariableHandle var_a, VariableHandle var_b);
 
 /**
  * @brief Count Up: Increments the counter variable.
- * @param var_name Name of the counter variable.
+ * @param var Handle of the counter variable.
  * @param condition Condition to enable counting.
+ * @param edge Edge state slot of the instruction.
  */
-void count_up(const char *var_name, bool condition);
+void count_up(VariableHandle var, bool condition, bool *edge);
 
 /**
  * @brief Count Down: Decrements the counter variable.
- * @param var_name Name of the counter variable.
+ * @param var Handle of the counter variable.
  * @param condition Condition to enable counting.
+ * @param edge Edge state slot of the instruction.
  */
-void count_down(const char *var_name, bool condition);
+void count_down(VariableHandle var, bool condition, bool *edge);
+
+/**
+ * @brief Counts the edges of an interrupt input captured since the previous scan.
+ *
+ * Replaces a contact/counter pair on a captured input, so pulses shorter than the scan
+ * period are all counted instead of at most one per scan.
+ * @param var Handle of the counter variable.
+ * @param input Handle of the captured digital input.
+ * @param rising True to count rising edges, false for falling edges.
+ * @param up True to increment the counter, false to decrement it.
+ * @param condition Condition of the contact, counted on its rising edge if the input is not captured.
+ * @param edge Edge state slot of the instruction, used when the input is not captured.
+ */
+void count_edges(VariableHandle var, VariableHandle input, bool rising, bool up, bool condition, bool *edge);
 
 /**
  * @brief Timer On-Delay: Activates the timer with an on-delay mechanism.
- * @param var_name Name of the timer variable.
+ * @param var Handle of the timer variable.
  * @param condition Condition to start the timer.
  * @return bool True when the timer reaches its setpoint, false otherwise.
  */
-bool timer_on(const char *var_name, bool condition);
+bool timer_on(VariableHandle var, bool condition);
 
 /**
  * @brief Timer Off-Delay: Activates the timer with an off-delay mechanism.
- * @param var_name Name of the timer variable.
+ * @param var Handle of the timer variable.
  * @param condition Condition to start the timer.
  * @return bool True when the timer is active, false after the delay expires.
  */
-bool timer_off(const char *var_name, bool condition);
+bool timer_off(VariableHandle var, bool condition);
 
 /**
  * @brief Reset: Resets the specified variable (e.g., counter or timer).
- * @param var_name Name of the variable to reset.
+ * @param var Handle of the variable to reset.
  * @param condition Condition to trigger the reset.
+ * @param edge Edge state slot of the instruction.
  */
-void reset(const char *var_name, bool condition);
+void reset(VariableHandle var, bool condition, bool *edge);
 
 #endif // LADDER_ELEMENTS_H
\ No newline at end of file
@@ -0,0 +1,659 @@
+#include "ladder_program.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "ladder_elements.h"
+#include "arena.h"
+#include "json_stream.h"
+
+/**
+ * @brief Tag for logging messages from the ladder program module.
+ */
+static const char *TAG = "LADDER_PROGRAM";
+
+/**
+ * @brief Mapping of a ladder ElementType string to its opcode.
+ */
+typedef struct {
+    const char *element_type;   ///< ElementType string as sent by the desktop application.
+    LadderOpcode opcode;        ///< Opcode emitted for the element.
+    int operand_count;          ///< Number of required ComboBoxValues.
+} LadderElementDef;
+
+/**
+ * @brief Elements that may appear anywhere in a wire (contacts, comparisons, math, counters, timers).
+ */
+static const LadderElementDef element_defs[] = {
+    {"NOContact",             LADDER_OP_NO_CONTACT,       1},
+    {"NCContact",             LADDER_OP_NC_CONTACT,       1},
+    {"GreaterCompare",        LADDER_OP_GREATER,          2},
+    {"LessCompare",           LADDER_OP_LESS,             2},
+    {"GreaterOrEqualCompare", LADDER_OP_GREATER_OR_EQUAL, 2},
+    {"LessOrEqualCompare",    LADDER_OP_LESS_OR_EQUAL,    2},
+    {"EqualCompare",          LADDER_OP_EQUAL,            2},
+    {"NotEqualCompare",       LADDER_OP_NOT_EQUAL,        2},
+    {"AddMath",               LADDER_OP_ADD,              3},
+    {"SubtractMath",          LADDER_OP_SUBTRACT,         3},
+    {"MultiplyMath",          LADDER_OP_MULTIPLY,         3},
+    {"DivideMath",            LADDER_OP_DIVIDE,           3},
+    {"MoveMath",              LADDER_OP_MOVE,             2},
+    {"CountUp",               LADDER_OP_COUNT_UP,         1},
+    {"CountDown",             LADDER_OP_COUNT_DOWN,       1},
+    {"OnDelayTimer",          LADDER_OP_TIMER_ON,         1},
+    {"OffDelayTimer",         LADDER_OP_TIMER_OFF,        1},
+    {"Reset",                 LADDER_OP_RESET,            1},
+};
+
+/**
+ * @brief Elements that are only valid as the last node of a node list.
+ */
+static const LadderElementDef coil_defs[] = {
+    {"Coil",                LADDER_OP_COIL,                   1},
+    {"OneShotPositiveCoil", LADDER_OP_ONE_SHOT_POSITIVE_COIL, 1},
+    {"SetCoil",             LADDER_OP_SET_COIL,               1},
+    {"ResetCoil",           LADDER_OP_RESET_COIL,             1},
+};
+
+/**
+ * @brief Growable scratch instruction buffer used while compiling a single rung.
+ */
+typedef struct {
+    LadderInstruction *code;    ///< Instructions emitted so far.
+    size_t length;              ///< Number of emitted instructions.
+    size_t capacity;            ///< Capacity of the code array.
+    size_t edge_count;          ///< Number of edge state slots assigned so far.
+    bool failed;                ///< Set when an allocation failed.
+} RungBuilder;
+
+// Forward declaration
+static void compile_nodes(RungBuilder *builder, cJSON *nodes, bool in_branch, int depth);
+
+/**
+ * @brief Looks up an ElementType in a definition table.
+ * @param defs Definition table.
+ * @param count Number of entries in the table.
+ * @param element_type ElementType string.
+ * @return const LadderElementDef* Matching definition, or NULL if not found.
+ */
+static const LadderElementDef *find_element_def(const LadderElementDef *defs, size_t count, const char *element_type) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(defs[i].element_type, element_type) == 0) {
+            return &defs[i];
+        }
+    }
+    return NULL;
+}
+
+bool ladder_opcode_has_edge_state(uint8_t opcode) {
+    switch (opcode) {
+        case LADDER_OP_ADD:
+        case LADDER_OP_SUBTRACT:
+        case LADDER_OP_MULTIPLY:
+        case LADDER_OP_DIVIDE:
+        case LADDER_OP_COUNT_UP:
+        case LADDER_OP_COUNT_DOWN:
+        case LADDER_OP_COUNT_UP_EDGES:
+        case LADDER_OP_COUNT_DOWN_EDGES:
+        case LADDER_OP_RESET:
+        case LADDER_OP_ONE_SHOT_POSITIVE_COIL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Appends an instruction to the rung being compiled.
+ * @param builder Rung builder.
+ * @param opcode Opcode of the instruction.
+ * @return LadderInstruction* Pointer to the new instruction, or NULL on allocation failure.
+ */
+static LadderInstruction *emit(RungBuilder *builder, LadderOpcode opcode) {
+    if (builder->failed) {
+        return NULL;
+    }
+    if (builder->length >= builder->capacity) {
+        size_t new_capacity = builder->capacity ? builder->capacity * 2 : 8;
+        LadderInstruction *new_code = realloc(builder->code, new_capacity * sizeof(LadderInstruction));
+        if (!new_code) {
+            ESP_LOGE(TAG, "Memory allocation failed for rung code");
+            builder->failed = true;
+            return NULL;
+        }
+        builder->code = new_code;
+        builder->capacity = new_capacity;
+    }
+    LadderInstruction *instruction = &builder->code[builder->length++];
+    memset(instruction, 0, sizeof(*instruction));
+    instruction->opcode = opcode;
+    if (ladder_opcode_has_edge_state(opcode)) {
+        // Every edge-detecting instruction gets its own slot, even when several act on one variable
+        instruction->slot = (uint16_t)builder->edge_count++;
+    }
+    return instruction;
+}
+
+/**
+ * @brief Emits an element instruction with its variable operands resolved from ComboBoxValues.
+ * @param builder Rung builder.
+ * @param def Element definition.
+ * @param combo_values ComboBoxValues array of the node.
+ */
+static void emit_element(RungBuilder *builder, const LadderElementDef *def, cJSON *combo_values) {
+    const char *names[3] = {NULL, NULL, NULL};
+    for (int i = 0; i < def->operand_count; i++) {
+        cJSON *arg = cJSON_GetArrayItem(combo_values, i);
+        if (!arg || !cJSON_IsString(arg)) {
+            // Missing operands leave the condition unchanged, as an unknown element would
+            ESP_LOGW(TAG, "%s missing operand %d, ignoring element", def->element_type, i + 1);
+            return;
+        }
+        names[i] = arg->valuestring;
+    }
+
+    LadderInstruction *instruction = emit(builder, def->opcode);
+    if (!instruction) {
+        return;
+    }
+    for (int i = 0; i < def->operand_count; i++) {
+        if (!resolve_variable(names[i], &instruction->operands[i])) {
+            // Unknown variables read as false/0 and ignore writes
+            ESP_LOGE(TAG, "%s references unknown variable %s", def->element_type, names[i]);
+        }
+    }
+}
+
+/**
+ * @brief Turns a contact on a captured input followed by a counter into an edge counter.
+ *
+ * A counter fed by a single contact counts the edges of the contact's input, one per scan at
+ * most. For interrupt inputs the fused instruction counts every captured edge instead. The
+ * contact stays in place so the rest of the rung still sees its condition.
+ * @param builder Rung builder; the counter must be the instruction just emitted.
+ */
+static void fuse_edge_counter(RungBuilder *builder) {
+    if (builder->failed || builder->length != 2) {
+        return;
+    }
+    LadderInstruction *contact = &builder->code[0];
+    LadderInstruction *counter = &builder->code[1];
+    if ((counter->opcode != LADDER_OP_COUNT_UP && counter->opcode != LADDER_OP_COUNT_DOWN) ||
+        (contact->opcode != LADDER_OP_NO_CONTACT && contact->opcode != LADDER_OP_NC_CONTACT) ||
+        !variable_is_captured_input(contact->operands[0])) {
+        return;
+    }
+    counter->opcode = counter->opcode == LADDER_OP_COUNT_UP ? LADDER_OP_COUNT_UP_EDGES : LADDER_OP_COUNT_DOWN_EDGES;
+    counter->operands[1] = contact->operands[0];
+    // The counter keeps its slot for the per-scan fallback; NOContact reads inverted, so its
+    // rising condition is the input's falling edge
+    counter->edge = contact->opcode == LADDER_OP_NC_CONTACT ? LADDER_EDGE_RISING : LADDER_EDGE_FALLING;
+}
+
+/**
+ * @brief Checks whether a node is a coil-type LadderElement.
+ * @param node JSON object representing the node.
+ * @return bool True if the node is a coil, false otherwise.
+ */
+static bool is_coil_node(cJSON *node) {
+    cJSON *type = cJSON_GetObjectItem(node, "Type");
+    cJSON *element_type = cJSON_GetObjectItem(node, "ElementType");
+    return cJSON_IsString(type) && strcmp(type->valuestring, "LadderElement") == 0 &&
+           cJSON_IsString(element_type) &&
+           find_element_def(coil_defs, sizeof(coil_defs) / sizeof(coil_defs[0]), element_type->valuestring) != NULL;
+}
+
+/**
+ * @brief Compiles the trailing coil of a node list.
+ * @param builder Rung builder.
+ * @param node JSON object representing the coil node.
+ */
+static void compile_coil(RungBuilder *builder, cJSON *node) {
+    cJSON *element_type = cJSON_GetObjectItem(node, "ElementType");
+    cJSON *combo_values = cJSON_GetObjectItem(node, "ComboBoxValues");
+    if (!cJSON_IsArray(combo_values)) {
+        // Log error if coil is missing required fields
+        ESP_LOGE(TAG, "Coil missing ElementType or ComboBoxValues");
+        return;
+    }
+    const LadderElementDef *def = find_element_def(coil_defs, sizeof(coil_defs) / sizeof(coil_defs[0]), element_type->valuestring);
+    emit_element(builder, def, combo_values);
+}
+
+/**
+ * @brief Compiles a single non-coil node.
+ * @param builder Rung builder.
+ * @param node JSON object representing the node.
+ * @param depth Current branch nesting depth.
+ */
+static void compile_node(RungBuilder *builder, cJSON *node, int depth) {
+    cJSON *type = cJSON_IsObject(node) ? cJSON_GetObjectItem(node, "Type") : NULL;
+    if (!cJSON_IsString(type)) {
+        // Log error if node type is missing or invalid
+        ESP_LOGE(TAG, "Node missing Type or Type is not a string");
+        emit(builder, LADDER_OP_CLEAR);
+        return;
+    }
+
+    if (strcmp(type->valuestring, "LadderElement") == 0) {
+        cJSON *element_type = cJSON_GetObjectItem(node, "ElementType");
+        cJSON *combo_values = cJSON_GetObjectItem(node, "ComboBoxValues");
+
+        if (!cJSON_IsString(element_type) || !cJSON_IsArray(combo_values)) {
+            // Log error if LadderElement is missing required fields
+            ESP_LOGE(TAG, "LadderElement missing ElementType or ComboBoxValues");
+            emit(builder, LADDER_OP_CLEAR);
+            return;
+        }
+
+        const LadderElementDef *def = find_element_def(element_defs, sizeof(element_defs) / sizeof(element_defs[0]), element_type->valuestring);
+        if (!def) {
+            // Unknown elements (including coils that are not last) don't change the condition
+            ESP_LOGW(TAG, "Ignoring element %s", element_type->valuestring);
+            return;
+        }
+        emit_element(builder, def, combo_values);
+        fuse_edge_counter(builder);
+    } else if (strcmp(type->valuestring, "Branch") == 0) {
+        cJSON *nodes1 = cJSON_GetObjectItem(node, "Nodes1");
+        cJSON *nodes2 = cJSON_GetObjectItem(node, "Nodes2");
+
+        if (!cJSON_IsArray(nodes1) || !cJSON_IsArray(nodes2)) {
+            // Log error if Branch is missing required node arrays
+            ESP_LOGE(TAG, "Branch missing Nodes1 or Nodes2 arrays");
+            emit(builder, LADDER_OP_CLEAR);
+            return;
+        }
+        if (depth >= LADDER_MAX_BRANCH_DEPTH) {
+            ESP_LOGE(TAG, "Branch nesting deeper than %d", LADDER_MAX_BRANCH_DEPTH);
+            emit(builder, LADDER_OP_CLEAR);
+            return;
+        }
+
+        emit(builder, LADDER_OP_BRANCH_OPEN);
+        compile_nodes(builder, nodes1, true, depth + 1);
+        emit(builder, LADDER_OP_BRANCH_NEXT);
+        compile_nodes(builder, nodes2, true, depth + 1);
+        emit(builder, LADDER_OP_BRANCH_CLOSE);
+    } else {
+        // Log warning for unknown node type
+        ESP_LOGW(TAG, "Unknown node type: %s", type->valuestring);
+        emit(builder, LADDER_OP_CLEAR);
+    }
+}
+
+/**
+ * @brief Compiles a node list, treating a trailing coil specially.
+ * @param builder Rung builder.
+ * @param nodes JSON array of nodes.
+ * @param in_branch True if the list is a branch path; its coil then only runs while the path is active.
+ * @param depth Current branch nesting depth.
+ */
+static void compile_nodes(RungBuilder *builder, cJSON *nodes, bool in_branch, int depth) {
+    int node_count = cJSON_GetArraySize(nodes);
+    if (node_count == 0) {
+        // An empty node list is never active
+        emit(builder, LADDER_OP_CLEAR);
+        return;
+    }
+
+    cJSON *last_node = cJSON_GetArrayItem(nodes, node_count - 1);
+    cJSON *last_coil = is_coil_node(last_node) ? last_node : NULL;
+    if (last_coil) {
+        node_count--; // Exclude the coil from condition processing
+    }
+
+    for (int i = 0; i < node_count; i++) {
+        compile_node(builder, cJSON_GetArrayItem(nodes, i), depth);
+    }
+
+    if (last_coil) {
+        if (in_branch) {
+            // Log warning for unexpected coil inside a branch path
+            ESP_LOGW(TAG, "Unexpected coil in branch path");
+            LadderInstruction *jump = emit(builder, LADDER_OP_JUMP_IF_FALSE);
+            size_t coil_start = builder->length;
+            compile_coil(builder, last_coil);
+            if (jump) {
+                // Re-fetch the jump: emitting the coil may have moved the code array
+                builder->code[coil_start - 1].jump = (uint16_t)(builder->length - coil_start);
+            }
+        } else {
+            compile_coil(builder, last_coil);
+        }
+    }
+}
+
+/**
+ * @brief Finds an unclaimed rung of the running program compiled from the same wire.
+ * @param running Running program, or NULL.
+ * @param claimed Per-rung flags of the running rungs already reused.
+ * @param source Fingerprint of the wire.
+ * @return const LadderRung* Matching rung, now claimed, or NULL if there is none.
+ */
+static const LadderRung *claim_rung(const LadderProgram *running, bool *claimed, uint64_t source) {
+    if (!running || !claimed) {
+        return NULL;
+    }
+    for (size_t i = 0; i < running->rung_count; i++) {
+        if (!claimed[i] && running->rungs[i].source == source) {
+            claimed[i] = true;
+            return &running->rungs[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Compiles all wires, reusing the matching rungs of a running program.
+ * @param wires cJSON array of wire objects.
+ * @param running Running program to reuse rungs from, or NULL to compile everything.
+ * @param share_code True to share the instruction streams of reused rungs, false to recompile them.
+ * @param program Pointer to the program to fill.
+ * @return bool True if compilation succeeds, false otherwise.
+ */
+static bool compile_wires(cJSON *wires, const LadderProgram *running, bool share_code, LadderProgram *program) {
+    program->rungs = NULL;
+    program->rung_count = 0;
+
+    int wire_count = cJSON_GetArraySize(wires);
+    if (wire_count == 0) {
+        return true;
+    }
+
+    program->rungs = arena_calloc(&config_arena, wire_count, sizeof(LadderRung));
+    if (!program->rungs) {
+        ESP_LOGE(TAG, "Memory allocation failed for %d rungs", wire_count);
+        return false;
+    }
+    program->rung_count = wire_count;
+
+    // Each running rung is reused at most once, so duplicated wires do not share edge states
+    bool *claimed = running && running->rung_count ? calloc(running->rung_count, sizeof(bool)) : NULL;
+    size_t reused = 0;
+
+    RungBuilder builder = {0};
+    for (int i = 0; i < wire_count; i++) {
+        cJSON *wire = cJSON_GetArrayItem(wires, i);
+        LadderRung *rung = &program->rungs[i];
+        rung->source = json_fingerprint(wire);
+
+        const LadderRung *previous = claim_rung(running, claimed, rung->source);
+        if (previous && share_code) {
+            // Same wire and same handles: the running instruction stream and edge states carry over
+            *rung = *previous;
+            reused++;
+            continue;
+        }
+
+        cJSON *nodes = cJSON_IsObject(wire) ? cJSON_GetObjectItem(wire, "Nodes") : NULL;
+        if (!cJSON_IsArray(nodes)) {
+            // A wire without nodes compiles to an empty rung
+            ESP_LOGE(TAG, "Invalid or missing Nodes array in wire %d", i);
+            continue;
+        }
+
+        // Compile into the heap scratch buffer, then copy the exact-size stream into the arena
+        builder.length = 0;
+        builder.edge_count = 0;
+        compile_nodes(&builder, nodes, false, 0);
+        LadderInstruction *code = NULL;
+        bool *edge_states = NULL;
+        if (!builder.failed && builder.length > 0) {
+            code = arena_alloc(&config_arena, builder.length * sizeof(LadderInstruction));
+            if (code) {
+                memcpy(code, builder.code, builder.length * sizeof(LadderInstruction));
+            }
+        }
+        if (!builder.failed && builder.edge_count > 0) {
+            edge_states = arena_calloc(&config_arena, builder.edge_count, sizeof(bool));
+        }
+        if (builder.failed || (builder.length > 0 && !code) || (builder.edge_count > 0 && !edge_states)) {
+            ESP_LOGE(TAG, "Memory allocation failed for wire %d", i);
+            free(builder.code);
+            free(claimed);
+            ladder_program_free(program);
+            return false;
+        }
+        if (previous) {
+            // The same wire assigns the same slots, so its edges survive the new handles
+            if (previous->edge_count == builder.edge_count && builder.edge_count > 0) {
+                memcpy(edge_states, previous->edge_states, builder.edge_count * sizeof(bool));
+            }
+            reused++;
+        }
+        rung->code = code;
+        rung->length = builder.length;
+        rung->edge_states = edge_states;
+        rung->edge_count = builder.edge_count;
+        ESP_LOGI(TAG, "Compiled wire %d into %zu instructions", i, builder.length);
+    }
+
+    if (running) {
+        ESP_LOGI(TAG, "Kept %zu of %d wires unchanged", reused, wire_count);
+    }
+    free(builder.code);
+    free(claimed);
+    return true;
+}
+
+bool ladder_program_compile(cJSON *wires, LadderProgram *program) {
+    // Timer states are keyed by handle, which is only valid for the current variables
+    ladder_elements_reset_states();
+    return compile_wires(wires, NULL, false, program);
+}
+
+bool ladder_program_update(cJSON *wires, const LadderProgram *running, bool relink, LadderProgram *program) {
+    if (relink) {
+        // Handles changed: re-key the timers before any rung can run again
+        ladder_elements_reset_states();
+    }
+    return compile_wires(wires, running, !relink, program);
+}
+
+void ladder_program_free(LadderProgram *program) {
+    // Rungs and instruction streams live in config_arena and are released by arena_reset
+    program->rungs = NULL;
+    program->rung_count = 0;
+}
+
+void ladder_program_write_image(const LadderProgram *program, ImageWriter *w) {
+    image_write_u32(w, (uint32_t)program->rung_count);
+    for (size_t i = 0; i < program->rung_count; i++) {
+        const LadderRung *rung = &program->rungs[i];
+        image_write_u64(w, rung->source);
+        image_write_u32(w, (uint32_t)rung->length);
+        for (size_t pc = 0; pc < rung->length; pc++) {
+            const LadderInstruction *in = &rung->code[pc];
+            image_write_u8(w, in->opcode);
+            image_write_u16(w, in->jump); // Also holds edge
+            image_write_u16(w, in->slot);
+            for (int k = 0; k < 3; k++) {
+                image_write_u16(w, in->operands[k].index);
+                image_write_u8(w, in->operands[k].type);
+                image_write_u8(w, in->operands[k].member);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Checks that a loaded rung has valid opcodes, jumps, edge slots and branch nesting.
+ * @param rung Pointer to the rung.
+ * @return bool True if the rung is safe to execute.
+ */
+static bool validate_rung(const LadderRung *rung) {
+    size_t sp = 0;
+    for (size_t pc = 0; pc < rung->length; pc++) {
+        const LadderInstruction *in = &rung->code[pc];
+        if (ladder_opcode_has_edge_state(in->opcode) && in->slot >= rung->edge_count) {
+            return false;
+        }
+        switch (in->opcode) {
+            case LADDER_OP_BRANCH_OPEN:
+            case LADDER_OP_BRANCH_NEXT:
+                if (++sp > 2 * LADDER_MAX_BRANCH_DEPTH) return false;
+                break;
+            case LADDER_OP_BRANCH_CLOSE:
+                if (sp < 2) return false;
+                sp -= 2;
+                break;
+            case LADDER_OP_JUMP_IF_FALSE:
+                if (pc + in->jump >= rung->length) return false;
+                break;
+            case LADDER_OP_COUNT_UP_EDGES:
+            case LADDER_OP_COUNT_DOWN_EDGES:
+                if (in->edge > LADDER_EDGE_RISING) return false;
+                break;
+            default:
+                if (in->opcode >= LADDER_OPCODE_COUNT) return false;
+                break;
+        }
+    }
+    return sp == 0;
+}
+
+bool ladder_program_read_image(ImageReader *r, LadderProgram *program) {
+    program->rungs = NULL;
+    program->rung_count = 0;
+
+    // Timer states are keyed by handle, which is only valid for the current variables
+    ladder_elements_reset_states();
+
+    // Each serialized rung takes at least 12 bytes (fingerprint and length)
+    size_t rung_count = image_read_count(r, 12);
+    if (r->failed) {
+        return false;
+    }
+    if (rung_count == 0) {
+        return true;
+    }
+
+    LadderRung *rungs = arena_calloc(&config_arena, rung_count, sizeof(LadderRung));
+    if (!rungs) {
+        ESP_LOGE(TAG, "Memory allocation failed for %zu rungs", rung_count);
+        return false;
+    }
+
+    for (size_t i = 0; i < rung_count && !r->failed; i++) {
+        uint64_t source = image_read_u64(r);
+        // Each serialized instruction takes 17 bytes
+        size_t length = image_read_count(r, 17);
+        LadderInstruction *code = length ? arena_alloc(&config_arena, length * sizeof(LadderInstruction)) : NULL;
+        if (r->failed || (length && !code)) {
+            r->failed = true;
+            break;
+        }
+        // Slots are numbered from 0 in every rung, one per edge-detecting instruction
+        size_t edge_count = 0;
+        for (size_t pc = 0; pc < length; pc++) {
+            LadderInstruction *in = &code[pc];
+            in->opcode = image_read_u8(r);
+            in->jump = image_read_u16(r);
+            in->slot = image_read_u16(r);
+            if (ladder_opcode_has_edge_state(in->opcode)) {
+                edge_count++;
+            }
+            for (int k = 0; k < 3; k++) {
+                in->operands[k].index = image_read_u16(r);
+                in->operands[k].type = image_read_u8(r);
+                in->operands[k].member = image_read_u8(r);
+            }
+        }
+        bool *edge_states = edge_count ? arena_calloc(&config_arena, edge_count, sizeof(bool)) : NULL;
+        if (edge_count && !edge_states) {
+            ESP_LOGE(TAG, "Memory allocation failed for edge states of wire %zu", i);
+            r->failed = true;
+            break;
+        }
+        rungs[i].code = code;
+        rungs[i].length = length;
+        rungs[i].edge_states = edge_states;
+        rungs[i].edge_count = edge_count;
+        rungs[i].source = source;
+        if (!validate_rung(&rungs[i])) {
+            ESP_LOGE(TAG, "Invalid instruction stream for wire %zu in configuration image", i);
+            r->failed = true;
+        }
+    }
+
+    if (r->failed) {
+        ESP_LOGE(TAG, "Malformed program section in configuration image");
+        return false;
+    }
+    program->rungs = rungs;
+    program->rung_count = rung_count;
+    return true;
+}
+
+void ladder_rung_execute(const LadderRung *rung) {
+    bool condition = true;
+    bool stack[2 * LADDER_MAX_BRANCH_DEPTH];
+    size_t sp = 0;
+
+    for (size_t pc = 0; pc < rung->length; pc++) {
+        const LadderInstruction *in = &rung->code[pc];
+        VariableHandle a = in->operands[0];
+        VariableHandle b = in->operands[1];
+        VariableHandle c = in->operands[2];
+        // Slots are validated for edge-detecting opcodes only, so no other opcode forms the pointer
+        bool *edge = ladder_opcode_has_edge_state(in->opcode) ? &rung->edge_states[in->slot] : NULL;
+
+        switch (in->opcode) {
+            // Contacts and comparisons
+            case LADDER_OP_NO_CONTACT:       condition &= no_contact(a); break;
+            case LADDER_OP_NC_CONTACT:       condition &= nc_contact(a); break;
+            case LADDER_OP_GREATER:          condition &= greater(a, b); break;
+            case LADDER_OP_LESS:             condition &= less(a, b); break;
+            case LADDER_OP_GREATER_OR_EQUAL: condition &= greater_or_equal(a, b); break;
+            case LADDER_OP_LESS_OR_EQUAL:    condition &= less_or_equal(a, b); break;
+            case LADDER_OP_EQUAL:            condition &= equal(a, b); break;
+            case LADDER_OP_NOT_EQUAL:        condition &= not_equal(a, b); break;
+
+            // Actions executed with the current condition
+            case LADDER_OP_ADD:        add(a, b, c, condition, edge); break;
+            case LADDER_OP_SUBTRACT:   subtract(a, b, c, condition, edge); break;
+            case LADDER_OP_MULTIPLY:   multiply(a, b, c, condition, edge); break;
+            case LADDER_OP_DIVIDE:     divide(a, b, c, condition, edge); break;
+            case LADDER_OP_MOVE:       move(a, b, condition); break;
+            case LADDER_OP_COUNT_UP:   count_up(a, condition, edge); break;
+            case LADDER_OP_COUNT_DOWN: count_down(a, condition, edge); break;
+            case LADDER_OP_COUNT_UP_EDGES:   count_edges(a, b, in->edge == LADDER_EDGE_RISING, true, condition, edge); break;
+            case LADDER_OP_COUNT_DOWN_EDGES: count_edges(a, b, in->edge == LADDER_EDGE_RISING, false, condition, edge); break;
+            case LADDER_OP_TIMER_ON:   condition &= timer_on(a, condition); break;
+            // Note: Uses = instead of &= because this timer sets true regardless of prior elements
+            case LADDER_OP_TIMER_OFF:  condition = timer_off(a, condition); break;
+            case LADDER_OP_RESET:      reset(a, condition, edge); break;
+
+            // Coils
+            case LADDER_OP_COIL:                   coil(a, condition); break;
+            case LADDER_OP_ONE_SHOT_POSITIVE_COIL: one_shot_positive_coil(a, condition, edge); break;
+            case LADDER_OP_SET_COIL:               set_coil(a, condition); break;
+            case LADDER_OP_RESET_COIL:             reset_coil(a, condition); break;
+
+            // Control flow
+            case LADDER_OP_CLEAR:
+                condition = false;
+                break;
+            case LADDER_OP_BRANCH_OPEN:
+            case LADDER_OP_BRANCH_NEXT:
+                stack[sp++] = condition;
+                condition = true;
+                break;
+            case LADDER_OP_BRANCH_CLOSE: {
+                // OR logic: at least one branch path must be active
+                bool second = condition;
+                bool first = stack[--sp];
+                condition = stack[--sp] && (first || second);
+                break;
+            }
+            case LADDER_OP_JUMP_IF_FALSE:
+                if (!condition) {
+                    pc += in->jump;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
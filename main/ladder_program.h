@@ -0,0 +1,157 @@
+#ifndef LADDER_PROGRAM_H
+#define LADDER_PROGRAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cJSON.h>
+
+#include "variables.h"
+#include "config_image.h"
+
+/**
+ * @brief Maximum nesting depth of Branch nodes inside a single wire.
+ */
+#define LADDER_MAX_BRANCH_DEPTH 16
+
+/**
+ * @brief Opcodes of the compiled ladder instruction stream.
+ */
+typedef enum {
+    LADDER_OP_NO_CONTACT,             ///< condition &= no_contact(A)
+    LADDER_OP_NC_CONTACT,             ///< condition &= nc_contact(A)
+    LADDER_OP_GREATER,                ///< condition &= A > B
+    LADDER_OP_LESS,                   ///< condition &= A < B
+    LADDER_OP_GREATER_OR_EQUAL,       ///< condition &= A >= B
+    LADDER_OP_LESS_OR_EQUAL,          ///< condition &= A <= B
+    LADDER_OP_EQUAL,                  ///< condition &= A == B
+    LADDER_OP_NOT_EQUAL,              ///< condition &= A != B
+    LADDER_OP_ADD,                    ///< C = A + B on rising edge of condition
+    LADDER_OP_SUBTRACT,               ///< C = A - B on rising edge of condition
+    LADDER_OP_MULTIPLY,               ///< C = A * B on rising edge of condition
+    LADDER_OP_DIVIDE,                 ///< C = A / B on rising edge of condition
+    LADDER_OP_MOVE,                   ///< B = A
+    LADDER_OP_COUNT_UP,               ///< Increment counter A on rising edge of condition
+    LADDER_OP_COUNT_DOWN,             ///< Decrement counter A on rising edge of condition
+    LADDER_OP_TIMER_ON,               ///< condition &= timer_on(A, condition)
+    LADDER_OP_TIMER_OFF,              ///< condition = timer_off(A, condition)
+    LADDER_OP_RESET,                  ///< Reset counter/timer A on rising edge of condition
+    LADDER_OP_COIL,                   ///< A = condition
+    LADDER_OP_ONE_SHOT_POSITIVE_COIL, ///< A = rising edge of condition
+    LADDER_OP_SET_COIL,               ///< A = true if condition
+    LADDER_OP_RESET_COIL,             ///< A = false if condition
+    LADDER_OP_CLEAR,                  ///< condition = false (invalid node in the source wire)
+    LADDER_OP_BRANCH_OPEN,            ///< Save condition, start first branch path with condition = true
+    LADDER_OP_BRANCH_NEXT,            ///< Save first path result, start second path with condition = true
+    LADDER_OP_BRANCH_CLOSE,           ///< condition = saved && (first path || second path)
+    LADDER_OP_JUMP_IF_FALSE,          ///< Skip the next `jump` instructions if condition is false
+    LADDER_OP_COUNT_UP_EDGES,         ///< Add the `edge` edges of captured input B to counter A
+    LADDER_OP_COUNT_DOWN_EDGES,       ///< Subtract the `edge` edges of captured input B from counter A
+    LADDER_OPCODE_COUNT               ///< Number of opcodes (not an instruction)
+} LadderOpcode;
+
+/**
+ * @brief Input edge counted by LADDER_OP_COUNT_UP_EDGES and LADDER_OP_COUNT_DOWN_EDGES.
+ */
+typedef enum {
+    LADDER_EDGE_FALLING = 0,          ///< Count falling edges (NOContact, which reads inverted).
+    LADDER_EDGE_RISING = 1            ///< Count rising edges (NCContact).
+} LadderEdge;
+
+/**
+ * @brief Single compiled ladder instruction.
+ */
+typedef struct {
+    uint8_t opcode;             ///< Instruction opcode (LadderOpcode).
+    union {
+        uint16_t jump;          ///< Number of instructions to skip for LADDER_OP_JUMP_IF_FALSE.
+        uint16_t edge;          ///< LadderEdge counted by the *_EDGES opcodes.
+    };
+    uint16_t slot;              ///< Edge state slot in the rung, for opcodes that detect a rising edge.
+    VariableHandle operands[3]; ///< Variable operands (A, B, C) in ComboBoxValues order, resolved at compile time.
+} LadderInstruction;
+
+/**
+ * @brief Compiled instruction stream of a single wire (rung).
+ */
+typedef struct {
+    LadderInstruction *code;    ///< Array of instructions.
+    size_t length;              ///< Number of instructions.
+    bool *edge_states;          ///< Previous condition of each edge-detecting instruction, by slot.
+    size_t edge_count;          ///< Number of edge state slots.
+    uint64_t source;            ///< json_fingerprint of the wire the rung was compiled from.
+} LadderRung;
+
+/**
+ * @brief Compiled ladder program made of all configured wires.
+ */
+typedef struct {
+    LadderRung *rungs;          ///< Array of compiled rungs, in Wires order.
+    size_t rung_count;          ///< Number of compiled rungs.
+} LadderProgram;
+
+/**
+ * @brief Checks whether an opcode keeps an edge state slot.
+ * @param opcode Instruction opcode.
+ * @return bool True for the opcodes acting on the rising edge of their condition.
+ */
+bool ladder_opcode_has_edge_state(uint8_t opcode);
+
+/**
+ * @brief Compiles the Wires array of a configuration into a flat instruction stream per wire.
+ *
+ * Variable operands are resolved to handles against the currently loaded variables, so the
+ * program must be recompiled whenever load_variables() is called. The rungs and their edge
+ * states are allocated from config_arena.
+ * @param wires cJSON array of wire objects.
+ * @param program Pointer to the program to fill; must be empty or freed.
+ * @return bool True if compilation succeeds, false otherwise.
+ */
+bool ladder_program_compile(cJSON *wires, LadderProgram *program);
+
+/**
+ * @brief Compiles the Wires array of a new configuration, keeping the rungs of unchanged wires.
+ *
+ * A wire identical to one of the running program keeps that rung's edge states. If the
+ * variables were not reloaded since the running program was compiled, the rung's instruction
+ * stream is shared as well and nothing is compiled for it. Otherwise (relink) every rung is
+ * recompiled against the new handles and the timer states are re-keyed. The running program
+ * is not modified and may keep executing until the new one is swapped in.
+ * @param wires cJSON array of wire objects.
+ * @param running Program currently executed by the scan cycle.
+ * @param relink True if the variables were reloaded since running was compiled.
+ * @param program Pointer to the program to fill; must not be running.
+ * @return bool True if compilation succeeds, false otherwise.
+ */
+bool ladder_program_update(cJSON *wires, const LadderProgram *running, bool relink, LadderProgram *program);
+
+/**
+ * @brief Drops a compiled program; its memory is released with config_arena.
+ * @param program Pointer to the program to clear.
+ */
+void ladder_program_free(LadderProgram *program);
+
+/**
+ * @brief Appends a compiled program to a compiled configuration image.
+ * @param program Pointer to the program.
+ * @param w Image writer.
+ */
+void ladder_program_write_image(const LadderProgram *program, ImageWriter *w);
+
+/**
+ * @brief Loads a compiled program from a configuration image into config_arena.
+ *
+ * Operand handles are taken as-is, so the variables must have been loaded from the same image.
+ * @param r Image reader positioned at the program section.
+ * @param program Pointer to the program to fill.
+ * @return bool True on success, false if the image is malformed.
+ */
+bool ladder_program_read_image(ImageReader *r, LadderProgram *program);
+
+/**
+ * @brief Executes one scan of a compiled rung.
+ * @param rung Pointer to the compiled rung.
+ */
+void ladder_rung_execute(const LadderRung *rung);
+
+#endif // LADDER_PROGRAM_H
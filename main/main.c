@@ -13,6 +13,7 @@
 
 #include "one_wire_detect.h"
 #include "conf_task_manager.h"
+#include "config_transfer.h"
 
 #include "ble.h"
 
@@ -46,13 +47,27 @@ void app_main(void)
         return;
     }
 
-    // Load configuration from NVS
-    char *nvs_data = NULL;
-    size_t nvs_data_len = 0;
-    ret = load_config_from_nvs(&nvs_data, &nvs_data_len);
-    if (ret == ESP_OK && nvs_data != NULL) {
-        configure(nvs_data, nvs_data_len, true); // Apply loaded configuration
-        free(nvs_data);                          // Free allocated memory
+    // Load the compiled configuration image from NVS; fall back to the JSON configuration
+    uint8_t *image = NULL;
+    size_t image_len = 0;
+    bool configured = false;
+    if (load_config_image_from_nvs(&image, &image_len) == ESP_OK) {
+        configured = configure_from_image(image, image_len); // Apply compiled configuration
+        free(image);                                         // Free allocated memory
+    }
+    if (!configured) {
+        char *nvs_data = NULL;
+        size_t nvs_data_len = 0;
+        ret = load_config_from_nvs(&nvs_data, &nvs_data_len);
+        if (ret == ESP_OK && nvs_data != NULL) {
+            configure(nvs_data, nvs_data_len, true); // Apply loaded configuration
+            free(nvs_data);                          // Free allocated memory
+        }
+    }
+
+    // Initialize framed configuration transfer before the BLE and MQTT receivers start
+    if (config_transfer_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize configuration transfer");
     }
 
     // Initialize Wi-Fi (includes NTP and MQTT initialization within wifi.c)
@@ -73,16 +88,7 @@ void app_main(void)
 
         // Publish sensor data if the application is connected via MQTT
         if(app_connected_mqtt) {
-            char *monitor_json = read_variables_json(); // Read variables as JSON
-            if (monitor_json) {
-                mqtt_publish(monitor_json, topics[TOPIC_IDX_MONITOR], MQTT_QOS); // Publish variables
-                free(monitor_json); // Free allocated memory
-            }
-            char *one_wire_json = search_for_one_wire_sensors(); // Read one-wire sensor data
-            if (one_wire_json) {
-                mqtt_publish(one_wire_json, topics[TOPIC_IDX_ONE_WIRE], MQTT_QOS); // Publish sensor data
-                free(one_wire_json); // Free allocated memory
-            }
+            mqtt_publish_monitor(); // Publish variables and one-wire sensor data
         } else if (app_connected_ble) {
             // Placeholder for BLE-specific functionality (currently empty)
         }
@@ -11,10 +11,14 @@
 #include "esp_mac.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "esp_system.h"
 #include "esp_wifi.h"
 #include "conf_task_manager.h"
+#include "config_transfer.h"
 #include "variables.h"
+#include "json_writer.h"
+#include "cbor.h"
 
 /**
  * @brief Tag for logging messages from the MQTT module.
@@ -36,6 +40,26 @@ esp_mqtt_client_handle_t mqtt_client;
  */
 bool app_connected_mqtt = false;
 
+/**
+ * @brief Flag indicating whether the connected application asked for delta monitor updates.
+ */
+bool app_monitor_delta = false;
+
+/**
+ * @brief Flag indicating whether the connected application asked for CBOR monitor frames.
+ */
+bool app_monitor_cbor = false;
+
+/**
+ * @brief Number of monitor publishes between full keyframes in delta mode (5 seconds at 100 ms).
+ */
+#define MONITOR_KEYFRAME_INTERVAL 50
+
+/**
+ * @brief Set on a new application connection so the monitor restarts with names and a keyframe.
+ */
+static volatile bool monitor_resync = true;
+
 /**
  * @brief Timestamp of the last received "Present" message.
  */
@@ -54,7 +78,36 @@ static char mac_str[13];
 /**
  * @brief Array to store MQTT topic strings, each with a maximum length of MAX_TOPIC_LEN.
  */
-char topics[8][MAX_TOPIC_LEN]; // Array for all topics
+char topics[TOPIC_COUNT][MAX_TOPIC_LEN]; // Array for all topics
+
+/**
+ * @brief Parses a connection request: "Connect" optionally followed by "Delta" and/or "Cbor".
+ * @param data Message data.
+ * @param len Message length.
+ * @param delta Pointer to store whether delta monitor updates were requested.
+ * @param cbor Pointer to store whether CBOR monitor frames were requested.
+ * @return bool True if the message is a connection request.
+ */
+static bool parse_connect_request(const char *data, int len, bool *delta, bool *cbor) {
+    static const char prefix[] = "Connect";
+    int pos = sizeof(prefix) - 1;
+    if (len < pos || strncmp(data, prefix, pos) != 0) return false;
+
+    *delta = false;
+    *cbor = false;
+    while (pos < len) {
+        if (len - pos >= 5 && strncmp(data + pos, "Delta", 5) == 0) {
+            *delta = true;
+            pos += 5;
+        } else if (len - pos >= 4 && strncmp(data + pos, "Cbor", 4) == 0) {
+            *cbor = true;
+            pos += 4;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
 
 /**
  * @brief Task to monitor the timeout for "Present" messages.
@@ -84,6 +137,7 @@ static void connection_timeout_task(void *pvParameters) {
  */
 static void mqtt_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
     esp_mqtt_event_handle_t event = event_data;
+    bool delta = false, cbor = false; // Options of a connection request
     switch (event_id) {
         case MQTT_EVENT_CONNECTED:
             // Handle successful connection to the MQTT broker
@@ -138,9 +192,12 @@ static void mqtt_event_handler(void *arg, esp_event_base_t event_base, int32_t e
                         connection_timeout_task_handle = NULL;
                     }
                 }
-                else if (!app_connected_mqtt && strncmp(event->data, "Connect", event->data_len) == 0){
-                    // Handle app connection
-                    ESP_LOGI(TAG, "App connected");
+                else if (!app_connected_mqtt && parse_connect_request(event->data, event->data_len, &delta, &cbor)){
+                    // Handle app connection; "Delta" selects delta monitor updates, "Cbor" binary frames
+                    app_monitor_delta = delta;
+                    app_monitor_cbor = cbor;
+                    monitor_resync = true;
+                    ESP_LOGI(TAG, "App connected (%s%s monitor)", cbor ? "cbor" : "json", delta ? " delta" : "");
                     app_connected_mqtt = true;
                     last_present_time = xTaskGetTickCount(); // Update presence time
                     mqtt_publish("Connected", topics[TOPIC_IDX_CONNECTION_RESPONSE], MQTT_QOS);
@@ -170,12 +227,27 @@ static void mqtt_event_handler(void *arg, esp_event_base_t event_base, int32_t e
             // Application sends configuration to the device
             else if (strncmp(event->topic, topics[TOPIC_IDX_CONFIG_RECEIVE], event->topic_len) == 0) 
             {
-                // Process received configuration
-                configure(event->data, event->data_len, false);
+                if (config_transfer_is_frame((const uint8_t *)event->data, event->data_len)) {
+                    // Framed transfer: write the chunk in place and acknowledge progress
+                    char ack[CONFIG_TRANSFER_ACK_LEN];
+                    if (config_transfer_handle_frame((const uint8_t *)event->data, event->data_len, ack, sizeof(ack))) {
+                        mqtt_publish(ack, topics[TOPIC_IDX_CONFIG_ACK], MQTT_QOS);
+                    }
+                } else {
+                    // Process received configuration
+                    configure(event->data, event->data_len, false);
+                }
             }
             // Update variables based on information received from remote devices
             else if (strncmp(event->topic, topics[TOPIC_IDX_CHILDREN_LISTENER], event->topic_len) == 0)
             {
+                // Binary updates start with a CBOR map head, JSON ones with '{'
+                uint8_t first = event->data_len > 0 ? (uint8_t)event->data[0] : 0;
+                if ((first >> 5) == CBOR_MAJOR_MAP) {
+                    update_variables_from_children_cbor((const uint8_t *)event->data, event->data_len);
+                    break;
+                }
+
                 // Update variables based on data from remote devices
                 char *json_buffer = strndup(event->data, event->data_len);
                 if (json_buffer == NULL) {
@@ -224,8 +296,9 @@ void mqtt_init() {
         TOPIC_CONFIG_RESPONSE,
         TOPIC_CONFIG_RECEIVE,
         TOPIC_CHILDREN_LISTENER,
+        TOPIC_CONFIG_ACK,
     };
-    for (int i = 0; i < 8; i++) {
+    for (int i = 0; i < TOPIC_COUNT; i++) {
         snprintf(topics[i], MAX_TOPIC_LEN, "%s%s", mac_str, suffixes[i]);
     }
 
@@ -239,6 +312,81 @@ void mqtt_publish(const char *message, const char* topic, int qos) {
         esp_mqtt_client_publish(mqtt_client, topic, message, 0, qos, 0);
 }
 
+void mqtt_publish_binary(const uint8_t *data, size_t len, const char *topic, int qos) {
+    // Publish payload if connected to the broker
+    if (mqtt_connected)
+        esp_mqtt_client_publish(mqtt_client, topic, (const char *)data, (int)len, qos, 0);
+}
+
+/**
+ * @brief Formats a JSON delta from the dirty bits of the MQTT monitor.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return size_t Length of the full document, or 0 if nothing changed.
+ */
+static size_t write_monitor_delta_json(char *buf, size_t size) {
+    return write_variables_delta_json(MONITOR_CONSUMER_MQTT, buf, size);
+}
+
+/**
+ * @brief Formats a CBOR delta from the dirty bits of the MQTT monitor.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return size_t Length of the full frame, or 0 if nothing changed.
+ */
+static size_t write_monitor_delta_cbor(uint8_t *buf, size_t size) {
+    return write_variables_delta_cbor(MONITOR_CONSUMER_MQTT, buf, size);
+}
+
+void mqtt_publish_monitor(void) {
+    // Frames are formatted into buffers reused for the whole session
+    static JsonBuffer json_buffer = {0};
+    static CborBuffer cbor_buffer = {0};
+    static int keyframe_countdown = 0;
+    static uint32_t names_generation = 0;
+    static bool names_sent = false;
+
+    if (monitor_resync) {
+        monitor_resync = false;
+        keyframe_countdown = 0;
+        names_sent = false;
+    }
+
+    // Keyframes are sent every cycle in full mode, periodically in delta mode
+    bool keyframe = !app_monitor_delta || keyframe_countdown-- <= 0;
+    if (keyframe && app_monitor_delta) {
+        variables_clear_dirty(MONITOR_CONSUMER_MQTT);
+        keyframe_countdown = MONITOR_KEYFRAME_INTERVAL;
+    }
+
+    if (app_monitor_cbor) {
+        // Binary clients get the index-to-name table once per configuration
+        if (!names_sent || names_generation != get_variables_generation()) {
+            if (cbor_buffer_fill(&cbor_buffer, write_variable_names_cbor)) {
+                mqtt_publish_binary(cbor_buffer.data, cbor_buffer.len, topics[TOPIC_IDX_MONITOR], MQTT_QOS);
+                names_generation = get_variables_generation();
+                names_sent = true;
+            }
+        }
+        if (cbor_buffer_fill(&cbor_buffer, keyframe ? write_variables_cbor : write_monitor_delta_cbor)) {
+            mqtt_publish_binary(cbor_buffer.data, cbor_buffer.len, topics[TOPIC_IDX_MONITOR], MQTT_QOS);
+        }
+        if (scan_one_wire_sensors() && cbor_buffer_fill(&cbor_buffer, write_one_wire_sensors_cbor)) {
+            mqtt_publish_binary(cbor_buffer.data, cbor_buffer.len, topics[TOPIC_IDX_ONE_WIRE], MQTT_QOS);
+        }
+        return;
+    }
+
+    if (json_buffer_fill(&json_buffer, keyframe ? write_variables_json : write_monitor_delta_json)) {
+        mqtt_publish(json_buffer.data, topics[TOPIC_IDX_MONITOR], MQTT_QOS); // Publish variables
+    }
+    char *one_wire_json = search_for_one_wire_sensors(); // Read one-wire sensor data
+    if (one_wire_json) {
+        mqtt_publish(one_wire_json, topics[TOPIC_IDX_ONE_WIRE], MQTT_QOS); // Publish sensor data
+        free(one_wire_json); // Free allocated memory
+    }
+}
+
 bool mqtt_is_connected(void) {
     return mqtt_connected;
 }
\ No newline at end of file
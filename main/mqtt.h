@@ -1,6 +1,8 @@
 #ifndef MQTT_H
 #define MQTT_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include "esp_system.h"
 
 #include "config.h"
@@ -23,6 +25,7 @@
 #define TOPIC_CONFIG_REQUEST "/config_request" ///< Suffix for configuration request topic.
 #define TOPIC_CONFIG_RESPONSE "/config_response" ///< Suffix for configuration response topic.
 #define TOPIC_CONFIG_RECEIVE "/config_device" ///< Suffix for receiving configuration topic.
+#define TOPIC_CONFIG_ACK "/config_ack" ///< Suffix for framed configuration transfer acknowledgements.
 
 #define TOPIC_CHILDREN_LISTENER "/children_listener" ///< Suffix for children listener topic.
 
@@ -48,19 +51,31 @@ enum {
     TOPIC_IDX_CONFIG_RESPONSE, ///< Index for configuration response topic.
     TOPIC_IDX_CONFIG_RECEIVE, ///< Index for configuration receive topic.
     TOPIC_IDX_CHILDREN_LISTENER, ///< Index for children listener topic.
+    TOPIC_IDX_CONFIG_ACK, ///< Index for configuration transfer acknowledgement topic.
+    TOPIC_COUNT ///< Number of topics.
 };
 
 /**
  * @brief External array to store MQTT topic strings.
- * @note Array of 8 topics, each with a maximum length of MAX_TOPIC_LEN.
+ * @note Array of TOPIC_COUNT topics, each with a maximum length of MAX_TOPIC_LEN.
  */
-extern char topics[8][MAX_TOPIC_LEN];
+extern char topics[TOPIC_COUNT][MAX_TOPIC_LEN];
 
 /**
  * @brief Flag indicating whether the application is connected to the MQTT broker.
  */
 extern bool app_connected_mqtt;
 
+/**
+ * @brief Flag indicating whether the connected application asked for delta monitor updates ("ConnectDelta").
+ */
+extern bool app_monitor_delta;
+
+/**
+ * @brief Flag indicating whether the connected application asked for CBOR monitor frames ("ConnectCbor").
+ */
+extern bool app_monitor_cbor;
+
 /**
  * @brief Initializes the MQTT client and sets up communication with the broker.
  */
@@ -74,6 +89,23 @@ void mqtt_init(void);
  */
 void mqtt_publish(const char *topic, const char *message, int qos);
 
+/**
+ * @brief Publishes a payload of explicit length, used for binary (CBOR) messages.
+ * @param data Payload bytes.
+ * @param len Payload length in bytes.
+ * @param topic The MQTT topic to publish to.
+ * @param qos Quality of Service level for the message.
+ */
+void mqtt_publish_binary(const uint8_t *data, size_t len, const char *topic, int qos);
+
+/**
+ * @brief Publishes the monitor and one-wire data to the connected application.
+ *
+ * Uses the encoding (JSON or CBOR) and mode (full or delta with periodic keyframes)
+ * the application chose in its connection request. Called every 100 ms while connected.
+ */
+void mqtt_publish_monitor(void);
+
 /**
  * @brief Checks if the MQTT client is connected to the broker.
  * @return bool True if connected, false otherwise.
@@ -0,0 +1,83 @@
+#include "name_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+uint32_t name_index_hash(const char *key) {
+    uint32_t hash = 2166136261u;
+    while (*key) {
+        hash ^= (uint8_t)*key++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool name_index_init(NameIndex *index, size_t expected_count, Arena *arena) {
+    // Keep the load factor at or below 50% so probe chains stay short
+    size_t capacity = 8;
+    while (capacity < expected_count * 2) {
+        capacity <<= 1;
+    }
+
+    index->heap_owned = (arena == NULL);
+    index->entries = arena ? arena_calloc(arena, capacity, sizeof(NameIndexEntry))
+                           : calloc(capacity, sizeof(NameIndexEntry));
+    if (!index->entries) {
+        index->capacity = 0;
+        index->count = 0;
+        return false;
+    }
+    index->capacity = capacity;
+    index->count = 0;
+    return true;
+}
+
+void name_index_free(NameIndex *index) {
+    if (index->heap_owned) {
+        free(index->entries);
+    }
+    index->entries = NULL;
+    index->capacity = 0;
+    index->count = 0;
+    index->heap_owned = false;
+}
+
+bool name_index_insert(NameIndex *index, const char *key, uint32_t value) {
+    if (!index->entries || !key || index->count + 1 >= index->capacity) {
+        return false;
+    }
+
+    uint32_t hash = name_index_hash(key);
+    size_t mask = index->capacity - 1;
+    for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+        NameIndexEntry *entry = &index->entries[slot];
+        if (!entry->key) {
+            entry->key = key;
+            entry->hash = hash;
+            entry->value = value;
+            index->count++;
+            return true;
+        }
+        if (entry->hash == hash && strcmp(entry->key, key) == 0) {
+            return false;
+        }
+    }
+}
+
+bool name_index_find(const NameIndex *index, const char *key, uint32_t *value) {
+    if (!index->entries || !key) {
+        return false;
+    }
+
+    uint32_t hash = name_index_hash(key);
+    size_t mask = index->capacity - 1;
+    for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+        const NameIndexEntry *entry = &index->entries[slot];
+        if (!entry->key) {
+            return false;
+        }
+        if (entry->hash == hash && strcmp(entry->key, key) == 0) {
+            *value = entry->value;
+            return true;
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+/**
+ * @brief Single slot of a name index.
+ */
+typedef struct {
+    const char *key;    ///< Name (not owned), or NULL if the slot is empty.
+    uint32_t hash;      ///< Cached FNV-1a hash of the key.
+    uint32_t value;     ///< Value associated with the name.
+} NameIndexEntry;
+
+/**
+ * @brief Open-addressing hash index mapping names to 32-bit values.
+ *
+ * Keys are borrowed: the strings must outlive the index.
+ */
+typedef struct {
+    NameIndexEntry *entries;    ///< Slot array (capacity is a power of two).
+    size_t capacity;            ///< Number of slots.
+    size_t count;               ///< Number of occupied slots.
+    bool heap_owned;            ///< True if the slots were allocated from the heap rather than an arena.
+} NameIndex;
+
+/**
+ * @brief Computes the 32-bit FNV-1a hash of a string.
+ * @param key Null-terminated string.
+ * @return uint32_t Hash value.
+ */
+uint32_t name_index_hash(const char *key);
+
+/**
+ * @brief Allocates an empty index sized for the expected number of names.
+ * @param index Pointer to the index to initialize.
+ * @param expected_count Number of names that will be inserted.
+ * @param arena Arena to allocate the slots from, or NULL to use the heap.
+ * @return bool True on success, false on allocation failure.
+ */
+bool name_index_init(NameIndex *index, size_t expected_count, Arena *arena);
+
+/**
+ * @brief Frees the slots of an index (arena-backed slots are only released with their arena).
+ * @param index Pointer to the index to free.
+ */
+void name_index_free(NameIndex *index);
+
+/**
+ * @brief Inserts a name; an existing entry with the same name is kept.
+ * @param index Pointer to the index.
+ * @param key Name to insert (borrowed).
+ * @param value Value to associate with the name.
+ * @return bool True if inserted, false if the name already exists or the index is full.
+ */
+bool name_index_insert(NameIndex *index, const char *key, uint32_t value);
+
+/**
+ * @brief Looks up a name.
+ * @param index Pointer to the index.
+ * @param key Name to look up.
+ * @param value Pointer to store the associated value.
+ * @return bool True if the name is found, false otherwise.
+ */
+bool name_index_find(const NameIndex *index, const char *key, uint32_t *value);
+
+#endif // NAME_INDEX_H
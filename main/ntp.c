@@ -85,7 +85,13 @@ static void clock_task(void *arg)
         VariableNode *node = find_current_time_variable();
         if(node){
             Time *t = (Time *)node->data;
-            t->value = hour * 10000 + minute * 100 + second;
+            double value = hour * 10000 + minute * 100 + second;
+            if (t->value != value) {
+                // Report the new time with the next monitor delta
+                t->value = value;
+                VariableHandle handle = { .index = t->base.index, .type = VAR_TYPE_TIME, .member = VAR_MEMBER_VALUE };
+                mark_variable_dirty(handle);
+            }
         }
 
         // Delay for 1 second
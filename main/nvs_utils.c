@@ -13,11 +13,21 @@
  */
 #define NVS_KEY "json_config"
 
+/**
+ * @brief Key used to store the compiled configuration image in NVS.
+ */
+#define NVS_IMAGE_KEY "config_image"
+
 /**
  * @brief Tag for logging messages from the NVS utility module.
  */
 static const char *TAG = "nvs_module";
 
+/**
+ * @brief Number of times the stored JSON configuration was written or deleted since boot.
+ */
+static uint32_t config_generation = 0;
+
 /**
  * @brief Initializes the Non-Volatile Storage (NVS) system.
  * @return esp_err_t ESP_OK on success, or an error code on failure.
@@ -77,6 +87,13 @@ void save_config_to_nvs(const char *data, int data_len) {
 
     // Close NVS handle
     nvs_close(nvs_handle);
+
+    // Bumped after the write, so a copy read before it is seen as stale
+    __atomic_add_fetch(&config_generation, 1, __ATOMIC_RELEASE);
+}
+
+uint32_t get_config_generation(void) {
+    return __atomic_load_n(&config_generation, __ATOMIC_ACQUIRE);
 }
 
 /**
@@ -165,6 +182,9 @@ esp_err_t delete_config_from_nvs(void) {
 
     // Erase the specified key
     err = nvs_erase_key(nvs_handle, NVS_KEY);
+    if (err == ESP_OK) {
+        __atomic_add_fetch(&config_generation, 1, __ATOMIC_RELEASE);
+    }
     if (err == ESP_ERR_NVS_NOT_FOUND) {
         ESP_LOGW(TAG, "JSON configuration data not found in NVS, nothing to delete");
         nvs_close(nvs_handle);
@@ -187,4 +207,109 @@ esp_err_t delete_config_from_nvs(void) {
     // Close NVS handle
     nvs_close(nvs_handle);
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+esp_err_t save_config_image_to_nvs(const uint8_t *image, size_t image_len) {
+    nvs_handle_t nvs_handle;
+    esp_err_t err;
+
+    // Open NVS namespace in read-write mode
+    err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error opening NVS: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    // Save image as a binary blob and commit it
+    err = nvs_set_blob(nvs_handle, NVS_IMAGE_KEY, image, image_len);
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error saving configuration image: %s", esp_err_to_name(err));
+    } else {
+        ESP_LOGI(TAG, "Configuration image (%zu bytes) successfully saved in NVS", image_len);
+    }
+
+    // Close NVS handle
+    nvs_close(nvs_handle);
+    return err;
+}
+
+esp_err_t load_config_image_from_nvs(uint8_t **image, size_t *image_len) {
+    nvs_handle_t nvs_handle;
+    esp_err_t err;
+    size_t required_size = 0;
+
+    // Initialize output parameters
+    *image = NULL;
+    *image_len = 0;
+
+    // Open NVS namespace in read-only mode
+    err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error opening NVS %s namespace: %s", NVS_NAMESPACE, esp_err_to_name(err));
+        return err;
+    }
+
+    // Get the size of the stored image
+    err = nvs_get_blob(nvs_handle, NVS_IMAGE_KEY, NULL, &required_size);
+    if (err == ESP_OK && required_size == 0) {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (err != ESP_OK) {
+        if (err != ESP_ERR_NVS_NOT_FOUND) {
+            ESP_LOGE(TAG, "Error reading image size: %s", esp_err_to_name(err));
+        }
+        nvs_close(nvs_handle);
+        return err;
+    }
+
+    // Allocate memory and read the image
+    *image = malloc(required_size);
+    if (*image == NULL) {
+        ESP_LOGE(TAG, "Memory allocation error");
+        nvs_close(nvs_handle);
+        return ESP_ERR_NO_MEM;
+    }
+    err = nvs_get_blob(nvs_handle, NVS_IMAGE_KEY, *image, &required_size);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error reading configuration image: %s", esp_err_to_name(err));
+        free(*image);
+        *image = NULL;
+        nvs_close(nvs_handle);
+        return err;
+    }
+    *image_len = required_size;
+
+    // Close NVS handle
+    nvs_close(nvs_handle);
+    return ESP_OK;
+}
+
+esp_err_t delete_config_image_from_nvs(void) {
+    nvs_handle_t nvs_handle;
+    esp_err_t err;
+
+    // Open NVS namespace in read-write mode
+    err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error opening NVS %s namespace: %s", NVS_NAMESPACE, esp_err_to_name(err));
+        return err;
+    }
+
+    // Erase the image key; a missing image is not an error
+    err = nvs_erase_key(nvs_handle, NVS_IMAGE_KEY);
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handle);
+    } else if (err == ESP_ERR_NVS_NOT_FOUND) {
+        err = ESP_OK;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error deleting configuration image: %s", esp_err_to_name(err));
+    }
+
+    // Close NVS handle
+    nvs_close(nvs_handle);
+    return err;
+}
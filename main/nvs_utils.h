@@ -2,6 +2,8 @@
 #define NVS_UTILS_H
 
 #include <esp_err.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /**
  * @brief Initializes the Non-Volatile Storage (NVS) system.
@@ -30,4 +32,35 @@ esp_err_t load_config_from_nvs(char **data, size_t *data_len);
  */
 esp_err_t delete_config_from_nvs(void);
 
+/**
+ * @brief Gets the generation of the stored JSON configuration.
+ *
+ * Changes every time the configuration is saved or deleted, also when the applied
+ * variables stay the same, so a cached copy can be checked against it.
+ * @return uint32_t Current configuration generation.
+ */
+uint32_t get_config_generation(void);
+
+/**
+ * @brief Saves the compiled configuration image to NVS, next to the JSON configuration.
+ * @param image Pointer to the image.
+ * @param image_len Length of the image in bytes.
+ * @return esp_err_t ESP_OK on success, or an error code on failure.
+ */
+esp_err_t save_config_image_to_nvs(const uint8_t *image, size_t image_len);
+
+/**
+ * @brief Loads the compiled configuration image from NVS.
+ * @param image Pointer to store the heap-allocated image (freed by the caller).
+ * @param image_len Pointer to store the image length.
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NVS_NOT_FOUND if no image is stored, or another error code.
+ */
+esp_err_t load_config_image_from_nvs(uint8_t **image, size_t *image_len);
+
+/**
+ * @brief Deletes the compiled configuration image from NVS.
+ * @return esp_err_t ESP_OK on success, or an error code on failure.
+ */
+esp_err_t delete_config_image_from_nvs(void);
+
 #endif // NVS_UTILS_H
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "onewire.h"
 
 #include "device_config.h"
+#include "cbor.h"
 
 /**
  * @brief Tag for logging messages from the one-wire detection module.
@@ -31,46 +32,30 @@ static size_t sensor_count = 0;           ///< Current number of detected sensor
 static size_t sensor_capacity = 0;        ///< Capacity of the sensor_states array.
 
 /**
- * @brief Search for one-wire sensors on configured pins and return their addresses as JSON.
- * @return char* JSON string containing detected sensor pins and addresses, or NULL on error.
+ * @brief Scan the configured one-wire buses and update the debounced sensor states.
+ * @return bool True on success, false on allocation failure.
  */
-char *search_for_one_wire_sensors(void) {
+bool scan_one_wire_sensors(void) {
     onewire_search_t search;
     onewire_addr_t addr;
 
     // Validate device configuration
     if (!_device.one_wire_inputs || _device.one_wire_inputs_len == 0) {
-        // Create empty JSON
-        cJSON *root = cJSON_CreateObject();
-        cJSON *pins = cJSON_CreateArray();
-        cJSON_AddItemToObject(root, "pins", pins);
-        char *json_str = cJSON_PrintUnformatted(root);
-        cJSON_Delete(root);
-        return json_str;
+        return true;
     }
 
-    // Temporary array to mark which sensors were seen in this scan
-    bool *seen = calloc(sensor_count, sizeof(bool));
-    if (!seen && sensor_count > 0) {
+    // Temporary array to mark which of the known sensors were seen in this scan
+    size_t known_count = sensor_count;
+    bool *seen = calloc(known_count, sizeof(bool));
+    if (!seen && known_count > 0) {
         ESP_LOGE(TAG, "Failed to allocate seen array");
-        return NULL;
+        return false;
     }
 
-    // Create JSON object for stable sensors
-    cJSON *root = cJSON_CreateObject();
-    cJSON *pins = cJSON_CreateArray();
-    cJSON_AddItemToObject(root, "pins", pins);
-
     // Scan each pin
     for (size_t pin_index = 0; pin_index < _device.one_wire_inputs_len; pin_index++) {
         int one_wire_gpio = _device.one_wire_inputs[pin_index];
 
-        // Create JSON for the current pin
-        cJSON *pin_obj = cJSON_CreateObject();
-        cJSON_AddNumberToObject(pin_obj, "pin", one_wire_gpio);
-        cJSON *addresses = cJSON_CreateArray();
-        cJSON_AddItemToObject(pin_obj, "addresses", addresses);
-
         // Find all devices on the OneWire bus for the current pin
         onewire_search_start(&search);
         while ((addr = onewire_search_next(&search, one_wire_gpio)) != ONEWIRE_NONE) {
@@ -83,7 +68,7 @@ char *search_for_one_wire_sensors(void) {
             for (size_t i = 0; i < sensor_count; i++) {
                 if (sensor_states && sensor_states[i].pin == one_wire_gpio && strcmp(sensor_states[i].address, addr_str) == 0) {
                     sensor_index = i;
-                    if (seen) seen[i] = true;
+                    if (i < known_count) seen[i] = true;
                     break;
                 }
             }
@@ -102,8 +87,7 @@ char *search_for_one_wire_sensors(void) {
                     if (!new_states) {
                         ESP_LOGE(TAG, "Failed to allocate sensor states");
                         free(seen);
-                        cJSON_Delete(root);
-                        return NULL;
+                        return false;
                     }
                     sensor_states = new_states;
                     sensor_capacity = new_capacity;
@@ -113,28 +97,15 @@ char *search_for_one_wire_sensors(void) {
                     .detection_count = 1
                 };
                 strncpy(sensor_states[sensor_count].address, addr_str, sizeof(sensor_states[sensor_count].address));
-                if (seen) seen[sensor_count] = true;
                 sensor_count++;
             }
         }
-
-        // Add stable sensors to JSON (detection_count >= DETECTION_THRESHOLD)
-        for (size_t i = 0; i < sensor_count; i++) {
-            if (sensor_states && sensor_states[i].pin == one_wire_gpio && sensor_states[i].detection_count >= DETECTION_THRESHOLD) {
-                cJSON_AddItemToArray(addresses, cJSON_CreateString(sensor_states[i].address));
-            }
-        }
-
-        // Add pin object to the pins array
-        cJSON_AddItemToArray(pins, pin_obj);
     }
 
-    // Update miss counts for sensors not seen in this scan
-    for (size_t i = 0; i < sensor_count; i++) {
-        if (seen && !seen[i]) {
-            if (sensor_states && sensor_states[i].detection_count > -MISS_THRESHOLD) {
-                sensor_states[i].detection_count--;
-            }
+    // Update miss counts for known sensors not seen in this scan
+    for (size_t i = 0; i < known_count; i++) {
+        if (!seen[i] && sensor_states[i].detection_count > -MISS_THRESHOLD) {
+            sensor_states[i].detection_count--;
         }
     }
 
@@ -150,11 +121,81 @@ char *search_for_one_wire_sensors(void) {
         }
     }
 
-    if (seen) {
-        free(seen);
+    free(seen);
+    return true;
+}
+
+/**
+ * @brief Check whether a sensor state belongs to a pin and is confirmed.
+ * @param state Pointer to the sensor state.
+ * @param pin GPIO of the one-wire bus.
+ * @return bool True if the sensor is stable on that pin.
+ */
+static bool is_stable_sensor(const SensorState *state, int pin) {
+    return state->pin == pin && state->detection_count >= DETECTION_THRESHOLD;
+}
+
+/**
+ * @brief Search for one-wire sensors on configured pins and return their addresses as JSON.
+ * @return char* JSON string containing detected sensor pins and addresses, or NULL on error.
+ */
+char *search_for_one_wire_sensors(void) {
+    if (!scan_one_wire_sensors()) {
+        return NULL;
+    }
+
+    // Create JSON object for stable sensors
+    cJSON *root = cJSON_CreateObject();
+    cJSON *pins = cJSON_CreateArray();
+    cJSON_AddItemToObject(root, "pins", pins);
+
+    for (size_t pin_index = 0; _device.one_wire_inputs && pin_index < _device.one_wire_inputs_len; pin_index++) {
+        int one_wire_gpio = _device.one_wire_inputs[pin_index];
+
+        // Create JSON for the current pin
+        cJSON *pin_obj = cJSON_CreateObject();
+        cJSON_AddNumberToObject(pin_obj, "pin", one_wire_gpio);
+        cJSON *addresses = cJSON_CreateArray();
+        cJSON_AddItemToObject(pin_obj, "addresses", addresses);
+
+        // Add stable sensors to JSON (detection_count >= DETECTION_THRESHOLD)
+        for (size_t i = 0; i < sensor_count; i++) {
+            if (is_stable_sensor(&sensor_states[i], one_wire_gpio)) {
+                cJSON_AddItemToArray(addresses, cJSON_CreateString(sensor_states[i].address));
+            }
+        }
+
+        // Add pin object to the pins array
+        cJSON_AddItemToArray(pins, pin_obj);
     }
 
     char *json_str = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
     return json_str;
-}
\ No newline at end of file
+}
+
+size_t write_one_wire_sensors_cbor(uint8_t *buf, size_t size) {
+    CborWriter w;
+    cbor_writer_init(&w, buf, size);
+
+    // [[pin, [address, ...]], ...] with addresses as 64-bit integers
+    size_t pin_count = _device.one_wire_inputs ? _device.one_wire_inputs_len : 0;
+    cbor_write_array(&w, pin_count);
+    for (size_t pin_index = 0; pin_index < pin_count; pin_index++) {
+        int one_wire_gpio = _device.one_wire_inputs[pin_index];
+        size_t stable = 0;
+        for (size_t i = 0; i < sensor_count; i++) {
+            if (is_stable_sensor(&sensor_states[i], one_wire_gpio)) stable++;
+        }
+
+        cbor_write_array(&w, 2);
+        cbor_write_int(&w, one_wire_gpio);
+        cbor_write_array(&w, stable);
+        for (size_t i = 0; i < sensor_count; i++) {
+            if (is_stable_sensor(&sensor_states[i], one_wire_gpio)) {
+                cbor_write_uint(&w, strtoull(sensor_states[i].address, NULL, 16));
+            }
+        }
+    }
+    return cbor_writer_finish(&w);
+}
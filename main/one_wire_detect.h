@@ -1,10 +1,30 @@
 #ifndef ONE_WIRE_DETECT_H
 #define ONE_WIRE_DETECT_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Scans the configured one-wire buses and updates the debounced sensor list.
+ * @return bool True on success, false on allocation failure.
+ */
+bool scan_one_wire_sensors(void);
+
 /**
  * @brief Searches for one-wire sensors on configured GPIO pins and returns their addresses as a JSON string.
  * @return char* JSON string containing detected sensor pins and addresses, or NULL on error.
  */
 char *search_for_one_wire_sensors(void);
 
-#endif // ONE_WIRE_DETECT_H
\ No newline at end of file
+/**
+ * @brief Encodes the sensors confirmed by the last scan as CBOR, [[pin, [address, ...]], ...].
+ *
+ * Does not scan; call scan_one_wire_sensors first.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return size_t Length of the full encoding; it did not fit if this is > size.
+ */
+size_t write_one_wire_sensors_cbor(uint8_t *buf, size_t size);
+
+#endif // ONE_WIRE_DETECT_H
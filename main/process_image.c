@@ -0,0 +1,302 @@
+#include "process_image.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+
+#include "device_config.h"
+
+/**
+ * @brief Tag for logging messages from the process image module.
+ */
+static const char *TAG = "PROCESS_IMAGE";
+
+/**
+ * @brief Bitmask of GPIOs configured as digital inputs.
+ */
+static uint64_t input_mask = 0;
+
+/**
+ * @brief Bitmask of GPIOs configured as digital outputs.
+ */
+static uint64_t output_mask = 0;
+
+/**
+ * @brief Input values latched at the start of the current scan, indexed by GPIO.
+ */
+static uint64_t input_image = 0;
+
+/**
+ * @brief Output values written by the program, indexed by GPIO.
+ */
+static uint64_t output_image = 0;
+
+/**
+ * @brief Outputs whose image changed since the last flush.
+ */
+static uint64_t output_dirty = 0;
+
+/**
+ * @brief Bitmask of digital inputs captured by interrupt.
+ */
+static uint64_t captured_mask = 0;
+
+/**
+ * @brief Level of the captured inputs after the last drained event.
+ */
+static uint64_t captured_level = 0;
+
+/**
+ * @brief Captured inputs with edges between the last two scans.
+ */
+static uint64_t edge_pins = 0;
+
+/**
+ * @brief Rising edges per captured input between the last two scans.
+ */
+static uint16_t rising_edges[PROCESS_IMAGE_MAX_GPIO];
+
+/**
+ * @brief Falling edges per captured input between the last two scans.
+ */
+static uint16_t falling_edges[PROCESS_IMAGE_MAX_GPIO];
+
+/**
+ * @brief Edge events from the input interrupt to the scan cycle.
+ * Single producer (the GPIO ISR service runs on one core) and single consumer (the scan task).
+ */
+static InputEvent event_ring[INPUT_EVENT_RING_SIZE];
+
+/**
+ * @brief Number of events written by the interrupt; the slot is head % INPUT_EVENT_RING_SIZE.
+ */
+static volatile uint32_t ring_head = 0;
+
+/**
+ * @brief Number of events consumed by the scan cycle.
+ */
+static volatile uint32_t ring_tail = 0;
+
+/**
+ * @brief Number of events dropped because the ring was full.
+ */
+static volatile uint32_t ring_overflows = 0;
+
+/**
+ * @brief Converts a GPIO number into its bit in the process image.
+ * @param pin GPIO number.
+ * @return uint64_t Bit for the pin, or 0 if the pin is out of range.
+ */
+static inline uint64_t pin_bit(gpio_num_t pin) {
+    return (pin >= 0 && pin < PROCESS_IMAGE_MAX_GPIO) ? (1ULL << pin) : 0;
+}
+
+/**
+ * @brief Records an edge of a captured input.
+ * @param arg GPIO number of the input.
+ */
+static void IRAM_ATTR input_edge_isr(void *arg) {
+    uint32_t head = ring_head;
+    if (head - __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE) >= INPUT_EVENT_RING_SIZE) {
+        ring_overflows++;
+        return;
+    }
+    InputEvent *event = &event_ring[head & (INPUT_EVENT_RING_SIZE - 1)];
+    event->pin = (uint8_t)(uintptr_t)arg;
+    event->level = (uint8_t)gpio_get_level((gpio_num_t)(uintptr_t)arg);
+    __atomic_store_n(&ring_head, head + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Attaches the edge interrupt to the inputs listed in interrupt_inputs.
+ */
+static void init_captured_inputs(void) {
+    // Detach the inputs of the previous configuration
+    uint64_t pending = captured_mask;
+    while (pending) {
+        int pin = __builtin_ctzll(pending);
+        pending &= pending - 1;
+        gpio_isr_handler_remove((gpio_num_t)pin);
+        gpio_set_intr_type((gpio_num_t)pin, GPIO_INTR_DISABLE);
+    }
+    captured_mask = 0;
+    captured_level = 0;
+    edge_pins = 0;
+    ring_tail = ring_head; // Drop stale events
+
+    if (_device.interrupt_inputs_len == 0) {
+        return;
+    }
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) { // Already installed is fine
+        ESP_LOGE(TAG, "Failed to install GPIO ISR service: %s", esp_err_to_name(err));
+        return;
+    }
+
+    for (size_t i = 0; i < _device.interrupt_inputs_len; i++) {
+        gpio_num_t pin = (gpio_num_t)_device.interrupt_inputs[i];
+        uint64_t bit = input_mask & pin_bit(pin);
+        if (!bit) {
+            // Log warning for interrupt inputs that are not digital inputs
+            ESP_LOGW(TAG, "Interrupt input GPIO %d is not a digital input, ignored", pin);
+            continue;
+        }
+        if (gpio_get_level(pin)) {
+            captured_level |= bit;
+        }
+        err = gpio_set_intr_type(pin, GPIO_INTR_ANYEDGE);
+        if (err == ESP_OK) {
+            err = gpio_isr_handler_add(pin, input_edge_isr, (void *)(uintptr_t)pin);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to attach interrupt to GPIO %d: %s", pin, esp_err_to_name(err));
+            gpio_set_intr_type(pin, GPIO_INTR_DISABLE);
+            continue;
+        }
+        captured_mask |= bit;
+    }
+}
+
+/**
+ * @brief Drains the edge events since the previous scan into the captured levels and edge counts.
+ * @return uint64_t Image bits of the captured inputs for this scan.
+ */
+static uint64_t drain_input_events(void) {
+    static uint32_t reported_overflows = 0;
+
+    // Clear the counts of the previous scan
+    uint64_t pending = edge_pins;
+    while (pending) {
+        int pin = __builtin_ctzll(pending);
+        pending &= pending - 1;
+        rising_edges[pin] = 0;
+        falling_edges[pin] = 0;
+    }
+    edge_pins = 0;
+
+    uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    for (uint32_t tail = ring_tail; tail != head; tail++) {
+        const InputEvent *event = &event_ring[tail & (INPUT_EVENT_RING_SIZE - 1)];
+        uint64_t bit = pin_bit((gpio_num_t)event->pin) & captured_mask;
+        if (!bit) {
+            continue;
+        }
+        if (event->level != ((captured_level & bit) != 0)) {
+            // A single edge to the new level
+            if (event->level) rising_edges[event->pin]++;
+            else falling_edges[event->pin]++;
+            captured_level ^= bit;
+        } else {
+            // Both edges of a pulse shorter than the interrupt latency
+            rising_edges[event->pin]++;
+            falling_edges[event->pin]++;
+        }
+        edge_pins |= bit;
+    }
+    __atomic_store_n(&ring_tail, head, __ATOMIC_RELEASE);
+
+    uint32_t overflows = ring_overflows;
+    if (overflows != reported_overflows) {
+        // Edges were lost: take the levels from the pins again
+        ESP_LOGW(TAG, "Input event ring overflow (%lu events dropped)", (unsigned long)(overflows - reported_overflows));
+        reported_overflows = overflows;
+        uint64_t pins = captured_mask;
+        while (pins) {
+            int pin = __builtin_ctzll(pins);
+            pins &= pins - 1;
+            captured_level = gpio_get_level((gpio_num_t)pin) ? (captured_level | (1ULL << pin)) : (captured_level & ~(1ULL << pin));
+        }
+    }
+
+    // Inputs back at their latched level after an edge pulsed in between; show the pulse for one scan
+    uint64_t pulsed = edge_pins & ~(captured_level ^ input_image);
+    return (captured_level ^ pulsed) & captured_mask;
+}
+
+void process_image_init(void) {
+    input_mask = 0;
+    output_mask = 0;
+    input_image = 0;
+    output_image = 0;
+    output_dirty = 0;
+
+    for (size_t i = 0; i < _device.digital_inputs_len; i++) {
+        input_mask |= pin_bit((gpio_num_t)_device.digital_inputs[i]);
+    }
+    init_captured_inputs();
+
+    for (size_t i = 0; i < _device.digital_outputs_len; i++) {
+        gpio_num_t pin = (gpio_num_t)_device.digital_outputs[i];
+        uint64_t bit = pin_bit(pin);
+        if (!bit) {
+            // Log warning for outputs outside the process image
+            ESP_LOGW(TAG, "GPIO %d outside process image, ignored", pin);
+            continue;
+        }
+        output_mask |= bit;
+        // Start from the current pin level so the first flush doesn't glitch outputs
+        if (gpio_get_level(pin)) {
+            output_image |= bit;
+        }
+    }
+
+    // Log process image configuration
+    ESP_LOGI(TAG, "Process image: inputs 0x%016llx (interrupt 0x%016llx), outputs 0x%016llx",
+             (unsigned long long)input_mask, (unsigned long long)captured_mask, (unsigned long long)output_mask);
+    process_image_read_inputs();
+}
+
+void process_image_read_inputs(void) {
+    uint64_t image = captured_mask ? drain_input_events() : 0;
+    uint64_t pending = input_mask & ~captured_mask;
+    while (pending) {
+        int pin = __builtin_ctzll(pending);
+        pending &= pending - 1;
+        if (gpio_get_level((gpio_num_t)pin)) {
+            image |= 1ULL << pin;
+        }
+    }
+    input_image = image;
+}
+
+void process_image_write_outputs(void) {
+    uint64_t pending = output_dirty;
+    output_dirty = 0;
+    while (pending) {
+        int pin = __builtin_ctzll(pending);
+        pending &= pending - 1;
+        esp_err_t err = gpio_set_level((gpio_num_t)pin, (output_image >> pin) & 1);
+        if (err != ESP_OK) {
+            // Log error setting output and retry on the next flush
+            ESP_LOGE(TAG, "Error setting GPIO %d: %s", pin, esp_err_to_name(err));
+            output_dirty |= 1ULL << pin;
+        }
+    }
+}
+
+bool process_image_get_input(gpio_num_t pin) {
+    return (input_image & input_mask & pin_bit(pin)) != 0;
+}
+
+bool process_image_is_captured(gpio_num_t pin) {
+    return (captured_mask & pin_bit(pin)) != 0;
+}
+
+uint32_t process_image_get_edges(gpio_num_t pin, bool rising) {
+    if (!(edge_pins & pin_bit(pin))) {
+        return 0;
+    }
+    return rising ? rising_edges[pin] : falling_edges[pin];
+}
+
+bool process_image_get_output(gpio_num_t pin) {
+    return (output_image & output_mask & pin_bit(pin)) != 0;
+}
+
+void process_image_set_output(gpio_num_t pin, bool value) {
+    uint64_t bit = output_mask & pin_bit(pin);
+    if (!bit) {
+        return;
+    }
+    uint64_t previous = output_image;
+    output_image = value ? (output_image | bit) : (output_image & ~bit);
+    output_dirty |= previous ^ output_image;
+}
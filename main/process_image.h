@@ -0,0 +1,82 @@
+#ifndef PROCESS_IMAGE_H
+#define PROCESS_IMAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driver/gpio.h"
+
+/**
+ * @brief Number of GPIOs covered by the process image bitmaps.
+ */
+#define PROCESS_IMAGE_MAX_GPIO 64
+
+/**
+ * @brief Capacity of the edge event ring filled by the input interrupt; must be a power of two.
+ */
+#define INPUT_EVENT_RING_SIZE 256
+
+/**
+ * @brief Edge event recorded by the input interrupt.
+ */
+typedef struct {
+    uint8_t pin;    ///< GPIO number of the input.
+    uint8_t level;  ///< Level read in the interrupt, after the edge.
+} InputEvent;
+
+/**
+ * @brief Builds the input/output pin masks from the device configuration and seeds the output image.
+ * Inputs listed in interrupt_inputs get an edge interrupt feeding the event ring.
+ */
+void process_image_init(void);
+
+/**
+ * @brief Latches all configured digital inputs into the input image (start of scan).
+ *
+ * Polled inputs are read directly. Interrupt inputs take their level and edge counts from
+ * the events since the previous scan; a pulse that started and ended between two scans
+ * reads as its opposite level for one scan, so contacts still see it.
+ */
+void process_image_read_inputs(void);
+
+/**
+ * @brief Drives all digital outputs whose image changed since the last flush (end of scan).
+ */
+void process_image_write_outputs(void);
+
+/**
+ * @brief Gets the latched value of a digital input.
+ * @param pin GPIO number of the input.
+ * @return bool Latched input value, or false if the pin is not a configured input.
+ */
+bool process_image_get_input(gpio_num_t pin);
+
+/**
+ * @brief Checks whether a digital input is captured by interrupt.
+ * @param pin GPIO number of the input.
+ * @return bool True if the input is listed in interrupt_inputs.
+ */
+bool process_image_is_captured(gpio_num_t pin);
+
+/**
+ * @brief Gets the number of edges of an interrupt input between the last two scans.
+ * @param pin GPIO number of the input.
+ * @param rising True to count rising edges, false for falling edges.
+ * @return uint32_t Number of edges, or 0 if the pin is not an interrupt input.
+ */
+uint32_t process_image_get_edges(gpio_num_t pin, bool rising);
+
+/**
+ * @brief Gets the image value of a digital output.
+ * @param pin GPIO number of the output.
+ * @return bool Output image value, or false if the pin is not a configured output.
+ */
+bool process_image_get_output(gpio_num_t pin);
+
+/**
+ * @brief Sets the image value of a digital output; the pin is driven at the next flush.
+ * @param pin GPIO number of the output.
+ * @param value Value to set.
+ */
+void process_image_set_output(gpio_num_t pin, bool value);
+
+#endif // PROCESS_IMAGE_H
@@ -0,0 +1,171 @@
+#include "pulse_counter.h"
+#include "esp_log.h"
+#include <string.h>
+
+#if SOC_PCNT_SUPPORTED
+#include "driver/pulse_cnt.h"
+#endif
+
+/**
+ * @brief Tag for logging messages from the pulse counter module.
+ */
+static const char *TAG = "PULSE_COUNTER";
+
+/**
+ * @brief State of an attached pulse counter.
+ */
+typedef struct {
+    bool attached;                  ///< Unit is in use.
+    gpio_num_t pin;                 ///< Counted GPIO.
+    int last;                       ///< Count at the previous take.
+#if SOC_PCNT_SUPPORTED
+    pcnt_unit_handle_t unit;        ///< PCNT unit.
+    pcnt_channel_handle_t channel;  ///< PCNT channel on the GPIO.
+#else
+    int count;                      ///< Software count fed by pulse_counter_inject.
+#endif
+} PulseCounter;
+
+/**
+ * @brief Pulse counters by unit number.
+ */
+static PulseCounter counters[PULSE_COUNTER_MAX_UNITS];
+
+#if SOC_PCNT_SUPPORTED
+/**
+ * @brief Releases the PCNT unit and channel of a counter.
+ * @param pc Pointer to the counter.
+ */
+static void release_unit(PulseCounter *pc) {
+    if (pc->unit) {
+        pcnt_unit_stop(pc->unit);
+        pcnt_unit_disable(pc->unit);
+    }
+    if (pc->channel) {
+        pcnt_del_channel(pc->channel);
+    }
+    if (pc->unit) {
+        pcnt_unit_remove_watch_point(pc->unit, PULSE_COUNTER_LIMIT);
+        pcnt_unit_remove_watch_point(pc->unit, -PULSE_COUNTER_LIMIT);
+        pcnt_del_unit(pc->unit);
+    }
+}
+
+/**
+ * @brief Sets up a PCNT unit counting the rising edges of the counter's GPIO.
+ * @param pc Pointer to the counter, with pin set.
+ * @return esp_err_t ESP_OK on success, the driver error otherwise.
+ */
+static esp_err_t setup_unit(PulseCounter *pc) {
+    // Watch points on the limits let the driver accumulate past the 16-bit hardware count
+    pcnt_unit_config_t unit_config = {
+        .high_limit = PULSE_COUNTER_LIMIT,
+        .low_limit = -PULSE_COUNTER_LIMIT,
+        .flags.accum_count = true,
+    };
+    esp_err_t err = pcnt_new_unit(&unit_config, &pc->unit);
+    if (err != ESP_OK) return err;
+
+    pcnt_glitch_filter_config_t filter_config = { .max_glitch_ns = PULSE_COUNTER_GLITCH_NS };
+    err = pcnt_unit_set_glitch_filter(pc->unit, &filter_config);
+    if (err != ESP_OK) return err;
+
+    pcnt_chan_config_t chan_config = { .edge_gpio_num = pc->pin, .level_gpio_num = -1 };
+    err = pcnt_new_channel(pc->unit, &chan_config, &pc->channel);
+    if (err != ESP_OK) return err;
+
+    err = pcnt_channel_set_edge_action(pc->channel, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_HOLD);
+    if (err == ESP_OK) err = pcnt_unit_add_watch_point(pc->unit, PULSE_COUNTER_LIMIT);
+    if (err == ESP_OK) err = pcnt_unit_add_watch_point(pc->unit, -PULSE_COUNTER_LIMIT);
+    if (err == ESP_OK) err = pcnt_unit_enable(pc->unit);
+    if (err == ESP_OK) err = pcnt_unit_clear_count(pc->unit);
+    if (err == ESP_OK) err = pcnt_unit_start(pc->unit);
+    return err;
+}
+#endif
+
+int pulse_counter_attach(gpio_num_t pin) {
+    for (int i = 0; i < PULSE_COUNTER_MAX_UNITS; i++) {
+        PulseCounter *pc = &counters[i];
+        if (pc->attached) continue;
+
+        memset(pc, 0, sizeof(*pc));
+        pc->pin = pin;
+#if SOC_PCNT_SUPPORTED
+        esp_err_t err = setup_unit(pc);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set up pulse counter on GPIO %d: %s", pin, esp_err_to_name(err));
+            release_unit(pc);
+            memset(pc, 0, sizeof(*pc));
+            return -1;
+        }
+#endif
+        pc->attached = true;
+        ESP_LOGI(TAG, "Pulse counter %d counting GPIO %d", i, pin);
+        return i;
+    }
+    ESP_LOGE(TAG, "No pulse counter left for GPIO %d", pin);
+    return -1;
+}
+
+/**
+ * @brief Reads the current count of an attached unit.
+ * @param pc Pointer to the counter.
+ * @param count Receives the count.
+ * @return bool True on success.
+ */
+static bool read_count(PulseCounter *pc, int *count) {
+#if SOC_PCNT_SUPPORTED
+    return pcnt_unit_get_count(pc->unit, count) == ESP_OK;
+#else
+    *count = __atomic_load_n(&pc->count, __ATOMIC_RELAXED);
+    return true;
+#endif
+}
+
+int32_t pulse_counter_take(int unit) {
+    if (unit < 0 || unit >= PULSE_COUNTER_MAX_UNITS || !counters[unit].attached) {
+        return 0;
+    }
+    PulseCounter *pc = &counters[unit];
+    int count;
+    if (!read_count(pc, &count)) {
+        return 0;
+    }
+    // Published for pulse_counter_peek on other tasks
+    int last = __atomic_exchange_n(&pc->last, count, __ATOMIC_RELEASE);
+    return (int32_t)(count - last);
+}
+
+int32_t pulse_counter_peek(int unit) {
+    if (unit < 0 || unit >= PULSE_COUNTER_MAX_UNITS || !counters[unit].attached) {
+        return 0;
+    }
+    PulseCounter *pc = &counters[unit];
+    // Read last before the count, so a take in between never makes the share negative
+    int last = __atomic_load_n(&pc->last, __ATOMIC_ACQUIRE);
+    int count;
+    if (!read_count(pc, &count)) {
+        return 0;
+    }
+    return (int32_t)(count - last);
+}
+
+void pulse_counter_release_all(void) {
+    for (int i = 0; i < PULSE_COUNTER_MAX_UNITS; i++) {
+        PulseCounter *pc = &counters[i];
+        if (!pc->attached) continue;
+#if SOC_PCNT_SUPPORTED
+        release_unit(pc);
+#endif
+        memset(pc, 0, sizeof(*pc));
+    }
+}
+
+#if !SOC_PCNT_SUPPORTED
+void pulse_counter_inject(int unit, int32_t pulses) {
+    if (unit >= 0 && unit < PULSE_COUNTER_MAX_UNITS && counters[unit].attached) {
+        __atomic_fetch_add(&counters[unit].count, pulses, __ATOMIC_RELAXED);
+    }
+}
+#endif
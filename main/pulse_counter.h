@@ -0,0 +1,64 @@
+#ifndef PULSE_COUNTER_H
+#define PULSE_COUNTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driver/gpio.h"
+#include "soc/soc_caps.h"
+
+/**
+ * @brief Maximum number of pulse counters; the chip may provide fewer PCNT units.
+ */
+#define PULSE_COUNTER_MAX_UNITS 8
+
+/**
+ * @brief Count limit of a PCNT unit; the driver accumulates overflows beyond it.
+ */
+#define PULSE_COUNTER_LIMIT 32767
+
+/**
+ * @brief Shortest pulse accepted by the glitch filter, in nanoseconds.
+ */
+#define PULSE_COUNTER_GLITCH_NS 1000
+
+/**
+ * @brief Starts counting the rising edges of a GPIO.
+ *
+ * On targets without the PCNT peripheral (such as host builds) a software counter is used
+ * instead, fed through pulse_counter_inject.
+ * @param pin GPIO number of the input.
+ * @return int Unit number, or -1 if no unit is left or the driver failed.
+ */
+int pulse_counter_attach(gpio_num_t pin);
+
+/**
+ * @brief Takes the pulses counted since the previous call for the unit.
+ *
+ * A unit has a single consumer, the scan task; other readers use pulse_counter_peek.
+ * @param unit Unit number returned by pulse_counter_attach.
+ * @return int32_t Number of new pulses, or 0 if the unit is not attached.
+ */
+int32_t pulse_counter_take(int unit);
+
+/**
+ * @brief Gets the pulses counted since the previous take without taking them.
+ * @param unit Unit number returned by pulse_counter_attach.
+ * @return int32_t Number of pending pulses, or 0 if the unit is not attached.
+ */
+int32_t pulse_counter_peek(int unit);
+
+/**
+ * @brief Stops and releases all pulse counters.
+ */
+void pulse_counter_release_all(void);
+
+#if !SOC_PCNT_SUPPORTED
+/**
+ * @brief Adds pulses to a software counter (targets without PCNT only).
+ * @param unit Unit number returned by pulse_counter_attach.
+ * @param pulses Number of pulses to add.
+ */
+void pulse_counter_inject(int unit, int32_t pulses);
+#endif
+
+#endif // PULSE_COUNTER_H
@@ -0,0 +1,195 @@
+#include "scan_cycle.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+
+#include "process_image.h"
+#include "ladder_elements.h"
+#include "timer_wheel.h"
+#include "variables.h"
+
+/**
+ * @brief Tag for logging messages from the scan cycle module.
+ */
+static const char *TAG = "SCAN_CYCLE";
+
+/**
+ * @brief Handle of the scan cycle task.
+ */
+static TaskHandle_t scan_task_handle = NULL;
+
+/**
+ * @brief Program executed by the scan cycle task.
+ */
+static const LadderProgram *scan_program = NULL;
+
+/**
+ * @brief Program handed over by scan_cycle_swap, taken by the task between two scans.
+ */
+static const LadderProgram *pending_program = NULL;
+
+/**
+ * @brief Given by the scan cycle task when it has taken the pending program.
+ */
+static SemaphoreHandle_t swap_done = NULL;
+
+/**
+ * @brief Set by scan_cycle_stop; the task ends at the next scan boundary.
+ */
+static bool stop_requested = false;
+
+/**
+ * @brief Given by the scan cycle task right before it suspends itself for scan_cycle_stop to delete.
+ */
+static SemaphoreHandle_t task_stopped = NULL;
+
+/**
+ * @brief Scan cycle period in ticks.
+ */
+static TickType_t scan_period_ticks = 0;
+
+/**
+ * @brief Number of scans that took longer than the configured period.
+ */
+static uint32_t scan_overruns = 0;
+
+/**
+ * @brief Task function running the PLC scan cycle.
+ * @param pvParameters Task parameters (unused).
+ */
+static void scan_cycle_task(void *pvParameters) {
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1) {
+        // Stop between two scans, so the outputs hold the result of a whole scan
+        if (__atomic_load_n(&stop_requested, __ATOMIC_ACQUIRE)) {
+            // scan_cycle_stop deletes the task, so it is never deleted twice
+            xSemaphoreGive(task_stopped);
+            vTaskSuspend(NULL);
+        }
+
+        // Take a swapped program before the scan starts, so every scan runs one program whole
+        const LadderProgram *next = __atomic_exchange_n(&pending_program, NULL, __ATOMIC_ACQUIRE);
+        if (next) {
+            scan_program = next;
+            xSemaphoreGive(swap_done);
+        }
+
+        // Input phase: latch all digital inputs once per scan
+        process_image_read_inputs();
+
+        // Apply the timers that expired since the previous scan
+        ladder_elements_dispatch_timers();
+
+        // Add the counted pulses and elapsed times; only this task writes them into the records
+        sync_counters_and_timers();
+
+        // Execution phase: run all rungs in Wires order
+        for (size_t i = 0; i < scan_program->rung_count; i++) {
+            ladder_rung_execute(&scan_program->rungs[i]);
+        }
+
+        // Output phase: drive only the outputs that changed
+        process_image_write_outputs();
+
+        // Wait for the next period; on overrun restart timing instead of bursting to catch up
+        TickType_t elapsed = xTaskGetTickCount() - last_wake;
+        if (elapsed >= scan_period_ticks) {
+            scan_overruns++;
+            if (scan_overruns % 100 == 1) {
+                // Log overrun, rate-limited
+                ESP_LOGW(TAG, "Scan cycle overrun (%lu total)", (unsigned long)scan_overruns);
+            }
+            last_wake = xTaskGetTickCount();
+        } else if (ulTaskNotifyTake(pdTRUE, scan_period_ticks - elapsed) == 0) {
+            // A timer expiry wakes the task early for an extra scan without shifting the period
+            last_wake += scan_period_ticks;
+        }
+    }
+}
+
+esp_err_t scan_cycle_start(const LadderProgram *program, uint32_t period_ms) {
+    scan_cycle_stop();
+
+    if (!program) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!swap_done) {
+        swap_done = xSemaphoreCreateBinary();
+    }
+    if (!task_stopped) {
+        task_stopped = xSemaphoreCreateBinary();
+    }
+    if (!swap_done || !task_stopped) {
+        ESP_LOGE(TAG, "Failed to create scan cycle semaphores");
+        return ESP_ERR_NO_MEM;
+    }
+
+    scan_program = program;
+    scan_period_ticks = pdMS_TO_TICKS(period_ms ? period_ms : SCAN_CYCLE_DEFAULT_PERIOD_MS);
+    if (scan_period_ticks == 0) {
+        scan_period_ticks = 1;
+    }
+    scan_overruns = 0;
+    stop_requested = false;
+    xSemaphoreTake(task_stopped, 0);
+
+    if (xTaskCreate(scan_cycle_task, "scan_cycle", 4096, NULL, 5, &scan_task_handle) != pdPASS) {
+        // Log error if task creation fails
+        ESP_LOGE(TAG, "Failed to create scan cycle task");
+        scan_task_handle = NULL;
+        scan_program = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    timer_wheel_set_listener(scan_task_handle);
+
+    // Log scan cycle start
+    ESP_LOGI(TAG, "Scan cycle started: %zu rungs, period %lu ms", program->rung_count,
+             (unsigned long)(period_ms ? period_ms : SCAN_CYCLE_DEFAULT_PERIOD_MS));
+    return ESP_OK;
+}
+
+esp_err_t scan_cycle_swap(const LadderProgram *program) {
+    if (!scan_task_handle || !program) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Hand the program over and wake the task so the swap does not wait for the next period
+    xSemaphoreTake(swap_done, 0);
+    __atomic_store_n(&pending_program, program, __ATOMIC_RELEASE);
+    xTaskNotifyGive(scan_task_handle);
+    if (xSemaphoreTake(swap_done, scan_period_ticks + pdMS_TO_TICKS(SCAN_CYCLE_SWAP_TIMEOUT_MS)) != pdTRUE) {
+        // Withdraw the program unless the task took it in the meantime
+        const LadderProgram *expected = program;
+        if (__atomic_compare_exchange_n(&pending_program, &expected, NULL, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            ESP_LOGE(TAG, "Scan cycle did not take the new program");
+            return ESP_ERR_TIMEOUT;
+        }
+        xSemaphoreTake(swap_done, portMAX_DELAY);
+    }
+
+    // Log program swap
+    ESP_LOGI(TAG, "Scan cycle swapped to %zu rungs", program->rung_count);
+    return ESP_OK;
+}
+
+void scan_cycle_stop(void) {
+    if (scan_task_handle) {
+        timer_wheel_set_listener(NULL);
+
+        // Let the current scan finish its output phase, then wake the task from its period wait
+        __atomic_store_n(&stop_requested, true, __ATOMIC_RELEASE);
+        xTaskNotifyGive(scan_task_handle);
+        if (xSemaphoreTake(task_stopped, scan_period_ticks + pdMS_TO_TICKS(SCAN_CYCLE_STOP_TIMEOUT_MS)) != pdTRUE) {
+            // Log warning; a scan stuck this long is deleted where it is
+            ESP_LOGW(TAG, "Scan cycle did not reach a scan boundary, deleting it");
+        }
+        vTaskDelete(scan_task_handle);
+        scan_task_handle = NULL;
+        // Log scan cycle stop
+        ESP_LOGI(TAG, "Scan cycle stopped");
+    }
+    scan_program = NULL;
+    pending_program = NULL;
+}
@@ -0,0 +1,51 @@
+#ifndef SCAN_CYCLE_H
+#define SCAN_CYCLE_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#include "ladder_program.h"
+
+/**
+ * @brief Default PLC scan cycle period in milliseconds.
+ */
+#define SCAN_CYCLE_DEFAULT_PERIOD_MS 10
+
+/**
+ * @brief Starts the scan cycle task executing all rungs of a program in order.
+ * @param program Pointer to the compiled program; must stay valid until scan_cycle_stop().
+ * @param period_ms Scan cycle period in milliseconds (0 selects the default).
+ * @return esp_err_t ESP_OK on success, error code otherwise.
+ */
+esp_err_t scan_cycle_start(const LadderProgram *program, uint32_t period_ms);
+
+/**
+ * @brief Longest wait for the scan cycle to take a swapped program, on top of one period.
+ */
+#define SCAN_CYCLE_SWAP_TIMEOUT_MS 500
+
+/**
+ * @brief Replaces the program of the running scan cycle between two scans.
+ *
+ * The scan cycle is woken for an early scan, which already runs the new program; the previous
+ * program is no longer referenced once this returns ESP_OK.
+ * @param program Pointer to the compiled program; must stay valid until it is replaced or stopped.
+ * @return esp_err_t ESP_OK once the program runs, ESP_ERR_INVALID_STATE if the scan cycle is not
+ *                   running, ESP_ERR_TIMEOUT if it did not take the program (it keeps the previous one).
+ */
+esp_err_t scan_cycle_swap(const LadderProgram *program);
+
+/**
+ * @brief Longest wait for the scan cycle to finish its scan when stopping, on top of one period.
+ */
+#define SCAN_CYCLE_STOP_TIMEOUT_MS 500
+
+/**
+ * @brief Stops the scan cycle task if it is running.
+ *
+ * The task ends between two scans, after the output phase of its last scan, so no rung is
+ * left half executed. It is deleted where it is only if it does not get there in time.
+ */
+void scan_cycle_stop(void);
+
+#endif // SCAN_CYCLE_H
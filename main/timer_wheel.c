@@ -0,0 +1,275 @@
+#include "timer_wheel.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+/**
+ * @brief Tag for logging messages from the timer wheel module.
+ */
+static const char *TAG = "TIMER_WHEEL";
+
+/**
+ * @brief End of a slot list.
+ */
+#define WHEEL_NONE 0xFFFF
+
+/**
+ * @brief Longest delay armed at once; longer timers are re-armed by their owner on expiry.
+ */
+#define WHEEL_MAX_DELAY_MS (1u << 30)
+
+/**
+ * @brief Wheel entry of a timer id, linked into the slot of its deadline.
+ */
+typedef struct {
+    uint32_t deadline;  ///< Tick at which the timer expires.
+    uint16_t next;      ///< Next entry in the slot, or WHEEL_NONE.
+    uint16_t prev;      ///< Previous entry in the slot, or WHEEL_NONE.
+    bool armed;         ///< Entry is linked into a slot.
+} WheelEntry;
+
+/**
+ * @brief Lock shared by the tick callback and the scan task.
+ */
+static portMUX_TYPE wheel_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Entries by timer id (heap, grow-only so it outlives configuration reloads).
+ */
+static WheelEntry *entries = NULL;
+
+/**
+ * @brief Allocated number of entries.
+ */
+static size_t entry_capacity = 0;
+
+/**
+ * @brief Number of valid timer ids.
+ */
+static size_t entry_count = 0;
+
+/**
+ * @brief Expired ids not dispatched yet, one bit per id.
+ */
+static uint32_t *expired_bits = NULL;
+
+/**
+ * @brief First entry of each slot.
+ */
+static uint16_t slot_heads[TIMER_WHEEL_SLOTS];
+
+/**
+ * @brief Number of armed entries; the tick timer only runs while this is non-zero.
+ */
+static size_t armed_count = 0;
+
+/**
+ * @brief Last tick processed by the tick callback.
+ */
+static uint32_t last_tick = 0;
+
+/**
+ * @brief Periodic esp_timer advancing the wheel.
+ */
+static esp_timer_handle_t tick_timer = NULL;
+
+/**
+ * @brief Task notified when timers expire.
+ */
+static TaskHandle_t listener = NULL;
+
+/**
+ * @brief Gets the current wheel tick.
+ * @return uint32_t Milliseconds since boot, wrapping.
+ */
+static inline uint32_t current_tick(void) {
+    return (uint32_t)(esp_timer_get_time() / TIMER_WHEEL_TICK_US);
+}
+
+/**
+ * @brief Links an entry into the slot of its deadline. Called with wheel_lock held.
+ * @param id Timer id.
+ */
+static void link_entry(uint16_t id) {
+    WheelEntry *e = &entries[id];
+    uint16_t *head = &slot_heads[e->deadline & (TIMER_WHEEL_SLOTS - 1)];
+    e->prev = WHEEL_NONE;
+    e->next = *head;
+    if (*head != WHEEL_NONE) entries[*head].prev = id;
+    *head = id;
+    e->armed = true;
+}
+
+/**
+ * @brief Unlinks an entry from its slot. Called with wheel_lock held.
+ * @param id Timer id.
+ */
+static void unlink_entry(uint16_t id) {
+    WheelEntry *e = &entries[id];
+    if (e->prev != WHEEL_NONE) entries[e->prev].next = e->next;
+    else slot_heads[e->deadline & (TIMER_WHEEL_SLOTS - 1)] = e->next;
+    if (e->next != WHEEL_NONE) entries[e->next].prev = e->prev;
+    e->armed = false;
+}
+
+/**
+ * @brief Starts the tick timer; already running is fine.
+ */
+static void start_ticking(void) {
+    esp_err_t err = esp_timer_start_periodic(tick_timer, TIMER_WHEEL_TICK_US);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Failed to start tick timer: %s", esp_err_to_name(err));
+    }
+}
+
+/**
+ * @brief Advances the wheel to the current tick and reports the expired timers.
+ * @param arg Unused.
+ */
+static void wheel_tick(void *arg) {
+    uint32_t now = current_tick();
+    bool expired = false;
+
+    portENTER_CRITICAL(&wheel_lock);
+    // Visit every slot passed since the last tick, each at most once
+    uint32_t ticks = now - last_tick;
+    if (ticks > TIMER_WHEEL_SLOTS) ticks = TIMER_WHEEL_SLOTS;
+    for (uint32_t i = 1; i <= ticks; i++) {
+        uint16_t id = slot_heads[(last_tick + i) & (TIMER_WHEEL_SLOTS - 1)];
+        while (id != WHEEL_NONE) {
+            uint16_t next = entries[id].next;
+            // Entries of later rounds share the slot and stay
+            if ((int32_t)(entries[id].deadline - now) <= 0) {
+                unlink_entry(id);
+                armed_count--;
+                __atomic_fetch_or(&expired_bits[id >> 5], 1u << (id & 31), __ATOMIC_RELAXED);
+                expired = true;
+            }
+            id = next;
+        }
+    }
+    last_tick = now;
+    bool idle = armed_count == 0;
+    TaskHandle_t task = listener;
+    portEXIT_CRITICAL(&wheel_lock);
+
+    if (expired && task) {
+        xTaskNotifyGive(task);
+    }
+    if (idle) {
+        // Stop ticking; a timer armed meanwhile may have found the timer still running
+        esp_timer_stop(tick_timer);
+        portENTER_CRITICAL(&wheel_lock);
+        bool rearmed = armed_count != 0;
+        portEXIT_CRITICAL(&wheel_lock);
+        if (rearmed) start_ticking();
+    }
+}
+
+bool timer_wheel_reset(size_t capacity) {
+    if (!tick_timer) {
+        const esp_timer_create_args_t args = {
+            .callback = wheel_tick,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "timer_wheel",
+        };
+        esp_err_t err = esp_timer_create(&args, &tick_timer);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create tick timer: %s", esp_err_to_name(err));
+            tick_timer = NULL;
+            return false;
+        }
+    }
+    esp_timer_stop(tick_timer);
+
+    // Empty the wheel first so a late tick does not walk the entries while they move
+    portENTER_CRITICAL(&wheel_lock);
+    entry_count = 0;
+    armed_count = 0;
+    for (size_t i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        slot_heads[i] = WHEEL_NONE;
+    }
+    portEXIT_CRITICAL(&wheel_lock);
+
+    if (capacity >= WHEEL_NONE) {
+        ESP_LOGE(TAG, "Too many timer ids (%zu)", capacity);
+        return false;
+    }
+    if (capacity > entry_capacity) {
+        WheelEntry *new_entries = realloc(entries, capacity * sizeof(WheelEntry));
+        if (new_entries) entries = new_entries;
+        uint32_t *new_bits = realloc(expired_bits, ((capacity + 31) / 32) * sizeof(uint32_t));
+        if (new_bits) expired_bits = new_bits;
+        if (!new_entries || !new_bits) {
+            ESP_LOGE(TAG, "Failed to allocate %zu timer entries", capacity);
+            return false;
+        }
+        entry_capacity = capacity;
+    }
+    if (capacity) {
+        memset(entries, 0, capacity * sizeof(WheelEntry));
+        memset(expired_bits, 0, ((capacity + 31) / 32) * sizeof(uint32_t));
+    }
+
+    portENTER_CRITICAL(&wheel_lock);
+    entry_count = capacity;
+    portEXIT_CRITICAL(&wheel_lock);
+    return true;
+}
+
+void timer_wheel_set_listener(TaskHandle_t task) {
+    portENTER_CRITICAL(&wheel_lock);
+    listener = task;
+    portEXIT_CRITICAL(&wheel_lock);
+}
+
+void timer_wheel_schedule(uint16_t id, uint32_t delay_ms) {
+    if (delay_ms > WHEEL_MAX_DELAY_MS) delay_ms = WHEEL_MAX_DELAY_MS;
+    bool start = false;
+
+    portENTER_CRITICAL(&wheel_lock);
+    if (id >= entry_count) {
+        portEXIT_CRITICAL(&wheel_lock);
+        return;
+    }
+    WheelEntry *e = &entries[id];
+    if (e->armed) {
+        unlink_entry(id);
+    } else if (armed_count++ == 0) {
+        // The wheel was idle: continue from now instead of catching up
+        last_tick = current_tick();
+        start = true;
+    }
+    __atomic_fetch_and(&expired_bits[id >> 5], ~(1u << (id & 31)), __ATOMIC_RELAXED);
+    // One extra tick because the current one has partly elapsed
+    e->deadline = current_tick() + delay_ms + 1;
+    link_entry(id);
+    portEXIT_CRITICAL(&wheel_lock);
+
+    if (start) start_ticking();
+}
+
+void timer_wheel_cancel(uint16_t id) {
+    portENTER_CRITICAL(&wheel_lock);
+    if (id < entry_count) {
+        if (entries[id].armed) {
+            unlink_entry(id);
+            armed_count--;
+        }
+        __atomic_fetch_and(&expired_bits[id >> 5], ~(1u << (id & 31)), __ATOMIC_RELAXED);
+    }
+    portEXIT_CRITICAL(&wheel_lock);
+}
+
+void timer_wheel_dispatch(TimerWheelExpiryFn on_expiry) {
+    size_t words = (entry_count + 31) / 32;
+    for (size_t wi = 0; wi < words; wi++) {
+        uint32_t bits = __atomic_exchange_n(&expired_bits[wi], 0, __ATOMIC_RELAXED);
+        while (bits) {
+            int bit = __builtin_ctz(bits);
+            bits &= bits - 1;
+            on_expiry((uint16_t)(wi * 32 + bit));
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/**
+ * @brief Resolution of the timer wheel in microseconds.
+ */
+#define TIMER_WHEEL_TICK_US 1000
+
+/**
+ * @brief Number of wheel slots; must be a power of two. Longer delays wrap around the wheel.
+ */
+#define TIMER_WHEEL_SLOTS 256
+
+/**
+ * @brief Callback receiving the id of an expired timer.
+ * @param id Id passed to timer_wheel_schedule.
+ */
+typedef void (*TimerWheelExpiryFn)(uint16_t id);
+
+/**
+ * @brief Cancels all timers and sizes the wheel for ids below capacity.
+ * @param capacity Number of timer ids (the variable count), 0 to only cancel.
+ * @return bool True on success, false on allocation failure (the wheel is then empty).
+ */
+bool timer_wheel_reset(size_t capacity);
+
+/**
+ * @brief Sets the task notified when timers expire.
+ * @param task Task to notify with xTaskNotifyGive, or NULL.
+ */
+void timer_wheel_set_listener(TaskHandle_t task);
+
+/**
+ * @brief Arms a timer, replacing a pending expiry of the same id.
+ *
+ * The expiry is reported at least delay_ms after the call, and at most one tick later.
+ * @param id Timer id below the capacity.
+ * @param delay_ms Delay in milliseconds.
+ */
+void timer_wheel_schedule(uint16_t id, uint32_t delay_ms);
+
+/**
+ * @brief Disarms a timer and drops its expiry if it was not collected yet.
+ * @param id Timer id below the capacity.
+ */
+void timer_wheel_cancel(uint16_t id);
+
+/**
+ * @brief Calls a function for every timer that expired since the previous call.
+ * @param on_expiry Function called with the id of each expired timer.
+ */
+void timer_wheel_dispatch(TimerWheelExpiryFn on_expiry);
+
+#endif // TIMER_WHEEL_H
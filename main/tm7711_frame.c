@@ -0,0 +1,25 @@
+#include "tm7711_frame.h"
+
+int tm7711_frame_bits(unsigned char next_select) {
+    switch (next_select) {
+        case CH1_10HZ: return CH1_10HZ_CLK;
+        case CH1_40HZ: return CH1_40HZ_CLK;
+        case CH2_TEMP: return CH2_TEMP_CLK;
+        default: return 0;
+    }
+}
+
+bool tm7711_clock_valid(uint32_t clock_hz) {
+    if (clock_hz == 0) {
+        return false;
+    }
+    // Half period in nanoseconds, rounded down so the check errs on the short side
+    uint64_t phase_ns = 500000000ull / clock_hz;
+    return phase_ns >= TM7711_SCK_PHASE_MIN_NS && phase_ns >= TM7711_DOUT_VALID_MAX_NS &&
+           phase_ns < TM7711_SCK_HIGH_MAX_US * 1000ull;
+}
+
+uint32_t tm7711_frame_decode(const uint8_t *rx) {
+    // The mode pulses after the data bits clock out no data
+    return ((uint32_t)rx[0] << 16) | ((uint32_t)rx[1] << 8) | rx[2];
+}
@@ -0,0 +1,91 @@
+#ifndef TM7711_FRAME_H
+#define TM7711_FRAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Timing and framing of a TM7711 readout, shared by the bit-banged and the SPI backends.
+ * This file has no ESP-IDF dependencies, so it builds on the host as well.
+ */
+
+/**
+ * @brief Mode for Channel 1 with 10 Hz sampling rate.
+ */
+#define CH1_10HZ    0x01
+
+/**
+ * @brief Mode for Channel 1 with 40 Hz sampling rate.
+ */
+#define CH1_40HZ    0x02
+
+/**
+ * @brief Mode for Channel 2, temperature measurement.
+ */
+#define CH2_TEMP    0x03
+
+/**
+ * @brief Number of clock pulses for Channel 1 at 10 Hz.
+ */
+#define CH1_10HZ_CLK  25
+
+/**
+ * @brief Number of clock pulses for Channel 1 at 40 Hz.
+ */
+#define CH1_40HZ_CLK  27
+
+/**
+ * @brief Number of clock pulses for Channel 2 temperature measurement.
+ */
+#define CH2_TEMP_CLK  26
+
+/**
+ * @brief Number of data bits in a sample, MSB first.
+ */
+#define TM7711_DATA_BITS 24
+
+/**
+ * @brief Longest PD_SCK high time in microseconds; at 60 us the chip powers down.
+ */
+#define TM7711_SCK_HIGH_MAX_US 50
+
+/**
+ * @brief Shortest PD_SCK high and low time in nanoseconds.
+ */
+#define TM7711_SCK_PHASE_MIN_NS 200
+
+/**
+ * @brief Longest delay from the PD_SCK rising edge until DOUT holds the next bit, in nanoseconds.
+ */
+#define TM7711_DOUT_VALID_MAX_NS 100
+
+/**
+ * @brief PD_SCK frequency of the SPI backend.
+ */
+#define TM7711_SPI_CLOCK_HZ 1000000
+
+/**
+ * @brief Number of PD_SCK pulses of a readout, which selects the mode of the next conversion.
+ * @param next_select Mode (CH1_10HZ, CH1_40HZ or CH2_TEMP).
+ * @return int 25 to 27 pulses, or 0 for an unknown mode.
+ */
+int tm7711_frame_bits(unsigned char next_select);
+
+/**
+ * @brief Checks that a PD_SCK clock with 50% duty cycle meets the TM7711 timing.
+ *
+ * DOUT is sampled on the falling edge (SPI mode 1), so the high phase must also cover the
+ * DOUT settling time.
+ * @param clock_hz PD_SCK frequency.
+ * @return bool True if the high and low phases are within the datasheet limits.
+ */
+bool tm7711_clock_valid(uint32_t clock_hz);
+
+/**
+ * @brief Extracts the sample from the bits received during a readout.
+ * @param rx Received bits, MSB first; at least the first 3 bytes are used.
+ * @return uint32_t Raw 24-bit sample.
+ */
+uint32_t tm7711_frame_decode(const uint8_t *rx);
+
+#endif // TM7711_FRAME_H
@@ -4,12 +4,21 @@
 #include "esp_log.h"
 #include <math.h>
 #include "device_config.h"
+#include "process_image.h"
+#include "pulse_counter.h"
+#include "esp_timer.h"
+#include "name_index.h"
+#include "arena.h"
+#include "config_image.h"
+#include "json_writer.h"
+#include "cbor.h"
 
 #include "mqtt.h"
 #include "cJSON.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 
 #include "adc_sensor.h"
 
@@ -20,6 +29,32 @@ static const char *TAG = "VARIABLES";
 
 // Global variables
 VariablesList variables_list = {0};
+VariableStore variable_store = {0};
+
+/**
+ * @brief Hash index mapping variable names to positions in variables_list.
+ */
+static NameIndex variable_index = {0};
+
+/**
+ * @brief Position of the "Current Time" variable in variables_list, or -1 if there is none.
+ */
+static int current_time_index = -1;
+
+/**
+ * @brief Bitmaps of variables changed since the last publish to each monitor, one bit per variables_list entry.
+ */
+static uint32_t *dirty_bits[MONITOR_CONSUMER_COUNT] = {0};
+
+/**
+ * @brief Dirty bits taken by the delta being formatted for each monitor, handed back if it does not fit the buffer.
+ */
+static uint32_t *taken_bits[MONITOR_CONSUMER_COUNT] = {0};
+
+/**
+ * @brief Number of variable sets loaded since boot, identifying the current variable indices.
+ */
+static uint32_t variables_generation = 0;
 
 /**
  * @brief Handle for the OneWire read task.
@@ -43,6 +78,26 @@ static TaskHandle_t adc_sensor_task_handle = NULL;
  */
 static void adc_sensor_read_task(void *pvParameters);
 
+/**
+ * @brief Set while the sensor tasks must stay parked for a variables reload.
+ */
+static bool sensor_tasks_hold = false;
+
+/**
+ * @brief Given by each sensor task when it parks for a variables reload.
+ */
+static SemaphoreHandle_t sensor_tasks_parked = NULL;
+
+/**
+ * @brief Variables being replaced by reload_variables; their records stay valid in config_arena until it is reset.
+ */
+static VariablesList previous_list = {0};
+
+/**
+ * @brief Name index of previous_list.
+ */
+static NameIndex previous_index = {0};
+
 /**
  * @brief Initialize the global variable list as empty.
  */
@@ -59,90 +114,191 @@ static void variables_list_init(void) {
  * @return bool True if addition succeeds, false otherwise.
  */
 static bool variables_list_add(VariableType type, void *data) {
+    if (variables_list.count >= variables_list.capacity) return false;
     variables_list.nodes[variables_list.count].type = type;
     variables_list.nodes[variables_list.count].data = data;
+    // Every record starts with its Variable base
+    ((Variable *)data)->index = (uint16_t)variables_list.count;
     variables_list.count++;
     return true;
 }
 
 /**
- * @brief Free memory allocated for a single variable.
- * @param type Type of the variable.
- * @param data Pointer to the variable data.
+ * @brief Mark a variable as changed for the next delta to one monitor.
+ * @param consumer Monitor link.
+ * @param index Position of the variable in variables_list.
  */
-static void free_variable(VariableType type, void *data) {
-    if (!data) return;
-    Variable *base = NULL;
-    switch (type) {
-        case VAR_TYPE_DIGITAL_ANALOG_IO: {
-            DigitalAnalogInputOutput *daio = (DigitalAnalogInputOutput *)data;
-            base = &daio->base;
-            if (daio->pin_number) free(daio->pin_number);
-            break;
-        }
-        case VAR_TYPE_ONE_WIRE: {
-            OneWireInput *owi = (OneWireInput *)data;
-            base = &owi->base;
-            if (owi->pin_number) free(owi->pin_number);
-            break;
-        }
-        case VAR_TYPE_ADC_SENSOR: {
-            ADCSensor *adcs = (ADCSensor *)data;
-            base = &adcs->base;
-            if (adcs->sensor_type) free(adcs->sensor_type);
-            if (adcs->pd_sck) free(adcs->pd_sck);
-            if (adcs->dout) free(adcs->dout);
-            if (adcs->sampling_rate) free(adcs->sampling_rate);
-            break;
-        }
-        case VAR_TYPE_BOOLEAN: {
-            Boolean *b = (Boolean *)data;
-            base = &b->base;
-            break;
-        }
-        case VAR_TYPE_NUMBER: {
-            Number *n = (Number *)data;
-            base = &n->base;
-            break;
-        }
-        case VAR_TYPE_COUNTER: {
-            Counter *c = (Counter *)data;
-            base = &c->base;
-            break;
-        }
-        case VAR_TYPE_TIMER: {
-            Timer *t = (Timer *)data;
-            base = &t->base;
-            break;
-        }
-        case VAR_TYPE_TIME: {
-            Time *t = (Time *)data;
-            base = &t->base;
-            break;
-        }
+static inline void consumer_mark_dirty(MonitorConsumer consumer, uint16_t index) {
+    if (dirty_bits[consumer]) __atomic_fetch_or(&dirty_bits[consumer][index >> 5], 1u << (index & 31), __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Mark a variable as changed for the next delta to every monitor.
+ * @param index Position of the variable in variables_list.
+ */
+static inline void variable_mark_dirty(uint16_t index) {
+    for (int c = 0; c < MONITOR_CONSUMER_COUNT; c++) {
+        consumer_mark_dirty((MonitorConsumer)c, index);
     }
-    if (base) {
-        if (base->name) free(base->name);
-        if (base->type) free(base->type);
+}
+
+/**
+ * @brief Clear the per-type variable arrays and the string pool (their memory belongs to config_arena).
+ */
+static void variable_store_clear(void) {
+    memset(&variable_store, 0, sizeof(variable_store));
+}
+
+/**
+ * @brief Copy a string into the variable string pool.
+ * @param str String to copy; NULL is stored as an empty string.
+ * @return char* Pointer to the pooled copy.
+ */
+static char *pool_strdup(const char *str) {
+    if (!str) str = "";
+    size_t len = strlen(str) + 1;
+    char *copy = variable_store.string_pool + variable_store.string_pool_used;
+    memcpy(copy, str, len);
+    variable_store.string_pool_used += len;
+    return copy;
+}
+
+/**
+ * @brief Size a string occupies in the string pool.
+ * @param str String to measure; NULL counts as an empty string.
+ * @return size_t Number of bytes including the terminator.
+ */
+static size_t pooled_size(const char *str) {
+    return (str ? strlen(str) : 0) + 1;
+}
+
+/**
+ * @brief Get a string field of a JSON object.
+ * @param obj JSON object.
+ * @param key Field name.
+ * @return const char* Field value, or NULL if missing or not a string.
+ */
+static const char *json_string(cJSON *obj, const char *key) {
+    cJSON *item = cJSON_GetObjectItem(obj, key);
+    return cJSON_IsString(item) ? item->valuestring : NULL;
+}
+
+/**
+ * @brief Get a numeric field of a JSON object.
+ * @param obj JSON object.
+ * @param key Field name.
+ * @return double Field value, or 0 if missing or not a number.
+ */
+static double json_number(cJSON *obj, const char *key) {
+    cJSON *item = cJSON_GetObjectItem(obj, key);
+    return cJSON_IsNumber(item) ? item->valuedouble : 0;
+}
+
+/**
+ * @brief Map a variable type string to its VariableType.
+ * @param type_str Type string from the configuration.
+ * @return VariableType Parsed type (unknown types are treated as Time variables).
+ */
+static VariableType parse_variable_type(const char *type_str) {
+    if (strcmp(type_str, "Digital Input") == 0 || strcmp(type_str, "Digital Output") == 0 || 
+        strcmp(type_str, "Analog Input") == 0 || strcmp(type_str, "Analog Output") == 0) {
+        return VAR_TYPE_DIGITAL_ANALOG_IO;
+    } else if (strcmp(type_str, "One Wire Input") == 0) {
+        return VAR_TYPE_ONE_WIRE;
+    } else if (strcmp(type_str, "ADC Sensor") == 0) {
+        return VAR_TYPE_ADC_SENSOR;
+    } else if (strcmp(type_str, "Boolean") == 0) {
+        return VAR_TYPE_BOOLEAN;
+    } else if (strcmp(type_str, "Number") == 0) {
+        return VAR_TYPE_NUMBER;
+    } else if (strcmp(type_str, "Counter") == 0) {
+        return VAR_TYPE_COUNTER;
+    } else if (strcmp(type_str, "Timer") == 0) {
+        return VAR_TYPE_TIMER;
     }
-    free(data);
+    return VAR_TYPE_TIME;
 }
 
 /**
- * @brief Free the global variable list and all associated variables.
+ * @brief Allocate the per-type arrays and string pool with known sizes.
+ * @param counts Number of records per VariableType.
+ * @param pool_size Size of the string pool in bytes.
+ * @return bool True if allocation succeeds, false otherwise.
  */
-static void variables_list_free(void) {
-    if (!variables_list.nodes) return;
+static bool variable_store_alloc_sized(const size_t counts[], size_t pool_size) {
+    bool ok = true;
+    #define STORE_ALLOC(field, type, count) \
+        if (count) { variable_store.field = arena_calloc(&config_arena, count, sizeof(type)); ok = ok && variable_store.field; }
+    STORE_ALLOC(ios, DigitalAnalogInputOutput, counts[VAR_TYPE_DIGITAL_ANALOG_IO]);
+    STORE_ALLOC(one_wires, OneWireInput, counts[VAR_TYPE_ONE_WIRE]);
+    STORE_ALLOC(adc_sensors, ADCSensor, counts[VAR_TYPE_ADC_SENSOR]);
+    STORE_ALLOC(booleans, Boolean, counts[VAR_TYPE_BOOLEAN]);
+    STORE_ALLOC(numbers, Number, counts[VAR_TYPE_NUMBER]);
+    STORE_ALLOC(counters, Counter, counts[VAR_TYPE_COUNTER]);
+    STORE_ALLOC(timers, Timer, counts[VAR_TYPE_TIMER]);
+    STORE_ALLOC(times, Time, counts[VAR_TYPE_TIME]);
+    #undef STORE_ALLOC
+
+    variable_store.string_pool = arena_alloc(&config_arena, pool_size);
+    variable_store.string_pool_size = pool_size;
+    return ok && variable_store.string_pool;
+}
 
-    for (size_t i = 0; i < variables_list.count; i++) {
-        free_variable(variables_list.nodes[i].type, variables_list.nodes[i].data);
+/**
+ * @brief Size the per-type arrays and string pool for a Variables array and allocate them.
+ * @param variables cJSON array of variable definitions.
+ * @return bool True if allocation succeeds, false otherwise.
+ */
+static bool variable_store_alloc(cJSON *variables) {
+    size_t counts[VAR_TYPE_TIME + 1] = {0};
+    size_t pool_size = 0;
+
+    cJSON *var = NULL;
+    cJSON_ArrayForEach(var, variables) {
+        const char *type_str = json_string(var, "Type");
+        const char *name = json_string(var, "Name");
+        if (!type_str || !name) continue;
+
+        VariableType var_type = parse_variable_type(type_str);
+        counts[var_type]++;
+        pool_size += pooled_size(name) + pooled_size(type_str);
+        if (var_type == VAR_TYPE_DIGITAL_ANALOG_IO || var_type == VAR_TYPE_ONE_WIRE) {
+            pool_size += pooled_size(json_string(var, "Pin"));
+        } else if (var_type == VAR_TYPE_COUNTER) {
+            pool_size += pooled_size(json_string(var, "Source"));
+        } else if (var_type == VAR_TYPE_ADC_SENSOR) {
+            pool_size += pooled_size(json_string(var, "Sensor Type")) + pooled_size(json_string(var, "PD_SCK")) +
+                         pooled_size(json_string(var, "DOUT")) + pooled_size(json_string(var, "Sampling Rate")) +
+                         pooled_size(json_string(var, "Readout"));
+        }
     }
 
-    free(variables_list.nodes);
-    variables_list.nodes = NULL;
-    variables_list.count = 0;
-    variables_list.capacity = 0;
-    ESP_LOGI(TAG, "Variables List freed");
+    return variable_store_alloc_sized(counts, pool_size);
+}
+
+/**
+ * @brief Drop the references to the loaded variables, leaving the sensor tasks and their states alone.
+ */
+static void variables_list_drop(void) {
+    // Drop the name index first, it borrows the variable names
+    name_index_free(&variable_index);
+    current_time_index = -1;
+    memset(dirty_bits, 0, sizeof(dirty_bits));
+    memset(taken_bits, 0, sizeof(taken_bits));
+
+    // Counter records are dropped below, their pulse counters go with them
+    pulse_counter_release_all();
+
+    // Nodes and records live in config_arena; only the references are dropped here
+    variable_store_clear();
+    variables_list_init();
+}
+
+/**
+ * @brief Stop the variable tasks and release the global variable list.
+ */
+static void variables_list_free(void) {
+    bool loaded = variables_list.nodes != NULL;
 
     // Delete one_wire_read_task if it exists
     if (one_wire_task_handle) {
@@ -153,10 +309,16 @@ static void variables_list_free(void) {
 
     // Delete adc_sensor_task_handle if it exists
     if (adc_sensor_task_handle) {
+        adc_sensor_set_listener(NULL);
         vTaskDelete(adc_sensor_task_handle);
         adc_sensor_task_handle = NULL;
         ESP_LOGI(TAG, "Deleted adc_sensor_read_task");
     }
+    adc_sensor_release_all();
+
+    variables_list_drop();
+    if (!loaded) return;
+    ESP_LOGI(TAG, "Variables List freed");
 
     // Free memory for ADC sensor states
     extern ADCSensorState sensor_states[];
@@ -169,285 +331,707 @@ static void variables_list_free(void) {
     sensor_state_count = 0;
 }
 
-bool load_variables(cJSON *variables) {
-    variables_list_free();
+/**
+ * @brief Get the base structure of a variable node.
+ * @param node Pointer to the variable node.
+ * @return Variable* Pointer to the base structure, or NULL if the type is unknown.
+ */
+static Variable *get_variable_base(const VariableNode *node) {
+    switch (node->type) {
+        case VAR_TYPE_DIGITAL_ANALOG_IO: return &((DigitalAnalogInputOutput *)node->data)->base;
+        case VAR_TYPE_ONE_WIRE: return &((OneWireInput *)node->data)->base;
+        case VAR_TYPE_ADC_SENSOR: return &((ADCSensor *)node->data)->base;
+        case VAR_TYPE_BOOLEAN: return &((Boolean *)node->data)->base;
+        case VAR_TYPE_NUMBER: return &((Number *)node->data)->base;
+        case VAR_TYPE_TIME: return &((Time *)node->data)->base;
+        case VAR_TYPE_COUNTER: return &((Counter *)node->data)->base;
+        case VAR_TYPE_TIMER: return &((Timer *)node->data)->base;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Index the loaded variables and start the sensor tasks they need.
+ * @return bool True on success, false otherwise (the variables are then freed).
+ */
+static bool variables_finish_load(void) {
+    // Index variable names; the first variable with a given name wins, as with a linear search
+    if (!name_index_init(&variable_index, variables_list.count, &config_arena)) {
+        ESP_LOGE(TAG, "Memory allocation failure");
+        variables_list_free();
+        return false;
+    }
+    for (size_t i = 0; i < variables_list.count; i++) {
+        VariableNode *node = &variables_list.nodes[i];
+        Variable *base = get_variable_base(node);
+        if (base && base->name) {
+            name_index_insert(&variable_index, base->name, (uint32_t)i);
+        }
+        if (current_time_index < 0 && node->type == VAR_TYPE_TIME && strcmp(base->type, "Current Time") == 0) {
+            current_time_index = (int)i;
+        }
+    }
+
+    // One dirty bit per variable and monitor for delta publishing
+    size_t dirty_words = (variables_list.count + 31) / 32;
+    for (int c = 0; c < MONITOR_CONSUMER_COUNT; c++) {
+        dirty_bits[c] = arena_calloc(&config_arena, dirty_words, sizeof(uint32_t));
+        taken_bits[c] = arena_calloc(&config_arena, dirty_words, sizeof(uint32_t));
+        if (!dirty_bits[c] || !taken_bits[c]) {
+            ESP_LOGE(TAG, "Memory allocation failure");
+            variables_list_free();
+            return false;
+        }
+    }
+
+    // Bind counters with a source to a pulse counter on that pin
+    for (size_t i = 0; i < variable_store.counter_count; i++) {
+        Counter *c = &variable_store.counters[i];
+        c->pulse_unit = -1;
+        if (!c->source || !c->source[0]) continue;
+        gpio_num_t gpio;
+        if (!find_pin_by_name(c->source, &gpio)) {
+            ESP_LOGE(TAG, "Source %s of '%s' not found", c->source, c->base.name);
+            continue;
+        }
+        if (process_image_is_captured(gpio)) {
+            // The PCNT channel reconfigures the pin and would disable its edge interrupt
+            ESP_LOGE(TAG, "Source %s of '%s' is an interrupt input, not counting its pulses", c->source, c->base.name);
+            continue;
+        }
+        c->pulse_unit = pulse_counter_attach(gpio);
+    }
+
+    // New indices for binary monitor clients
+    variables_generation++;
+
+    // Create one_wire_read_task only if needed; a reload keeps the running one
+    if (variable_store.one_wire_count > 0 && !one_wire_task_handle) {
+        if (xTaskCreate(one_wire_read_task, "one_wire_read_task", 4096, NULL, 5, &one_wire_task_handle) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create one_wire_read_task");
+            variables_list_free();
+            return false;
+        }
+        ESP_LOGI(TAG, "Created one_wire_read_task");
+    }
+
+    // Create adc_sensor_read_task only if needed; a reload keeps the running one
+    if (variable_store.adc_sensor_count > 0 && !adc_sensor_task_handle) {
+        if (xTaskCreate(adc_sensor_read_task, "adc_sensor_read_task", 4096, NULL, 5, &adc_sensor_task_handle) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create adc_sensor_read_task");
+            variables_list_free();
+            return false;
+        }
+        ESP_LOGI(TAG, "Created adc_sensor_read_task");
+    }
+
+    return true;
+}
+
+/**
+ * @brief Find the record a variable had before a reload.
+ * @param name Variable name.
+ * @param type Type the variable has now.
+ * @return void* Pointer to the previous record, or NULL if there was none of that type.
+ */
+static void *find_previous_record(const char *name, VariableType type) {
+    uint32_t index;
+    if (!previous_list.nodes || !name_index_find(&previous_index, name, &index)) {
+        return NULL;
+    }
+    VariableNode *node = &previous_list.nodes[index];
+    return node->type == type ? node->data : NULL;
+}
+
+/**
+ * @brief Check whether an ADC sensor was already initialized with the same type, pins, rate and readout before a reload.
+ * @param adcs Pointer to the new ADC sensor record.
+ * @return bool True if the sensor can be used without re-initializing it.
+ */
+static bool adc_sensor_unchanged(const ADCSensor *adcs) {
+    const ADCSensor *prev = find_previous_record(adcs->base.name, VAR_TYPE_ADC_SENSOR);
+    return prev && strcmp(prev->sensor_type, adcs->sensor_type) == 0 &&
+           strcmp(prev->pd_sck, adcs->pd_sck) == 0 && strcmp(prev->dout, adcs->dout) == 0 &&
+           strcmp(prev->sampling_rate, adcs->sampling_rate) == 0 && strcmp(prev->readout, adcs->readout) == 0;
+}
+
+/**
+ * @brief Allocate and fill the variable records from a Variables array.
+ * @param variables cJSON array of variable definitions.
+ * @return bool True on success, false otherwise (the variables are then freed).
+ */
+static bool load_variable_records(cJSON *variables) {
     variables_list_init();
 
     // Count variables and allocate exact capacity
     size_t var_count = cJSON_GetArraySize(variables);
-    variables_list.nodes = (VariableNode *)calloc(var_count, sizeof(VariableNode));
-    if (!variables_list.nodes) {
+    variables_list.nodes = (VariableNode *)arena_calloc(&config_arena, var_count, sizeof(VariableNode));
+    if (!variables_list.nodes || !variable_store_alloc(variables)) {
         ESP_LOGE(TAG, "Memory allocation failure");
+        variable_store_clear();
+        variables_list_init();
         return false;
     }
     variables_list.capacity = var_count;
 
     cJSON *var = NULL;
     cJSON_ArrayForEach(var, variables) {
-        cJSON *type_item = cJSON_GetObjectItem(var, "Type");
-        cJSON *name_item = cJSON_GetObjectItem(var, "Name");
-
-        const char *type_str = type_item->valuestring;
-        const char *name = name_item->valuestring;
-
-        VariableType var_type;
-        if (strcmp(type_str, "Digital Input") == 0 || strcmp(type_str, "Digital Output") == 0 || 
-            strcmp(type_str, "Analog Input") == 0 || strcmp(type_str, "Analog Output") == 0) {
-            var_type = VAR_TYPE_DIGITAL_ANALOG_IO;
-        } else if (strcmp(type_str, "One Wire Input") == 0) {
-            var_type = VAR_TYPE_ONE_WIRE;
-        } else if (strcmp(type_str, "ADC Sensor") == 0) {
-            var_type = VAR_TYPE_ADC_SENSOR;
-        } else if (strcmp(type_str, "Boolean") == 0) {
-            var_type = VAR_TYPE_BOOLEAN;
-        } else if (strcmp(type_str, "Number") == 0) {
-            var_type = VAR_TYPE_NUMBER;
-        } else if (strcmp(type_str, "Counter") == 0) {
-            var_type = VAR_TYPE_COUNTER;
-        } else if (strcmp(type_str, "Timer") == 0) {
-            var_type = VAR_TYPE_TIMER;
-        } else {
-            var_type = VAR_TYPE_TIME;
+        const char *type_str = json_string(var, "Type");
+        const char *name = json_string(var, "Name");
+        if (!type_str || !name) {
+            ESP_LOGE(TAG, "Variable missing Type or Name, skipping");
+            continue;
         }
 
+        VariableType var_type = parse_variable_type(type_str);
         void *data = NULL;
         switch (var_type) {
             case VAR_TYPE_DIGITAL_ANALOG_IO: {
-                DigitalAnalogInputOutput *daio = (DigitalAnalogInputOutput *)calloc(1, sizeof(DigitalAnalogInputOutput));
-                if (!daio) {
-                    ESP_LOGE(TAG, "Memory allocation failure");
-                    variables_list_free();
-                    return false;
+                DigitalAnalogInputOutput *daio = &variable_store.ios[variable_store.io_count++];
+                daio->base.name = pool_strdup(name);
+                daio->base.type = pool_strdup(type_str);
+                if (strcmp(type_str, "Digital Input") == 0) daio->kind = IO_KIND_DIGITAL_INPUT;
+                else if (strcmp(type_str, "Digital Output") == 0) daio->kind = IO_KIND_DIGITAL_OUTPUT;
+                else if (strcmp(type_str, "Analog Input") == 0) daio->kind = IO_KIND_ANALOG_INPUT;
+                else daio->kind = IO_KIND_ANALOG_OUTPUT;
+                daio->pin_number = pool_strdup(json_string(var, "Pin"));
+                gpio_num_t gpio;
+                daio->gpio = find_pin_by_name(daio->pin_number, &gpio) ? (int)gpio : -1;
+                if (daio->gpio < 0) {
+                    ESP_LOGE(TAG, "Pin %s of '%s' not found", daio->pin_number, name);
                 }
-                daio->base.name = strdup(name);
-                daio->base.type = strdup(type_str);
-                daio->pin_number = strdup(cJSON_GetObjectItem(var, "Pin")->valuestring);
                 data = daio;
                 break;
             }
             case VAR_TYPE_ONE_WIRE: {
-                OneWireInput *owi = (OneWireInput *)calloc(1, sizeof(OneWireInput));
-                if (!owi) {
-                    ESP_LOGE(TAG, "Memory allocation failure");
-                    variables_list_free();
-                    return false;
-                }
-                owi->base.name = strdup(name);
-                owi->base.type = strdup(type_str);
-                owi->pin_number = strdup(cJSON_GetObjectItem(var, "Pin")->valuestring);
+                OneWireInput *owi = &variable_store.one_wires[variable_store.one_wire_count++];
+                owi->base.name = pool_strdup(name);
+                owi->base.type = pool_strdup(type_str);
+                owi->pin_number = pool_strdup(json_string(var, "Pin"));
                 data = owi;
                 break;
             }
             case VAR_TYPE_ADC_SENSOR: {
-                ADCSensor *adcs = (ADCSensor *)calloc(1, sizeof(ADCSensor));
-                if (!adcs) {
-                    ESP_LOGE(TAG, "Memory allocation failure");
-                    variables_list_free();
-                    return false;
+                ADCSensor *adcs = &variable_store.adc_sensors[variable_store.adc_sensor_count];
+                size_t pool_mark = variable_store.string_pool_used;
+                adcs->base.name = pool_strdup(name);
+                adcs->base.type = pool_strdup(type_str);
+                adcs->sensor_type = pool_strdup(json_string(var, "Sensor Type"));
+                adcs->pd_sck = pool_strdup(json_string(var, "PD_SCK"));
+                adcs->dout = pool_strdup(json_string(var, "DOUT"));
+                adcs->map_low = json_number(var, "Map Low");
+                adcs->map_high = json_number(var, "Map High");
+                adcs->gain = json_number(var, "Gain");
+                adcs->sampling_rate = pool_strdup(json_string(var, "Sampling Rate"));
+                adcs->readout = pool_strdup(json_string(var, "Readout"));
+
+                // Initialize ADC sensor, unless a reload kept it on the same pins
+                esp_err_t ret = ESP_OK;
+                if (!adc_sensor_unchanged(adcs)) {
+                    ret = adc_sensor_init(adcs->sensor_type, adcs->pd_sck, adcs->dout, adcs->sampling_rate, adcs->readout);
                 }
-                adcs->base.name = strdup(name);
-                adcs->base.type = strdup(type_str);
-                adcs->sensor_type = strdup(cJSON_GetObjectItem(var, "Sensor Type")->valuestring);
-                adcs->pd_sck = strdup(cJSON_GetObjectItem(var, "PD_SCK")->valuestring);
-                adcs->dout = strdup(cJSON_GetObjectItem(var, "DOUT")->valuestring);
-                adcs->map_low = cJSON_GetObjectItem(var, "Map Low")->valuedouble;
-                adcs->map_high = cJSON_GetObjectItem(var, "Map High")->valuedouble;
-                adcs->gain = cJSON_GetObjectItem(var, "Gain")->valuedouble;
-                adcs->sampling_rate = strdup(cJSON_GetObjectItem(var, "Sampling Rate")->valuestring);
-                data = adcs;
-
-                // Initialize ADC sensor
-                esp_err_t ret = adc_sensor_init(adcs->sensor_type, adcs->pd_sck, adcs->dout);
                 if (ret != ESP_OK) {
                     ESP_LOGE(TAG, "Failed to initialize ADC Sensor '%s': %d", name, ret);
-                    free_variable(VAR_TYPE_ADC_SENSOR, adcs);
-                    continue; // Skip adding this sensor
+                    // Release the record slot and its strings, skip adding this sensor
+                    memset(adcs, 0, sizeof(*adcs));
+                    variable_store.string_pool_used = pool_mark;
+                    continue;
                 }
+
+                // Resolve pins once; adc_sensor_init has already validated them
+                gpio_num_t pd_sck_pin = GPIO_NUM_NC, dout_pin = GPIO_NUM_NC;
+                find_pin_by_name(adcs->pd_sck, &pd_sck_pin);
+                find_pin_by_name(adcs->dout, &dout_pin);
+                adcs->pd_sck_gpio = pd_sck_pin;
+                adcs->dout_gpio = dout_pin;
+                variable_store.adc_sensor_count++;
+                data = adcs;
                 break;
             }
             case VAR_TYPE_BOOLEAN: {
-                Boolean *b = (Boolean *)malloc(sizeof(Boolean));
-                if (!b) {
-                    ESP_LOGE(TAG, "Memory allocation failure");
-                    variables_list_free();
-                    return false;
-                }
-                b->base.name = strdup(name);
-                b->base.type = strdup(type_str);
+                Boolean *b = &variable_store.booleans[variable_store.boolean_count++];
+                b->base.name = pool_strdup(name);
+                b->base.type = pool_strdup(type_str);
                 b->value = cJSON_IsTrue(cJSON_GetObjectItem(var, "Value"));
                 data = b;
                 break;
             }
             case VAR_TYPE_NUMBER: {
-                Number *n = (Number *)malloc(sizeof(Number));
-                if (!n) {
-                    ESP_LOGE(TAG, "Memory allocation failure");
-                    variables_list_free();
-                    return false;
-                }
-                n->base.name = strdup(name);
-                n->base.type = strdup(type_str);
-                n->value = cJSON_GetObjectItem(var, "Value")->valuedouble;
+                Number *n = &variable_store.numbers[variable_store.number_count++];
+                n->base.name = pool_strdup(name);
+                n->base.type = pool_strdup(type_str);
+                n->value = json_number(var, "Value");
                 data = n;
                 break;
             }
             case VAR_TYPE_COUNTER: {
-                Counter *c = (Counter *)malloc(sizeof(Counter));
-                if (!c) {
-                    ESP_LOGE(TAG, "Memory allocation failure");
-                    variables_list_free();
-                    return false;
-                }
-                c->base.name = strdup(name);
-                c->base.type = strdup(type_str);
-                c->pv = cJSON_GetObjectItem(var, "PV")->valuedouble;
-                c->cv = cJSON_GetObjectItem(var, "CV")->valuedouble;
+                Counter *c = &variable_store.counters[variable_store.counter_count++];
+                c->base.name = pool_strdup(name);
+                c->base.type = pool_strdup(type_str);
+                c->pv = json_number(var, "PV");
+                c->cv = json_number(var, "CV");
                 c->cu = cJSON_IsTrue(cJSON_GetObjectItem(var, "CU"));
                 c->cd = cJSON_IsTrue(cJSON_GetObjectItem(var, "CD"));
                 c->qu = cJSON_IsTrue(cJSON_GetObjectItem(var, "QU"));
                 c->qd = cJSON_IsTrue(cJSON_GetObjectItem(var, "QD"));
+                c->source = pool_strdup(json_string(var, "Source"));
                 data = c;
                 break;
             }
             case VAR_TYPE_TIMER: {
-                Timer *t = (Timer *)malloc(sizeof(Timer));
-                if (!t) {
-                    ESP_LOGE(TAG, "Memory allocation failure");
-                    variables_list_free();
-                    return false;
-                }
-                t->base.name = strdup(name);
-                t->base.type = strdup(type_str);
-                t->pt = cJSON_GetObjectItem(var, "PT")->valuedouble;
-                t->et = cJSON_GetObjectItem(var, "ET")->valuedouble;
+                Timer *t = &variable_store.timers[variable_store.timer_count++];
+                t->base.name = pool_strdup(name);
+                t->base.type = pool_strdup(type_str);
+                t->pt = json_number(var, "PT");
+                t->et = json_number(var, "ET");
                 t->in = cJSON_IsTrue(cJSON_GetObjectItem(var, "IN"));
                 t->q = cJSON_IsTrue(cJSON_GetObjectItem(var, "Q"));
                 data = t;
                 break;
             }
             case VAR_TYPE_TIME: {
-                Time *t = (Time *)malloc(sizeof(Time));
-                if (!t) {
-                    ESP_LOGE(TAG, "Memory allocation failure");
-                    variables_list_free();
-                    return false;
-                }
-                t->base.name = strdup(name);
-                t->base.type = strdup(type_str);
-                t->value = cJSON_GetObjectItem(var, "Value")->valuedouble;
+                Time *t = &variable_store.times[variable_store.time_count++];
+                t->base.name = pool_strdup(name);
+                t->base.type = pool_strdup(type_str);
+                t->value = json_number(var, "Value");
                 data = t;
                 break;
             }
         }
 
         if (!variables_list_add(var_type, data)) {
-            free_variable(var_type, data);
             variables_list_free();
             return false;
         }
     }
+    return true;
+}
+
+bool load_variables(cJSON *variables) {
+    variables_list_free();
+    return load_variable_records(variables) && variables_finish_load();
+}
 
-    // Create one_wire_read_task only if needed
-    bool has_one_wire = false;
+/**
+ * @brief Copy the runtime state of the variables that kept their name and type across a reload.
+ *
+ * Configuration fields (PV, PT, pins, sources) come from the new definitions.
+ */
+static void carry_over_state(void) {
     for (size_t i = 0; i < variables_list.count; i++) {
-        if (variables_list.nodes[i].type == VAR_TYPE_ONE_WIRE) {
-            has_one_wire = true;
-            break;
+        VariableNode *node = &variables_list.nodes[i];
+        void *prev = find_previous_record(get_variable_base(node)->name, node->type);
+        if (!prev) continue;
+        switch (node->type) {
+            case VAR_TYPE_DIGITAL_ANALOG_IO:
+                // The pin state lives in hardware; only the change detection carries over
+                memcpy(((DigitalAnalogInputOutput *)node->data)->reported, ((DigitalAnalogInputOutput *)prev)->reported,
+                       sizeof(((DigitalAnalogInputOutput *)prev)->reported));
+                break;
+            case VAR_TYPE_ONE_WIRE:
+                ((OneWireInput *)node->data)->value = ((OneWireInput *)prev)->value;
+                break;
+            case VAR_TYPE_ADC_SENSOR:
+                ((ADCSensor *)node->data)->value = ((ADCSensor *)prev)->value;
+                break;
+            case VAR_TYPE_BOOLEAN:
+                ((Boolean *)node->data)->value = ((Boolean *)prev)->value;
+                break;
+            case VAR_TYPE_NUMBER:
+                ((Number *)node->data)->value = ((Number *)prev)->value;
+                break;
+            case VAR_TYPE_TIME:
+                ((Time *)node->data)->value = ((Time *)prev)->value;
+                break;
+            case VAR_TYPE_COUNTER: {
+                Counter *c = node->data;
+                c->cv = ((Counter *)prev)->cv;
+                c->qu = (c->cv >= c->pv); // Follow a changed PV
+                c->qd = (c->cv <= 0.0);
+                break;
+            }
+            case VAR_TYPE_TIMER: {
+                // A running delay continues; ladder_elements_reset_states re-arms it against the new PT
+                Timer *t = node->data;
+                const Timer *p = prev;
+                t->et = p->et;
+                t->in = p->in;
+                t->q = p->q;
+                t->running = p->running;
+                t->off_delay = p->off_delay;
+                t->armed_pt = p->armed_pt;
+                t->start_us = p->start_us;
+                break;
+            }
         }
     }
-    if (has_one_wire) {
-        if (xTaskCreate(one_wire_read_task, "one_wire_read_task", 4096, NULL, 5, &one_wire_task_handle) != pdPASS) {
-            ESP_LOGE(TAG, "Failed to create one_wire_read_task");
-            variables_list_free();
-            return false;
+}
+
+/**
+ * @brief Stop the acquisition of the ADC sensors whose DOUT pin is no longer used after a reload.
+ *
+ * Called while the previous records are still available.
+ */
+static void release_dropped_adc_sensors(void) {
+    for (size_t i = 0; i < previous_list.count; i++) {
+        VariableNode *node = &previous_list.nodes[i];
+        if (node->type != VAR_TYPE_ADC_SENSOR) continue;
+        const ADCSensor *prev = node->data;
+        bool in_use = false;
+        for (size_t j = 0; j < variable_store.adc_sensor_count && !in_use; j++) {
+            in_use = variable_store.adc_sensors[j].dout_gpio == prev->dout_gpio;
+        }
+        if (!in_use) {
+            adc_sensor_release(prev->sensor_type, (gpio_num_t)prev->dout_gpio);
         }
-        ESP_LOGI(TAG, "Created one_wire_read_task");
     }
+}
 
-    // Create adc_sensor_read_task only if needed
-    bool has_adc_sensor = false;
-    for (size_t i = 0; i < variables_list.count; i++) {
-        if (variables_list.nodes[i].type == VAR_TYPE_ADC_SENSOR) {
-            has_adc_sensor = true;
-            break;
+/**
+ * @brief Drop the ADC filter states of sensors that no longer exist after a reload.
+ */
+static void prune_sensor_states(void) {
+    extern ADCSensorState sensor_states[];
+    extern int sensor_state_count;
+    int kept = 0;
+    for (int i = 0; i < sensor_state_count; i++) {
+        VariableNode *node = sensor_states[i].name ? find_variable(sensor_states[i].name) : NULL;
+        if (node && node->type == VAR_TYPE_ADC_SENSOR) {
+            sensor_states[kept++] = sensor_states[i];
+        } else {
+            free(sensor_states[i].name);
         }
     }
-    if (has_adc_sensor) {
-        if (xTaskCreate(adc_sensor_read_task, "adc_sensor_read_task", 4096, NULL, 5, &adc_sensor_task_handle) != pdPASS) {
-            ESP_LOGE(TAG, "Failed to create adc_sensor_read_task");
-            variables_list_free();
-            return false;
+    sensor_state_count = kept;
+}
+
+/**
+ * @brief Park the running sensor tasks at their next wait, so the records can be replaced under them.
+ */
+static void sensor_tasks_park(void) {
+    if (!sensor_tasks_parked) {
+        sensor_tasks_parked = xSemaphoreCreateCounting(2, 0);
+    }
+    TaskHandle_t *tasks[] = { &one_wire_task_handle, &adc_sensor_task_handle };
+
+    bool parked = sensor_tasks_parked != NULL;
+    if (parked) {
+        // Drop a late signal of a previous reload, then wake the tasks from their delays
+        while (xSemaphoreTake(sensor_tasks_parked, 0) == pdTRUE) {}
+        __atomic_store_n(&sensor_tasks_hold, true, __ATOMIC_RELEASE);
+        for (size_t i = 0; i < 2; i++) {
+            if (*tasks[i]) xTaskNotifyGive(*tasks[i]);
+        }
+        for (size_t i = 0; i < 2 && parked; i++) {
+            // A task parks once its current sensor read completes
+            if (*tasks[i]) parked = xSemaphoreTake(sensor_tasks_parked, pdMS_TO_TICKS(SENSOR_TASK_PARK_TIMEOUT_MS)) == pdTRUE;
         }
-        ESP_LOGI(TAG, "Created adc_sensor_read_task");
     }
+    if (!parked) {
+        // Stuck in a read: fall back to deleting the tasks, they are recreated after the reload
+        ESP_LOGW(TAG, "Sensor tasks did not park, restarting them");
+        adc_sensor_set_listener(NULL);
+        for (size_t i = 0; i < 2; i++) {
+            if (*tasks[i]) {
+                vTaskDelete(*tasks[i]);
+                *tasks[i] = NULL;
+            }
+        }
+    }
+}
 
-    return true;
+/**
+ * @brief Let the parked sensor tasks continue with the reloaded records.
+ */
+static void sensor_tasks_resume(void) {
+    __atomic_store_n(&sensor_tasks_hold, false, __ATOMIC_RELEASE);
+    if (one_wire_task_handle) xTaskNotifyGive(one_wire_task_handle);
+    if (adc_sensor_task_handle) xTaskNotifyGive(adc_sensor_task_handle);
 }
 
-VariableNode *find_variable(const char *search_name) {
+bool reload_variables(cJSON *variables, ImageWriter *image) {
+    if (!variables_list.nodes) {
+        bool loaded = load_variables(variables);
+        if (loaded && image) variables_write_image(image);
+        return loaded;
+    }
+
+    // Bring pulse counts and elapsed times into the records before their state is copied
+    sync_counters_and_timers();
+    sensor_tasks_park();
+
+    // The previous records stay readable in config_arena while the new ones are built
+    previous_list = variables_list;
+    previous_index = variable_index;
+    variables_list_drop();
+    bool ok = load_variable_records(variables);
+    if (ok) {
+        // The image keeps the configured values; the retained state is only for this run
+        if (image) variables_write_image(image);
+        carry_over_state();
+        release_dropped_adc_sensors();
+    }
+    previous_list = (VariablesList){0};
+    previous_index = (NameIndex){0};
+
+    ok = ok && variables_finish_load();
+    if (ok) {
+        prune_sensor_states();
+        ESP_LOGI(TAG, "Reloaded %zu variables", variables_list.count);
+    } else {
+        variables_list_free();
+    }
+    sensor_tasks_resume();
+    return ok;
+}
+
+/**
+ * @brief Copy a string read from an image into the variable string pool.
+ * @param r Image reader.
+ * @return char* Pointer to the pooled copy, or NULL with r->failed set if it does not fit.
+ */
+static char *pool_read_string(ImageReader *r) {
+    const char *str = image_read_string(r);
+    if (r->failed || pooled_size(str) > variable_store.string_pool_size - variable_store.string_pool_used) {
+        r->failed = true;
+        return NULL;
+    }
+    return pool_strdup(str);
+}
+
+void variables_write_image(ImageWriter *w) {
+    image_write_u32(w, (uint32_t)variable_store.io_count);
+    image_write_u32(w, (uint32_t)variable_store.one_wire_count);
+    image_write_u32(w, (uint32_t)variable_store.adc_sensor_count);
+    image_write_u32(w, (uint32_t)variable_store.boolean_count);
+    image_write_u32(w, (uint32_t)variable_store.number_count);
+    image_write_u32(w, (uint32_t)variable_store.counter_count);
+    image_write_u32(w, (uint32_t)variable_store.timer_count);
+    image_write_u32(w, (uint32_t)variable_store.time_count);
+    image_write_u32(w, (uint32_t)variable_store.string_pool_used);
+    image_write_u32(w, (uint32_t)variables_list.count);
+
+    // Records in variables_list order, so compiled handles stay valid
     for (size_t i = 0; i < variables_list.count; i++) {
         VariableNode *node = &variables_list.nodes[i];
-        Variable *base = NULL;
-
+        Variable *base = get_variable_base(node);
+        image_write_u8(w, (uint8_t)node->type);
+        image_write_string(w, base->name);
+        image_write_string(w, base->type);
         switch (node->type) {
             case VAR_TYPE_DIGITAL_ANALOG_IO: {
-                DigitalAnalogInputOutput *dio = (DigitalAnalogInputOutput *)node->data;
-                base = &dio->base;
+                DigitalAnalogInputOutput *daio = node->data;
+                image_write_string(w, daio->pin_number);
+                image_write_u8(w, (uint8_t)daio->kind);
+                image_write_i32(w, daio->gpio);
                 break;
             }
-            case VAR_TYPE_ONE_WIRE: {
-                OneWireInput *owi = (OneWireInput *)node->data;
-                base = &owi->base;
+            case VAR_TYPE_ONE_WIRE:
+                image_write_string(w, ((OneWireInput *)node->data)->pin_number);
                 break;
-            }
             case VAR_TYPE_ADC_SENSOR: {
-                ADCSensor *adcs = (ADCSensor *)node->data;
-                base = &adcs->base;
+                ADCSensor *adcs = node->data;
+                image_write_string(w, adcs->sensor_type);
+                image_write_string(w, adcs->pd_sck);
+                image_write_string(w, adcs->dout);
+                image_write_i32(w, adcs->pd_sck_gpio);
+                image_write_i32(w, adcs->dout_gpio);
+                image_write_f64(w, adcs->map_low);
+                image_write_f64(w, adcs->map_high);
+                image_write_f64(w, adcs->gain);
+                image_write_string(w, adcs->sampling_rate);
+                image_write_string(w, adcs->readout);
                 break;
             }
-            case VAR_TYPE_BOOLEAN: {
-                Boolean *b = (Boolean *)node->data;
-                base = &b->base;
+            case VAR_TYPE_BOOLEAN:
+                image_write_u8(w, ((Boolean *)node->data)->value);
+                break;
+            case VAR_TYPE_NUMBER:
+                image_write_f64(w, ((Number *)node->data)->value);
+                break;
+            case VAR_TYPE_COUNTER: {
+                Counter *c = node->data;
+                image_write_f64(w, c->pv);
+                image_write_f64(w, c->cv);
+                image_write_u8(w, c->cu);
+                image_write_u8(w, c->cd);
+                image_write_u8(w, c->qu);
+                image_write_u8(w, c->qd);
+                image_write_string(w, c->source);
                 break;
             }
-            case VAR_TYPE_NUMBER: {
-                Number *n = (Number *)node->data;
-                base = &n->base;
+            case VAR_TYPE_TIMER: {
+                Timer *t = node->data;
+                image_write_f64(w, t->pt);
+                image_write_f64(w, t->et);
+                image_write_u8(w, t->in);
+                image_write_u8(w, t->q);
                 break;
             }
-            case VAR_TYPE_TIME: {
-                Time *t = (Time *)node->data;
-                base = &t->base;
+            case VAR_TYPE_TIME:
+                image_write_f64(w, ((Time *)node->data)->value);
+                break;
+        }
+    }
+}
+
+bool load_variables_from_image(ImageReader *r) {
+    variables_list_free();
+    variables_list_init();
+
+    // Allocate the per-type arrays and pool with the sizes recorded in the image
+    size_t counts[VAR_TYPE_TIME + 1];
+    for (int t = 0; t <= VAR_TYPE_TIME; t++) {
+        counts[t] = image_read_count(r, 0);
+    }
+    size_t pool_size = image_read_count(r, 1);
+    size_t var_count = image_read_count(r, 3);
+    if (r->failed) {
+        ESP_LOGE(TAG, "Malformed variables section in configuration image");
+        return false;
+    }
+
+    variables_list.nodes = (VariableNode *)arena_calloc(&config_arena, var_count, sizeof(VariableNode));
+    if (!variables_list.nodes || !variable_store_alloc_sized(counts, pool_size)) {
+        ESP_LOGE(TAG, "Memory allocation failure");
+        variable_store_clear();
+        variables_list_init();
+        return false;
+    }
+    variables_list.capacity = var_count;
+
+    for (size_t i = 0; i < var_count && !r->failed; i++) {
+        VariableType var_type = (VariableType)image_read_u8(r);
+        if (var_type > VAR_TYPE_TIME) {
+            r->failed = true;
+            break;
+        }
+        // Records must fit the per-type counts recorded in the header
+        size_t *type_count = NULL;
+        switch (var_type) {
+            case VAR_TYPE_DIGITAL_ANALOG_IO: type_count = &variable_store.io_count; break;
+            case VAR_TYPE_ONE_WIRE: type_count = &variable_store.one_wire_count; break;
+            case VAR_TYPE_ADC_SENSOR: type_count = &variable_store.adc_sensor_count; break;
+            case VAR_TYPE_BOOLEAN: type_count = &variable_store.boolean_count; break;
+            case VAR_TYPE_NUMBER: type_count = &variable_store.number_count; break;
+            case VAR_TYPE_COUNTER: type_count = &variable_store.counter_count; break;
+            case VAR_TYPE_TIMER: type_count = &variable_store.timer_count; break;
+            case VAR_TYPE_TIME: type_count = &variable_store.time_count; break;
+        }
+        if (*type_count >= counts[var_type]) {
+            r->failed = true;
+            break;
+        }
+        size_t slot = (*type_count)++;
+
+        Variable *base = NULL;
+        void *data = NULL;
+        switch (var_type) {
+            case VAR_TYPE_DIGITAL_ANALOG_IO: data = &variable_store.ios[slot]; break;
+            case VAR_TYPE_ONE_WIRE: data = &variable_store.one_wires[slot]; break;
+            case VAR_TYPE_ADC_SENSOR: data = &variable_store.adc_sensors[slot]; break;
+            case VAR_TYPE_BOOLEAN: data = &variable_store.booleans[slot]; break;
+            case VAR_TYPE_NUMBER: data = &variable_store.numbers[slot]; break;
+            case VAR_TYPE_COUNTER: data = &variable_store.counters[slot]; break;
+            case VAR_TYPE_TIMER: data = &variable_store.timers[slot]; break;
+            case VAR_TYPE_TIME: data = &variable_store.times[slot]; break;
+        }
+        variables_list_add(var_type, data);
+        base = get_variable_base(&variables_list.nodes[variables_list.count - 1]);
+        base->name = pool_read_string(r);
+        base->type = pool_read_string(r);
+
+        switch (var_type) {
+            case VAR_TYPE_DIGITAL_ANALOG_IO: {
+                DigitalAnalogInputOutput *daio = data;
+                daio->pin_number = pool_read_string(r);
+                daio->kind = (IOKind)image_read_u8(r);
+                daio->gpio = image_read_i32(r);
                 break;
             }
+            case VAR_TYPE_ONE_WIRE:
+                ((OneWireInput *)data)->pin_number = pool_read_string(r);
+                break;
+            case VAR_TYPE_ADC_SENSOR: {
+                ADCSensor *adcs = data;
+                adcs->sensor_type = pool_read_string(r);
+                adcs->pd_sck = pool_read_string(r);
+                adcs->dout = pool_read_string(r);
+                adcs->pd_sck_gpio = image_read_i32(r);
+                adcs->dout_gpio = image_read_i32(r);
+                adcs->map_low = image_read_f64(r);
+                adcs->map_high = image_read_f64(r);
+                adcs->gain = image_read_f64(r);
+                adcs->sampling_rate = pool_read_string(r);
+                adcs->readout = pool_read_string(r);
+                if (r->failed) {
+                    break;
+                }
+
+                // Initialize ADC sensor; the record is kept so compiled handles stay valid
+                esp_err_t ret = adc_sensor_init(adcs->sensor_type, adcs->pd_sck, adcs->dout, adcs->sampling_rate, adcs->readout);
+                if (ret != ESP_OK) {
+                    ESP_LOGE(TAG, "Failed to initialize ADC Sensor '%s': %d", base->name, ret);
+                }
+                break;
+            }
+            case VAR_TYPE_BOOLEAN:
+                ((Boolean *)data)->value = image_read_u8(r);
+                break;
+            case VAR_TYPE_NUMBER:
+                ((Number *)data)->value = image_read_f64(r);
+                break;
             case VAR_TYPE_COUNTER: {
-                Counter *c = (Counter *)node->data;
-                base = &c->base;
+                Counter *c = data;
+                c->pv = image_read_f64(r);
+                c->cv = image_read_f64(r);
+                c->cu = image_read_u8(r);
+                c->cd = image_read_u8(r);
+                c->qu = image_read_u8(r);
+                c->qd = image_read_u8(r);
+                c->source = pool_read_string(r);
                 break;
             }
             case VAR_TYPE_TIMER: {
-                Timer *t = (Timer *)node->data;
-                base = &t->base;
+                Timer *t = data;
+                t->pt = image_read_f64(r);
+                t->et = image_read_f64(r);
+                t->in = image_read_u8(r);
+                t->q = image_read_u8(r);
                 break;
             }
+            case VAR_TYPE_TIME:
+                ((Time *)data)->value = image_read_f64(r);
+                break;
         }
-        if (base && strcmp(base->name, search_name) == 0) 
-            return node;
     }
-    return NULL;
+
+    if (r->failed) {
+        ESP_LOGE(TAG, "Malformed variables section in configuration image");
+        variables_list_free();
+        return false;
+    }
+
+    return variables_finish_load();
+}
+
+void unload_variables(void) {
+    variables_list_free();
+}
+
+VariableNode *find_variable(const char *search_name) {
+    uint32_t index;
+    if (!name_index_find(&variable_index, search_name, &index)) {
+        return NULL;
+    }
+    return &variables_list.nodes[index];
 }
 
 VariableNode *find_current_time_variable(void) {
-    for (size_t i = 0; i < variables_list.count; i++) {
-        VariableNode *node = &variables_list.nodes[i];
-        if (node->type == VAR_TYPE_TIME) {
-            Time *t = (Time *)node->data;
-            if (strcmp(t->base.type, "Current Time") == 0) {
-                return node;
-            }
-        }
+    if (current_time_index < 0) {
+        return NULL;
     }
-    return NULL;
+    return &variables_list.nodes[current_time_index];
 }
 
 /**
@@ -481,39 +1065,88 @@ void parse_variable_name(const char *var_name, char *base_name, size_t base_name
     }
 }
 
-bool read_variable(const char *var_name) {
+/**
+ * @brief Map a variable name suffix to a variable member.
+ * @param suffix Suffix returned by parse_variable_name (e.g. ".CV"), or NULL.
+ * @return VariableMember Member selected by the suffix.
+ */
+static VariableMember parse_variable_member(const char *suffix) {
+    if (!suffix) return VAR_MEMBER_VALUE;
+    if (strcmp(suffix, ".CU") == 0) return VAR_MEMBER_CU;
+    if (strcmp(suffix, ".CD") == 0) return VAR_MEMBER_CD;
+    if (strcmp(suffix, ".QU") == 0) return VAR_MEMBER_QU;
+    if (strcmp(suffix, ".QD") == 0) return VAR_MEMBER_QD;
+    if (strcmp(suffix, ".PV") == 0) return VAR_MEMBER_PV;
+    if (strcmp(suffix, ".CV") == 0) return VAR_MEMBER_CV;
+    if (strcmp(suffix, ".IN") == 0) return VAR_MEMBER_IN;
+    if (strcmp(suffix, ".Q") == 0) return VAR_MEMBER_Q;
+    if (strcmp(suffix, ".PT") == 0) return VAR_MEMBER_PT;
+    if (strcmp(suffix, ".ET") == 0) return VAR_MEMBER_ET;
+    return VAR_MEMBER_VALUE;
+}
+
+bool resolve_variable(const char *var_name, VariableHandle *handle) {
+    handle->index = VARIABLE_HANDLE_INVALID;
+    handle->type = 0;
+    handle->member = VAR_MEMBER_VALUE;
+    if (!var_name) return false;
+
     char base_name[MAX_VAR_NAME_LENGTH];
     const char *variable_parameter;
     parse_variable_name(var_name, base_name, sizeof(base_name), &variable_parameter);
     VariableNode *node = find_variable(base_name);
+    if (!node) return false;
+
+    handle->index = (uint16_t)(node - variables_list.nodes);
+    handle->type = (uint8_t)node->type;
+    handle->member = (uint8_t)parse_variable_member(variable_parameter);
+    return true;
+}
+
+VariableNode *get_variable_node(VariableHandle handle) {
+    if (handle.index >= variables_list.count) return NULL;
+    return &variables_list.nodes[handle.index];
+}
+
+const char *get_variable_name(VariableHandle handle) {
+    VariableNode *node = get_variable_node(handle);
+    Variable *base = node ? get_variable_base(node) : NULL;
+    return base ? base->name : "(invalid)";
+}
+
+bool read_variable_handle(VariableHandle handle) {
+    VariableNode *node = get_variable_node(handle);
+    if (!node) return false;
 
     switch (node->type) {
         case VAR_TYPE_DIGITAL_ANALOG_IO: {
             DigitalAnalogInputOutput *dio = (DigitalAnalogInputOutput *)node->data;
-            Variable *base = &dio->base;
-            if (strcmp(base->type, "Digital Input") == 0) 
-                return get_digital_input_value(dio->pin_number);
-            else if (strcmp(base->type, "Digital Output") == 0)
-                return get_digital_output_value(dio->pin_number);
+            if (dio->kind == IO_KIND_DIGITAL_INPUT) 
+                return process_image_get_input((gpio_num_t)dio->gpio);
+            else if (dio->kind == IO_KIND_DIGITAL_OUTPUT)
+                return process_image_get_output((gpio_num_t)dio->gpio);
             break;
         }
         case VAR_TYPE_BOOLEAN: {
             Boolean *b = (Boolean *)node->data;
             return b->value;
-            break;
         }
         case VAR_TYPE_COUNTER: {
             Counter *c = (Counter *)node->data;
-            if (strcmp(variable_parameter, ".CU") == 0) return c->cu;
-            else if (strcmp(variable_parameter, ".CD") == 0) return c->cd;
-            else if (strcmp(variable_parameter, ".QU") == 0) return c->qu;
-            else if (strcmp(variable_parameter, ".QD") == 0) return c->qd;
+            sync_counter_pulses(c);
+            switch (handle.member) {
+                case VAR_MEMBER_CU: return c->cu;
+                case VAR_MEMBER_CD: return c->cd;
+                case VAR_MEMBER_QU: return c->qu;
+                case VAR_MEMBER_QD: return c->qd;
+                default: break;
+            }
             break;
         }
         case VAR_TYPE_TIMER: {
             Timer *t = (Timer *)node->data;
-            if (strcmp(variable_parameter, ".IN") == 0) return t->in;
-            else if (strcmp(variable_parameter, ".Q") == 0) return t->q;
+            if (handle.member == VAR_MEMBER_IN) return t->in;
+            else if (handle.member == VAR_MEMBER_Q) return t->q;
             break;
         }
         default:
@@ -522,69 +1155,157 @@ bool read_variable(const char *var_name) {
     return false;
 }
 
-void write_variable(const char *var_name, bool value) {
-    char base_name[MAX_VAR_NAME_LENGTH];
-    const char *variable_parameter;
-    parse_variable_name(var_name, base_name, sizeof(base_name), &variable_parameter);
-    VariableNode *node = find_variable(base_name);
+void write_variable_handle(VariableHandle handle, bool value) {
+    VariableNode *node = get_variable_node(handle);
+    if (!node) return;
 
+    bool *field = NULL;
     switch (node->type) {
         case VAR_TYPE_DIGITAL_ANALOG_IO: {
+            // Hardware I/O changes are picked up by sampling when the monitor delta is built
             DigitalAnalogInputOutput *dio = (DigitalAnalogInputOutput *)node->data;
-            set_digital_output_value(dio->pin_number, value);
+            process_image_set_output((gpio_num_t)dio->gpio, value);
             return;
         }
         case VAR_TYPE_BOOLEAN: {
             Boolean *b = (Boolean *)node->data;
-            b->value = value;
-            return;
+            field = &b->value;
+            break;
         }
         case VAR_TYPE_COUNTER: {
             Counter *c = (Counter *)node->data;
-            if (strcmp(variable_parameter, ".CU") == 0) {
-                c->cu = value;
-                return;
-            } else if (strcmp(variable_parameter, ".CD") == 0) {
-                c->cd = value;
-                return;
-            } else if (strcmp(variable_parameter, ".QU") == 0) {
-                c->qu = value;
-                return;
-            } else if (strcmp(variable_parameter, ".QD") == 0) {
-                c->qd = value;
-                return;
+            switch (handle.member) {
+                case VAR_MEMBER_CU: field = &c->cu; break;
+                case VAR_MEMBER_CD: field = &c->cd; break;
+                case VAR_MEMBER_QU: field = &c->qu; break;
+                case VAR_MEMBER_QD: field = &c->qd; break;
+                default: break;
             }
             break;
         }
         case VAR_TYPE_TIMER: {
             Timer *t = (Timer *)node->data;
-            if (strcmp(variable_parameter, ".IN") == 0) {
-                t->in = value;
-                return;
-            } else if (strcmp(variable_parameter, ".Q") == 0) {
-                t->q = value;
-                return;
-            }
+            if (handle.member == VAR_MEMBER_IN) field = &t->in;
+            else if (handle.member == VAR_MEMBER_Q) field = &t->q;
             break;
         }
         default:
             break;
     }
+
+    // Only an actual change marks the variable dirty
+    if (field && *field != value) {
+        *field = value;
+        variable_mark_dirty(handle.index);
+    }
 }
 
-double read_numeric_variable(const char *var_name) {
-    char base_name[MAX_VAR_NAME_LENGTH];
-    const char *variable_parameter;
-    parse_variable_name(var_name, base_name, sizeof(base_name), &variable_parameter);
-    VariableNode *node = find_variable(base_name);
+void mark_variable_dirty(VariableHandle handle) {
+    if (handle.index < variables_list.count) {
+        variable_mark_dirty(handle.index);
+    }
+}
+
+/**
+ * @brief Get the GPIO of a "Digital Input" variable.
+ * @param handle Variable handle.
+ * @return gpio_num_t GPIO number, or GPIO_NUM_NC if the variable is not a digital input.
+ */
+static gpio_num_t get_digital_input_gpio(VariableHandle handle) {
+    VariableNode *node = get_variable_node(handle);
+    if (!node || node->type != VAR_TYPE_DIGITAL_ANALOG_IO) return GPIO_NUM_NC;
+    DigitalAnalogInputOutput *dio = (DigitalAnalogInputOutput *)node->data;
+    return dio->kind == IO_KIND_DIGITAL_INPUT ? (gpio_num_t)dio->gpio : GPIO_NUM_NC;
+}
+
+void sync_counter_pulses(Counter *counter) {
+    if (counter->pulse_unit < 0) return;
+    int32_t pulses = pulse_counter_take(counter->pulse_unit);
+    if (pulses == 0) return;
+    // A counter with only CD set counts its pulses down
+    counter->cv += (counter->cd && !counter->cu) ? -(double)pulses : (double)pulses;
+    counter->qu = (counter->cv >= counter->pv);
+    counter->qd = (counter->cv <= 0.0);
+    variable_mark_dirty(counter->base.index);
+}
+
+void sync_timer_elapsed(Timer *timer) {
+    if (!timer->running) return;
+    double et = (double)(esp_timer_get_time() - timer->start_us) / 1000.0; // Microseconds to milliseconds
+    if (et > timer->pt) et = timer->pt; // Limit ET to PT until the expiry is dispatched
+    if (et != timer->et) {
+        timer->et = et;
+        variable_mark_dirty(timer->base.index);
+    }
+}
+
+void sync_counters_and_timers(void) {
+    for (size_t i = 0; i < variable_store.counter_count; i++) {
+        sync_counter_pulses(&variable_store.counters[i]);
+    }
+    for (size_t i = 0; i < variable_store.timer_count; i++) {
+        sync_timer_elapsed(&variable_store.timers[i]);
+    }
+}
+
+/**
+ * @brief Counter outputs as reported to a monitor.
+ */
+typedef struct {
+    double cv;  ///< CV including the pulses not yet added by the scan task.
+    bool qu;    ///< QU following cv.
+    bool qd;    ///< QD following cv.
+} CounterView;
+
+/**
+ * @brief Get the current outputs of a counter without writing the record.
+ *
+ * Monitor tasks use this instead of sync_counter_pulses, which only the scan task may call.
+ * @param c Pointer to the counter.
+ * @return CounterView Outputs including the pending pulses.
+ */
+static CounterView counter_view(const Counter *c) {
+    CounterView view = { .cv = c->cv, .qu = c->qu, .qd = c->qd };
+    int32_t pulses = c->pulse_unit >= 0 ? pulse_counter_peek(c->pulse_unit) : 0;
+    if (pulses != 0) {
+        view.cv += (c->cd && !c->cu) ? -(double)pulses : (double)pulses;
+        view.qu = (view.cv >= c->pv);
+        view.qd = (view.cv <= 0.0);
+    }
+    return view;
+}
+
+/**
+ * @brief Get the current ET of a timer without writing the record.
+ * @param t Pointer to the timer.
+ * @return double ET in milliseconds, limited to PT.
+ */
+static double timer_et_view(const Timer *t) {
+    if (!t->running) return t->et;
+    double et = (double)(esp_timer_get_time() - t->start_us) / 1000.0; // Microseconds to milliseconds
+    return et > t->pt ? t->pt : et;
+}
+
+bool variable_is_captured_input(VariableHandle handle) {
+    gpio_num_t pin = get_digital_input_gpio(handle);
+    return pin != GPIO_NUM_NC && process_image_is_captured(pin);
+}
+
+uint32_t read_input_edges_handle(VariableHandle handle, bool rising) {
+    gpio_num_t pin = get_digital_input_gpio(handle);
+    return pin != GPIO_NUM_NC ? process_image_get_edges(pin, rising) : 0;
+}
+
+double read_numeric_variable_handle(VariableHandle handle) {
+    VariableNode *node = get_variable_node(handle);
+    if (!node) return 0;
 
     switch (node->type) {
         case VAR_TYPE_DIGITAL_ANALOG_IO: {
             DigitalAnalogInputOutput *dio = (DigitalAnalogInputOutput *)node->data;
-            Variable *base = &dio->base;
-            if (strcmp(base->type, "Analog Input") == 0) 
+            if (dio->kind == IO_KIND_ANALOG_INPUT) 
                 return get_digital_input_value(dio->pin_number);
-            else if (strcmp(base->type, "Analog Output") == 0) 
+            else if (dio->kind == IO_KIND_ANALOG_OUTPUT) 
                 return get_analog_output_value(dio->pin_number);
             break;
         }
@@ -606,19 +1327,22 @@ double read_numeric_variable(const char *var_name) {
         }
         case VAR_TYPE_COUNTER: {
             Counter *c = (Counter *)node->data;
-            if (strcmp(variable_parameter, ".PV") == 0) 
+            sync_counter_pulses(c);
+            if (handle.member == VAR_MEMBER_PV) 
                 return c->pv;
-            else if (strcmp(variable_parameter, ".CV") == 0) 
+            else if (handle.member == VAR_MEMBER_CV) 
                 return c->cv;
             break;
         }
         case VAR_TYPE_TIMER: {
             Timer *t = (Timer *)node->data;
-            if (strcmp(variable_parameter, ".PT") == 0) {
+            if (handle.member == VAR_MEMBER_PT) {
                 return t->pt;
-            } else if (strcmp(variable_parameter, ".ET") == 0) {
+            } else if (handle.member == VAR_MEMBER_ET) {
+                sync_timer_elapsed(t);
                 return t->et;
             }
+            break;
         }
         default: 
             break;
@@ -626,45 +1350,93 @@ double read_numeric_variable(const char *var_name) {
     return 0;
 }
 
-void write_numeric_variable(const char *var_name, double value) {
-    char base_name[MAX_VAR_NAME_LENGTH];
-    const char *variable_parameter;
-    parse_variable_name(var_name, base_name, sizeof(base_name), &variable_parameter);
-    VariableNode *node = find_variable(base_name);
+void write_numeric_variable_handle(VariableHandle handle, double value) {
+    VariableNode *node = get_variable_node(handle);
+    if (!node) return;
 
+    double *field = NULL;
     switch (node->type) {
         case VAR_TYPE_DIGITAL_ANALOG_IO: {
             DigitalAnalogInputOutput *dio = (DigitalAnalogInputOutput *)node->data;
             int int_value = (int)round(value);
             uint8_t scaled_value = int_value < 0 ? 0 : (int_value > 255 ? 255 : (uint8_t)int_value);
             set_analog_output_value(dio->pin_number, scaled_value);
-            break;
+            return;
         }
         case VAR_TYPE_NUMBER: {
             Number *n = (Number *)node->data;
-            n->value = value;
+            field = &n->value;
             break;
         }
         case VAR_TYPE_TIME: {
             Time *t = (Time *)node->data;
-            t->value = value;
+            field = &t->value;
             break;
         }
         case VAR_TYPE_COUNTER: {
             Counter *c = (Counter *)node->data;
-            if (strcmp(variable_parameter, ".PV") == 0) c->pv = value;
-            else if (strcmp(variable_parameter, ".CV") == 0) c->cv = value;
+            sync_counter_pulses(c); // Pulses before the write are overwritten with it
+            if (handle.member == VAR_MEMBER_PV) field = &c->pv;
+            else if (handle.member == VAR_MEMBER_CV) field = &c->cv;
             break;
         }
         case VAR_TYPE_TIMER: {
             Timer *t = (Timer *)node->data;
-            if (strcmp(variable_parameter, ".PT") == 0) t->pt = value;
-            else if (strcmp(variable_parameter, ".ET") == 0) t->et = value;
+            if (handle.member == VAR_MEMBER_PT) field = &t->pt;
+            else if (handle.member == VAR_MEMBER_ET) field = &t->et;
             break;
         }
         default:
             break;
     }
+
+    // Only an actual change marks the variable dirty
+    if (field && *field != value) {
+        *field = value;
+        variable_mark_dirty(handle.index);
+    }
+}
+
+bool read_variable(const char *var_name) {
+    VariableHandle handle;
+    resolve_variable(var_name, &handle);
+    return read_variable_handle(handle);
+}
+
+void write_variable(const char *var_name, bool value) {
+    VariableHandle handle;
+    resolve_variable(var_name, &handle);
+    write_variable_handle(handle, value);
+}
+
+double read_numeric_variable(const char *var_name) {
+    VariableHandle handle;
+    resolve_variable(var_name, &handle);
+    return read_numeric_variable_handle(handle);
+}
+
+void write_numeric_variable(const char *var_name, double value) {
+    VariableHandle handle;
+    resolve_variable(var_name, &handle);
+    write_numeric_variable_handle(handle, value);
+}
+
+/**
+ * @brief Wait between two sensor reads, parking the task while the variables are reloaded.
+ * @param ticks Delay in ticks.
+ * @return bool True if the task was parked; the records it was iterating may have changed.
+ */
+static bool sensor_task_wait(TickType_t ticks) {
+    if (!__atomic_load_n(&sensor_tasks_hold, __ATOMIC_ACQUIRE)) {
+        // A reload wakes the task early through its notification
+        ulTaskNotifyTake(pdTRUE, ticks);
+        if (!__atomic_load_n(&sensor_tasks_hold, __ATOMIC_ACQUIRE)) return false;
+    }
+    xSemaphoreGive(sensor_tasks_parked);
+    while (__atomic_load_n(&sensor_tasks_hold, __ATOMIC_ACQUIRE)) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    return true;
 }
 
 /**
@@ -675,177 +1447,480 @@ static void one_wire_read_task(void *pvParameters)
 {
     while (1)
     {
-        for (size_t i = 0; i < variables_list.count; i++)
+        for (size_t i = 0; i < variable_store.one_wire_count; i++)
         {
-            VariableNode *node = &variables_list.nodes[i];
-            if (node->type == VAR_TYPE_ONE_WIRE)
-            {
-                OneWireInput *owi = (OneWireInput *)node->data;
-                owi->value = get_one_wire_value(owi->pin_number);
-                vTaskDelay(pdMS_TO_TICKS(1000)); // 1 second after each read
+            OneWireInput *owi = &variable_store.one_wires[i];
+            double value = get_one_wire_value(owi->pin_number);
+            if (value != owi->value) {
+                owi->value = value;
+                variable_mark_dirty(owi->base.index);
             }
+            if (sensor_task_wait(pdMS_TO_TICKS(1000))) break; // 1 second after each read; start over after a reload
         }
-        vTaskDelay(pdMS_TO_TICKS(1000)); // 1 second at end
+        sensor_task_wait(pdMS_TO_TICKS(1000)); // 1 second at end
     }
 }
 
 /**
- * @brief Task function to periodically read ADC sensor values.
+ * @brief Task function to collect the ADC sensor samples.
+ *
+ * The sensors are read from their data-ready interrupts; the task wakes for each queued sample.
  * @param pvParameters Task parameters (unused).
  */
 static void adc_sensor_read_task(void *pvParameters)
 {
+    adc_sensor_set_listener(xTaskGetCurrentTaskHandle());
     while (1)
     {
-        for (size_t i = 0; i < variables_list.count; i++)
+        for (size_t i = 0; i < variable_store.adc_sensor_count; i++)
         {
-            VariableNode *node = &variables_list.nodes[i];
-            if (node->type == VAR_TYPE_ADC_SENSOR)
-            {
-                ADCSensor *adcs = (ADCSensor *)node->data;
-                double value = adc_sensor_read(adcs->sensor_type, adcs->pd_sck, adcs->dout, 
-                                              adcs->map_low, adcs->map_high, adcs->gain, 
-                                              adcs->sampling_rate, adcs->base.name);
-                if (value != 0.0 || adcs->value == 0.0) { // Update only if value is valid or previous was 0
-                    adcs->value = value;
-                    // ESP_LOGI(TAG, "ADC Sensor '%s' value: %f", adcs->base.name, adcs->value);
-                } else {
-                    ESP_LOGW(TAG, "Invalid value for ADC Sensor '%s', keeping old: %f", adcs->base.name, adcs->value);
-                }
-                // Adjust delay based on sampling_rate
-                int delay_ms = (strcmp(adcs->sampling_rate, "10Hz") == 0) ? 150 : 100;
-                vTaskDelay(pdMS_TO_TICKS(delay_ms));
+            ADCSensor *adcs = &variable_store.adc_sensors[i];
+            double value;
+            if (adc_sensor_read(adcs->sensor_type, (gpio_num_t)adcs->dout_gpio, adcs->map_low, adcs->map_high,
+                                adcs->gain, adcs->base.name, &value) && value != adcs->value) {
+                adcs->value = value;
+                variable_mark_dirty(adcs->base.index);
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(1000)); // 1 second between cycles
+        // A sample wakes the task early; the timeout only bounds how long a missed edge goes unnoticed
+        sensor_task_wait(pdMS_TO_TICKS(ADC_SENSOR_IDLE_MS));
     }
 }
 
 /**
- * @brief Read all variables as a JSON string.
- * @return char* JSON string containing all variables, or NULL on error.
+ * @brief Read the current value of a digital/analog input/output.
+ * @param dio Pointer to the I/O record.
+ * @return double Current value (0/1 for digital I/O).
  */
-char *read_variables_json(void) {
-    // Create JSON array for all variables
-    cJSON *variables_array = cJSON_CreateArray();
-    if (!variables_array) {
-        ESP_LOGE(TAG, "Failed to create JSON array");
-        return NULL;
+static double io_value(const DigitalAnalogInputOutput *dio) {
+    VariableHandle handle = { .index = dio->base.index, .type = VAR_TYPE_DIGITAL_ANALOG_IO, .member = VAR_MEMBER_VALUE };
+    if (dio->kind == IO_KIND_DIGITAL_INPUT || dio->kind == IO_KIND_DIGITAL_OUTPUT)
+        return read_variable_handle(handle);
+    return read_numeric_variable_handle(handle);
+}
+
+/**
+ * @brief Sample the hardware I/O and mark the ones whose value moved since it was last reported to a consumer.
+ * @param consumer Monitor link about to format a delta.
+ */
+static void sample_io_changes(MonitorConsumer consumer) {
+    for (size_t i = 0; i < variable_store.io_count; i++) {
+        DigitalAnalogInputOutput *dio = &variable_store.ios[i];
+        double value = io_value(dio);
+        if (value != dio->reported[consumer]) {
+            dio->reported[consumer] = value;
+            consumer_mark_dirty(consumer, dio->base.index);
+        }
+    }
+}
+
+/**
+ * @brief Write the dynamic fields of a variable as a member of a monitor delta object.
+ * @param w JSON writer positioned inside the delta object.
+ * @param node Pointer to the variable node.
+ * @param consumer Monitor link whose sampled I/O values are written.
+ */
+static void write_variable_delta(JsonWriter *w, const VariableNode *node, MonitorConsumer consumer) {
+    switch (node->type) {
+        case VAR_TYPE_DIGITAL_ANALOG_IO: {
+            DigitalAnalogInputOutput *dio = (DigitalAnalogInputOutput *)node->data;
+            json_writer_add_number(w, dio->base.name, dio->reported[consumer]);
+            break;
+        }
+        case VAR_TYPE_ONE_WIRE: {
+            OneWireInput *owi = (OneWireInput *)node->data;
+            json_writer_add_number(w, owi->base.name, owi->value);
+            break;
+        }
+        case VAR_TYPE_ADC_SENSOR: {
+            ADCSensor *adcs = (ADCSensor *)node->data;
+            json_writer_add_number(w, adcs->base.name, adcs->value);
+            break;
+        }
+        case VAR_TYPE_BOOLEAN: {
+            Boolean *b = (Boolean *)node->data;
+            json_writer_add_bool(w, b->base.name, b->value);
+            break;
+        }
+        case VAR_TYPE_NUMBER: {
+            Number *n = (Number *)node->data;
+            json_writer_add_number(w, n->base.name, n->value);
+            break;
+        }
+        case VAR_TYPE_COUNTER: {
+            Counter *c = (Counter *)node->data;
+            CounterView view = counter_view(c);
+            json_writer_key(w, c->base.name);
+            json_writer_begin_object(w);
+            json_writer_add_number(w, "PV", c->pv);
+            json_writer_add_number(w, "CV", view.cv);
+            json_writer_add_bool(w, "CU", c->cu);
+            json_writer_add_bool(w, "CD", c->cd);
+            json_writer_add_bool(w, "QU", view.qu);
+            json_writer_add_bool(w, "QD", view.qd);
+            json_writer_end_object(w);
+            break;
+        }
+        case VAR_TYPE_TIMER: {
+            Timer *t = (Timer *)node->data;
+            json_writer_key(w, t->base.name);
+            json_writer_begin_object(w);
+            json_writer_add_number(w, "PT", t->pt);
+            json_writer_add_number(w, "ET", timer_et_view(t));
+            json_writer_add_bool(w, "IN", t->in);
+            json_writer_add_bool(w, "Q", t->q);
+            json_writer_end_object(w);
+            break;
+        }
+        case VAR_TYPE_TIME: {
+            Time *t = (Time *)node->data;
+            json_writer_add_number(w, t->base.name, t->value);
+            break;
+        }
     }
+}
+
+/**
+ * @brief Write all variables as a JSON array.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return size_t Length of the full document; it did not fit if this is >= size.
+ */
+size_t write_variables_json(char *buf, size_t size) {
+    JsonWriter w;
+    json_writer_init(&w, buf, size);
+    json_writer_begin_array(&w);
 
     // Iterate through all variables in the list
     for (size_t i = 0; i < variables_list.count; i++) {
         VariableNode *node = &variables_list.nodes[i];
-        cJSON *var_json = cJSON_CreateObject();
-        if (!var_json) {
-            ESP_LOGE(TAG, "Failed to create JSON object for variable");
-            continue;
-        }
+        Variable *base = get_variable_base(node);
+        json_writer_begin_object(&w);
+        json_writer_add_string(&w, "Type", base->type);
+        json_writer_add_string(&w, "Name", base->name);
 
-        Variable *base = NULL;
         switch (node->type) {
             case VAR_TYPE_DIGITAL_ANALOG_IO: {
                 DigitalAnalogInputOutput *dio = (DigitalAnalogInputOutput *)node->data;
-                base = &dio->base;
-                cJSON_AddStringToObject(var_json, "Type", base->type);
-                cJSON_AddStringToObject(var_json, "Name", base->name);
-                cJSON_AddStringToObject(var_json, "Pin", dio->pin_number);
-                if (strcmp(base->type, "Digital Input") == 0 || strcmp(base->type, "Digital Output") == 0)
-                    cJSON_AddNumberToObject(var_json, "Value", read_variable(base->name));
-                else if (strcmp(base->type, "Analog Input") == 0 || strcmp(base->type, "Analog Output") == 0)
-                    cJSON_AddNumberToObject(var_json, "Value", read_numeric_variable(base->name));
+                json_writer_add_string(&w, "Pin", dio->pin_number);
+                json_writer_add_number(&w, "Value", io_value(dio));
                 break;
             }
             case VAR_TYPE_ONE_WIRE: {
                 OneWireInput *owi = (OneWireInput *)node->data;
-                base = &owi->base;
-                cJSON_AddStringToObject(var_json, "Type", base->type);
-                cJSON_AddStringToObject(var_json, "Name", base->name);
-                cJSON_AddStringToObject(var_json, "Pin", owi->pin_number);
-                cJSON_AddNumberToObject(var_json, "Value", owi->value);
+                json_writer_add_string(&w, "Pin", owi->pin_number);
+                json_writer_add_number(&w, "Value", owi->value);
                 break;
             }
             case VAR_TYPE_ADC_SENSOR: {
                 ADCSensor *adcs = (ADCSensor *)node->data;
-                base = &adcs->base;
-                cJSON_AddStringToObject(var_json, "Type", base->type);
-                cJSON_AddStringToObject(var_json, "Name", base->name);
-                cJSON_AddStringToObject(var_json, "SensorType", adcs->sensor_type);
-                cJSON_AddStringToObject(var_json, "PD_SCK", adcs->pd_sck);
-                cJSON_AddStringToObject(var_json, "DOUT", adcs->dout);
-                cJSON_AddNumberToObject(var_json, "MapLow", adcs->map_low);
-                cJSON_AddNumberToObject(var_json, "MapHigh", adcs->map_high);
-                cJSON_AddNumberToObject(var_json, "Gain", adcs->gain);
-                cJSON_AddStringToObject(var_json, "SamplingRate", adcs->sampling_rate);
-                cJSON_AddNumberToObject(var_json, "Value", adcs->value);
+                json_writer_add_string(&w, "SensorType", adcs->sensor_type);
+                json_writer_add_string(&w, "PD_SCK", adcs->pd_sck);
+                json_writer_add_string(&w, "DOUT", adcs->dout);
+                json_writer_add_number(&w, "MapLow", adcs->map_low);
+                json_writer_add_number(&w, "MapHigh", adcs->map_high);
+                json_writer_add_number(&w, "Gain", adcs->gain);
+                json_writer_add_string(&w, "SamplingRate", adcs->sampling_rate);
+                json_writer_add_string(&w, "Readout", adcs->readout);
+                json_writer_add_number(&w, "Value", adcs->value);
                 break;
             }
             case VAR_TYPE_BOOLEAN: {
                 Boolean *b = (Boolean *)node->data;
-                base = &b->base;
-                cJSON_AddStringToObject(var_json, "Type", base->type);
-                cJSON_AddStringToObject(var_json, "Name", base->name);
-                cJSON_AddBoolToObject(var_json, "Value", b->value);
+                json_writer_add_bool(&w, "Value", b->value);
                 break;
             }
             case VAR_TYPE_NUMBER: {
                 Number *n = (Number *)node->data;
-                base = &n->base;
-                cJSON_AddStringToObject(var_json, "Type", base->type);
-                cJSON_AddStringToObject(var_json, "Name", base->name);
-                cJSON_AddNumberToObject(var_json, "Value", n->value);
+                json_writer_add_number(&w, "Value", n->value);
                 break;
             }
             case VAR_TYPE_COUNTER: {
                 Counter *c = (Counter *)node->data;
-                base = &c->base;
-                cJSON_AddStringToObject(var_json, "Type", base->type);
-                cJSON_AddStringToObject(var_json, "Name", base->name);
-                cJSON_AddNumberToObject(var_json, "PV", c->pv);
-                cJSON_AddNumberToObject(var_json, "CV", c->cv);
-                cJSON_AddBoolToObject(var_json, "CU", c->cu);
-                cJSON_AddBoolToObject(var_json, "CD", c->cd);
-                cJSON_AddBoolToObject(var_json, "QU", c->qu);
-                cJSON_AddBoolToObject(var_json, "QD", c->qd);
+                CounterView view = counter_view(c);
+                json_writer_add_number(&w, "PV", c->pv);
+                json_writer_add_number(&w, "CV", view.cv);
+                json_writer_add_bool(&w, "CU", c->cu);
+                json_writer_add_bool(&w, "CD", c->cd);
+                json_writer_add_bool(&w, "QU", view.qu);
+                json_writer_add_bool(&w, "QD", view.qd);
                 break;
             }
             case VAR_TYPE_TIMER: {
                 Timer *t = (Timer *)node->data;
-                base = &t->base;
-                cJSON_AddStringToObject(var_json, "Type", base->type);
-                cJSON_AddStringToObject(var_json, "Name", base->name);
-                cJSON_AddNumberToObject(var_json, "PT", t->pt);
-                cJSON_AddNumberToObject(var_json, "ET", t->et);
-                cJSON_AddBoolToObject(var_json, "IN", t->in);
-                cJSON_AddBoolToObject(var_json, "Q", t->q);
+                json_writer_add_number(&w, "PT", t->pt);
+                json_writer_add_number(&w, "ET", timer_et_view(t));
+                json_writer_add_bool(&w, "IN", t->in);
+                json_writer_add_bool(&w, "Q", t->q);
                 break;
             }
             case VAR_TYPE_TIME: {
                 Time *t = (Time *)node->data;
-                base = &t->base;
-                cJSON_AddStringToObject(var_json, "Type", base->type);
-                cJSON_AddStringToObject(var_json, "Name", base->name);
-                cJSON_AddNumberToObject(var_json, "Value", t->value);
+                json_writer_add_number(&w, "Value", t->value);
                 break;
             }
         }
 
-        cJSON_AddItemToArray(variables_array, var_json);
+        json_writer_end_object(&w);
     }
 
-    // Convert JSON to string
-    char *json_str = cJSON_PrintUnformatted(variables_array);
-    if (!json_str) {
-        ESP_LOGE(TAG, "Failed to print JSON");
-        cJSON_Delete(variables_array);
-        return NULL;
+    json_writer_end_array(&w);
+    return json_writer_finish(&w);
+}
+
+/**
+ * @brief Take the dirty bits of a consumer into its taken_bits for a delta being formatted.
+ * @param consumer Monitor link formatting the delta.
+ * @return bool True if any variable changed.
+ */
+static bool take_dirty_bits(MonitorConsumer consumer) {
+    bool changed = false;
+    size_t words = (variables_list.count + 31) / 32;
+    for (size_t wi = 0; wi < words; wi++) {
+        taken_bits[consumer][wi] = __atomic_exchange_n(&dirty_bits[consumer][wi], 0, __ATOMIC_RELAXED);
+        changed = changed || taken_bits[consumer][wi];
+    }
+    return changed;
+}
+
+/**
+ * @brief Hand the taken dirty bits back when the delta did not fit its buffer.
+ * @param consumer Monitor link that formatted the delta.
+ */
+static void return_dirty_bits(MonitorConsumer consumer) {
+    size_t words = (variables_list.count + 31) / 32;
+    for (size_t wi = 0; wi < words; wi++) {
+        __atomic_fetch_or(&dirty_bits[consumer][wi], taken_bits[consumer][wi], __ATOMIC_RELAXED);
+    }
+}
+
+size_t write_variables_delta_json(MonitorConsumer consumer, char *buf, size_t size) {
+    if (!dirty_bits[consumer]) return 0;
+
+    sample_io_changes(consumer);
+    if (!take_dirty_bits(consumer)) return 0;
+
+    JsonWriter w;
+    json_writer_init(&w, buf, size);
+    json_writer_begin_object(&w);
+    size_t words = (variables_list.count + 31) / 32;
+    for (size_t wi = 0; wi < words; wi++) {
+        for (uint32_t bits = taken_bits[consumer][wi]; bits; bits &= bits - 1) {
+            write_variable_delta(&w, &variables_list.nodes[wi * 32 + (size_t)__builtin_ctz(bits)], consumer);
+        }
+    }
+    json_writer_end_object(&w);
+
+    size_t len = json_writer_finish(&w);
+    if (len >= size) return_dirty_bits(consumer);
+    return len;
+}
+
+void variables_clear_dirty(MonitorConsumer consumer) {
+    if (!dirty_bits[consumer]) return;
+
+    // Record the current I/O values as reported, the keyframe carries them
+    for (size_t i = 0; i < variable_store.io_count; i++) {
+        variable_store.ios[i].reported[consumer] = io_value(&variable_store.ios[i]);
+    }
+    size_t words = (variables_list.count + 31) / 32;
+    for (size_t w = 0; w < words; w++) {
+        __atomic_store_n(&dirty_bits[consumer][w], 0, __ATOMIC_RELAXED);
+    }
+}
+
+uint32_t get_variables_generation(void) {
+    return variables_generation;
+}
+
+size_t get_variables_count(void) {
+    return variables_list.count;
+}
+
+/**
+ * @brief Write the header shared by all binary monitor frames and open the payload.
+ * @param w CBOR writer.
+ * @param kind Kind of the frame.
+ */
+static void write_monitor_frame_header(CborWriter *w, MonitorFrameKind kind) {
+    cbor_write_map(w, 3);
+    cbor_write_uint(w, MONITOR_KEY_KIND);
+    cbor_write_uint(w, kind);
+    cbor_write_uint(w, MONITOR_KEY_GENERATION);
+    cbor_write_uint(w, variables_generation);
+    cbor_write_uint(w, MONITOR_KEY_PAYLOAD);
+}
+
+/**
+ * @brief Write the dynamic value of a variable in binary form.
+ *
+ * Counters and timers become arrays of their members, [PV, CV, CU, CD, QU, QD] and [PT, ET, IN, Q].
+ * @param w CBOR writer.
+ * @param node Pointer to the variable node.
+ * @param delta Consumer whose sampled I/O values are written for a delta, or NULL to read the I/O.
+ */
+static void write_variable_cbor(CborWriter *w, const VariableNode *node, const MonitorConsumer *delta) {
+    switch (node->type) {
+        case VAR_TYPE_DIGITAL_ANALOG_IO: {
+            DigitalAnalogInputOutput *dio = (DigitalAnalogInputOutput *)node->data;
+            cbor_write_number(w, delta ? dio->reported[*delta] : io_value(dio));
+            break;
+        }
+        case VAR_TYPE_ONE_WIRE:
+            cbor_write_number(w, ((OneWireInput *)node->data)->value);
+            break;
+        case VAR_TYPE_ADC_SENSOR:
+            cbor_write_number(w, ((ADCSensor *)node->data)->value);
+            break;
+        case VAR_TYPE_BOOLEAN:
+            cbor_write_bool(w, ((Boolean *)node->data)->value);
+            break;
+        case VAR_TYPE_NUMBER:
+            cbor_write_number(w, ((Number *)node->data)->value);
+            break;
+        case VAR_TYPE_COUNTER: {
+            Counter *c = (Counter *)node->data;
+            CounterView view = counter_view(c);
+            cbor_write_array(w, 6);
+            cbor_write_number(w, c->pv);
+            cbor_write_number(w, view.cv);
+            cbor_write_bool(w, c->cu);
+            cbor_write_bool(w, c->cd);
+            cbor_write_bool(w, view.qu);
+            cbor_write_bool(w, view.qd);
+            break;
+        }
+        case VAR_TYPE_TIMER: {
+            Timer *t = (Timer *)node->data;
+            cbor_write_array(w, 4);
+            cbor_write_number(w, t->pt);
+            cbor_write_number(w, timer_et_view(t));
+            cbor_write_bool(w, t->in);
+            cbor_write_bool(w, t->q);
+            break;
+        }
+        case VAR_TYPE_TIME:
+            cbor_write_number(w, ((Time *)node->data)->value);
+            break;
+    }
+}
+
+size_t write_variable_names_cbor(uint8_t *buf, size_t size) {
+    CborWriter w;
+    cbor_writer_init(&w, buf, size);
+    write_monitor_frame_header(&w, MONITOR_FRAME_NAMES);
+    cbor_write_array(&w, variables_list.count);
+    for (size_t i = 0; i < variables_list.count; i++) {
+        cbor_write_text(&w, get_variable_base(&variables_list.nodes[i])->name);
+    }
+    return cbor_writer_finish(&w);
+}
+
+size_t write_variables_cbor(uint8_t *buf, size_t size) {
+    CborWriter w;
+    cbor_writer_init(&w, buf, size);
+    write_monitor_frame_header(&w, MONITOR_FRAME_KEYFRAME);
+    cbor_write_array(&w, variables_list.count);
+    for (size_t i = 0; i < variables_list.count; i++) {
+        write_variable_cbor(&w, &variables_list.nodes[i], NULL);
+    }
+    return cbor_writer_finish(&w);
+}
+
+size_t write_variables_delta_cbor(MonitorConsumer consumer, uint8_t *buf, size_t size) {
+    if (!dirty_bits[consumer]) return 0;
+
+    sample_io_changes(consumer);
+    if (!take_dirty_bits(consumer)) return 0;
+
+    CborWriter w;
+    cbor_writer_init(&w, buf, size);
+    write_monitor_frame_header(&w, MONITOR_FRAME_DELTA);
+    cbor_write_map_indefinite(&w);
+    size_t words = (variables_list.count + 31) / 32;
+    for (size_t wi = 0; wi < words; wi++) {
+        for (uint32_t bits = taken_bits[consumer][wi]; bits; bits &= bits - 1) {
+            size_t i = wi * 32 + (size_t)__builtin_ctz(bits);
+            cbor_write_uint(&w, i);
+            write_variable_cbor(&w, &variables_list.nodes[i], &consumer);
+        }
     }
+    cbor_write_break(&w);
 
-    // Free JSON array
-    cJSON_Delete(variables_array);
+    size_t len = cbor_writer_finish(&w);
+    if (len > size) return_dirty_bits(consumer);
+    return len;
+}
+
+void update_variables_from_children_cbor(const uint8_t *data, size_t len) {
+    CborReader r;
+    cbor_reader_init(&r, data, len);
+
+    CborMajorType major;
+    uint64_t count;
+    if (!cbor_read_head(&r, &major, &count) || major != CBOR_MAJOR_MAP) {
+        ESP_LOGE(TAG, "Malformed binary update from child");
+        return;
+    }
+
+    // Each entry maps a Boolean or Number variable name to its value
+    for (uint64_t i = 0; i < count; i++) {
+        const char *name;
+        size_t name_len;
+        double value;
+        bool is_bool;
+        if (!cbor_read_text(&r, &name, &name_len)) break;
+        if (!cbor_read_scalar(&r, &value, &is_bool)) {
+            // Values other than numbers and booleans are ignored
+            if (r.failed || !cbor_skip(&r)) break;
+            continue;
+        }
+        if (name_len >= MAX_VAR_NAME_LENGTH) continue;
+
+        char var_name[MAX_VAR_NAME_LENGTH];
+        memcpy(var_name, name, name_len);
+        var_name[name_len] = '\0';
+        VariableNode *node = find_variable(var_name);
+        if (!node) continue;
+
+        if (node->type == VAR_TYPE_BOOLEAN && is_bool) {
+            Boolean *b = (Boolean *)node->data;
+            if (b->value != (value != 0)) {
+                b->value = value != 0;
+                variable_mark_dirty(b->base.index);
+            }
+        } else if (node->type == VAR_TYPE_NUMBER && !is_bool) {
+            Number *n = (Number *)node->data;
+            if (n->value != value) {
+                n->value = value;
+                variable_mark_dirty(n->base.index);
+            }
+        }
+    }
+    if (r.failed) {
+        ESP_LOGE(TAG, "Malformed binary update from child");
+    }
+}
 
-    // Return JSON string
-    return json_str;
+/**
+ * @brief Encode the Boolean and Number variables sent to parent devices as a CBOR map of name to value.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return size_t Length of the full encoding.
+ */
+static size_t write_parent_sync_cbor(uint8_t *buf, size_t size) {
+    CborWriter w;
+    cbor_writer_init(&w, buf, size);
+    cbor_write_map(&w, variable_store.boolean_count + variable_store.number_count);
+    for (size_t i = 0; i < variable_store.boolean_count; i++) {
+        cbor_write_text(&w, variable_store.booleans[i].base.name);
+        cbor_write_bool(&w, variable_store.booleans[i].value);
+    }
+    for (size_t i = 0; i < variable_store.number_count; i++) {
+        cbor_write_text(&w, variable_store.numbers[i].base.name);
+        cbor_write_number(&w, variable_store.numbers[i].value);
+    }
+    return cbor_writer_finish(&w);
 }
 
 void update_variables_from_children(const char *json_str) {
@@ -859,33 +1934,29 @@ void update_variables_from_children(const char *json_str) {
         return;
     }
 
-    // Iterate through variables in the global list
-    for (size_t i = 0; i < variables_list.count; i++) {
-        VariableNode *node = &variables_list.nodes[i];
-        Variable *base = NULL;
-
-        // Process only Boolean and Number variables
-        if (node->type == VAR_TYPE_BOOLEAN) {
-            Boolean *b = (Boolean *)node->data;
-            base = &b->base;
+    // Sweep Boolean variables
+    for (size_t i = 0; i < variable_store.boolean_count; i++) {
+        Boolean *b = &variable_store.booleans[i];
 
-            // Find matching field in JSON
-            cJSON *json_item = cJSON_GetObjectItem(json, base->name);
-            if (json_item && cJSON_IsBool(json_item)) {
-                b->value = cJSON_IsTrue(json_item);
-                //ESP_LOGI(TAG, "Updated Boolean variable '%s' to %s", base->name, b->value ? "true" : "false");
-            }
+        // Find matching field in JSON
+        cJSON *json_item = cJSON_GetObjectItem(json, b->base.name);
+        if (json_item && cJSON_IsBool(json_item) && b->value != cJSON_IsTrue(json_item)) {
+            b->value = cJSON_IsTrue(json_item);
+            variable_mark_dirty(b->base.index);
+            //ESP_LOGI(TAG, "Updated Boolean variable '%s' to %s", b->base.name, b->value ? "true" : "false");
         }
-        else if (node->type == VAR_TYPE_NUMBER) {
-            Number *n = (Number *)node->data;
-            base = &n->base;
+    }
 
-            // Find matching field in JSON
-            cJSON *json_item = cJSON_GetObjectItem(json, base->name);
-            if (json_item && cJSON_IsNumber(json_item)) {
-                n->value = json_item->valuedouble;
-                //ESP_LOGI(TAG, "Updated Number variable '%s' to %f", base->name, n->value);
-            }
+    // Sweep Number variables
+    for (size_t i = 0; i < variable_store.number_count; i++) {
+        Number *n = &variable_store.numbers[i];
+
+        // Find matching field in JSON
+        cJSON *json_item = cJSON_GetObjectItem(json, n->base.name);
+        if (json_item && cJSON_IsNumber(json_item) && n->value != json_item->valuedouble) {
+            n->value = json_item->valuedouble;
+            variable_mark_dirty(n->base.index);
+            //ESP_LOGI(TAG, "Updated Number variable '%s' to %f", n->base.name, n->value);
         }
     }
 
@@ -894,40 +1965,47 @@ void update_variables_from_children(const char *json_str) {
 }
 
 void send_variables_to_parents() {
-    // Create JSON object for Boolean and Number variables
-    cJSON *variables_json = cJSON_CreateObject();
-    if (!variables_json) {
-        ESP_LOGE(TAG, "Failed to create JSON object");
-        return;
-    }
-
-    // Iterate through variables in the global list
-    for (size_t i = 0; i < variables_list.count; i++) {
-        VariableNode *node = &variables_list.nodes[i];
-        Variable *base = NULL;
+    static CborBuffer parent_buffer = {0}; // Reused between binary parent updates
+    const uint8_t *payload = NULL;
+    size_t payload_len = 0;
+    char *json_str = NULL;
+
+    if (_device.parent_encoding_cbor) {
+        // Binary update keyed by name, parents resolve the names against their own variables
+        if (!cbor_buffer_fill(&parent_buffer, write_parent_sync_cbor)) {
+            ESP_LOGE(TAG, "Failed to encode parent update");
+            return;
+        }
+        payload = parent_buffer.data;
+        payload_len = parent_buffer.len;
+    } else {
+        // Create JSON object for Boolean and Number variables
+        cJSON *variables_json = cJSON_CreateObject();
+        if (!variables_json) {
+            ESP_LOGE(TAG, "Failed to create JSON object");
+            return;
+        }
 
-        // Process only Boolean and Number variables
-        if (node->type == VAR_TYPE_BOOLEAN) {
-            Boolean *b = (Boolean *)node->data;
-            base = &b->base;
-            cJSON_AddBoolToObject(variables_json, base->name, b->value);
+        // Sweep Boolean and Number variables
+        for (size_t i = 0; i < variable_store.boolean_count; i++) {
+            cJSON_AddBoolToObject(variables_json, variable_store.booleans[i].base.name, variable_store.booleans[i].value);
         }
-        else if (node->type == VAR_TYPE_NUMBER) {
-            Number *n = (Number *)node->data;
-            base = &n->base;
-            cJSON_AddNumberToObject(variables_json, base->name, n->value);
+        for (size_t i = 0; i < variable_store.number_count; i++) {
+            cJSON_AddNumberToObject(variables_json, variable_store.numbers[i].base.name, variable_store.numbers[i].value);
         }
-    }
 
-    // Convert JSON to string
-    char *json_str = cJSON_PrintUnformatted(variables_json);
-    if (!json_str) {
-        ESP_LOGE(TAG, "Failed to print JSON");
+        // Convert JSON to string
+        json_str = cJSON_PrintUnformatted(variables_json);
         cJSON_Delete(variables_json);
-        return;
+        if (!json_str) {
+            ESP_LOGE(TAG, "Failed to print JSON");
+            return;
+        }
+        payload = (const uint8_t *)json_str;
+        payload_len = strlen(json_str);
     }
 
-    // Iterate through parent devices and send JSON to each topic
+    // Iterate through parent devices and send the update to each topic
     for (size_t i = 0; i < _device.parent_devices_len; i++) {
         if (_device.parent_devices[i]) {
             // Form topic: parent_devices[i] + TOPIC_CHILDREN_LISTENER
@@ -939,8 +2017,8 @@ void send_variables_to_parents() {
             }
             snprintf(topic, topic_len, "%s%s", _device.parent_devices[i], TOPIC_CHILDREN_LISTENER);
 
-            // Publish JSON string to MQTT topic
-            mqtt_publish(json_str, topic, 0);
+            // Publish the update to MQTT topic
+            mqtt_publish_binary(payload, payload_len, topic, 0);
             //ESP_LOGI(TAG, "Sent variables to parent '%s' on topic '%s'", _device.parent_devices[i], topic);
 
             // Free topic memory
@@ -949,6 +2027,5 @@ void send_variables_to_parents() {
     }
 
     // Free memory
-    cJSON_Delete(variables_json);
     free(json_str);
 }
\ No newline at end of file
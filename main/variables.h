@@ -3,7 +3,9 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <cJSON.h>
+#include "config_image.h"
 
 /**
  * @brief Maximum length for variable names.
@@ -24,12 +26,81 @@ typedef enum {
     VAR_TYPE_TIME               ///< Time variable.
 } VariableType;
 
+/**
+ * @brief Monitor link consuming variable deltas; each keeps its own dirty bits and reported I/O values.
+ */
+typedef enum {
+    MONITOR_CONSUMER_MQTT,  ///< Monitor frames published over MQTT.
+    MONITOR_CONSUMER_BLE,   ///< Monitor frames streamed over BLE notifications.
+    MONITOR_CONSUMER_COUNT  ///< Number of consumers.
+} MonitorConsumer;
+
+/**
+ * @brief Member of a variable selected by a name suffix (e.g. ".CV" of a counter).
+ */
+typedef enum {
+    VAR_MEMBER_VALUE, ///< The variable itself (no suffix).
+    VAR_MEMBER_CU,    ///< Counter count up flag (".CU").
+    VAR_MEMBER_CD,    ///< Counter count down flag (".CD").
+    VAR_MEMBER_QU,    ///< Counter count up output (".QU").
+    VAR_MEMBER_QD,    ///< Counter count down output (".QD").
+    VAR_MEMBER_PV,    ///< Counter preset value (".PV").
+    VAR_MEMBER_CV,    ///< Counter current value (".CV").
+    VAR_MEMBER_IN,    ///< Timer input (".IN").
+    VAR_MEMBER_Q,     ///< Timer output (".Q").
+    VAR_MEMBER_PT,    ///< Timer preset time (".PT").
+    VAR_MEMBER_ET     ///< Timer elapsed time (".ET").
+} VariableMember;
+
+/**
+ * @brief Kind of a digital/analog input/output variable.
+ */
+typedef enum {
+    IO_KIND_DIGITAL_INPUT,  ///< "Digital Input" variable.
+    IO_KIND_DIGITAL_OUTPUT, ///< "Digital Output" variable.
+    IO_KIND_ANALOG_INPUT,   ///< "Analog Input" variable.
+    IO_KIND_ANALOG_OUTPUT   ///< "Analog Output" variable.
+} IOKind;
+
+/**
+ * @brief Index value of a handle that does not refer to any variable.
+ */
+#define VARIABLE_HANDLE_INVALID UINT16_MAX
+
+/**
+ * @brief Pre-resolved reference to a variable member, used instead of a name on the scan path.
+ */
+typedef struct {
+    uint16_t index;  ///< Index of the variable in variables_list, or VARIABLE_HANDLE_INVALID.
+    uint8_t type;    ///< VariableType of the variable.
+    uint8_t member;  ///< VariableMember selected by the name suffix.
+} VariableHandle;
+
+/**
+ * @brief Kind of a binary (CBOR) monitor frame.
+ */
+typedef enum {
+    MONITOR_FRAME_KEYFRAME = 0, ///< Payload is an array of all values in index order.
+    MONITOR_FRAME_DELTA = 1,    ///< Payload is a map of index to value for the changed variables.
+    MONITOR_FRAME_NAMES = 2     ///< Payload is an array of the variable names in index order.
+} MonitorFrameKind;
+
+/**
+ * @brief Keys of the map forming a binary monitor frame.
+ */
+typedef enum {
+    MONITOR_KEY_KIND = 0,       ///< MonitorFrameKind of the frame.
+    MONITOR_KEY_GENERATION = 1, ///< Variables generation the indices refer to.
+    MONITOR_KEY_PAYLOAD = 2     ///< Frame payload.
+} MonitorFrameKey;
+
 /**
  * @brief Base structure for a variable.
  */
 typedef struct {
     char *name;  ///< Variable name.
     char *type;  ///< Variable type as a string.
+    uint16_t index; ///< Position of the variable in variables_list (its dirty bit).
 } Variable;
 
 /**
@@ -38,6 +109,9 @@ typedef struct {
 typedef struct {
     Variable base;      ///< Base variable structure.
     char *pin_number;   ///< Pin number for the I/O.
+    IOKind kind;        ///< Kind of the I/O, resolved from the type string.
+    int gpio;           ///< GPIO resolved from pin_number at load, or -1 if not found.
+    double reported[MONITOR_CONSUMER_COUNT]; ///< Last value sent to each monitor, used to detect hardware-driven changes.
 } DigitalAnalogInputOutput;
 
 /**
@@ -57,10 +131,13 @@ typedef struct {
     char *sensor_type;    ///< Type of the sensor.
     char *pd_sck;         ///< Pin for power-down and serial clock.
     char *dout;           ///< Data output pin.
+    int pd_sck_gpio;      ///< GPIO resolved from pd_sck at load.
+    int dout_gpio;        ///< GPIO resolved from dout at load.
     double map_low;       ///< Lower mapping range for the sensor value.
     double map_high;      ///< Upper mapping range for the sensor value.
     double gain;          ///< Gain factor for the sensor.
     char *sampling_rate;  ///< Sampling rate for the sensor.
+    char *readout;        ///< Peripheral clocking the sensor ("GPIO" or "SPI"), empty for GPIO.
     double value;         ///< Current value of the ADC sensor.
 } ADCSensor;
 
@@ -91,6 +168,8 @@ typedef struct {
     bool cd;        ///< Count down flag.
     bool qu;        ///< Output for count up.
     bool qd;        ///< Output for count down.
+    char *source;   ///< Pin name of the input counted by a pulse counter ("Source"), empty if none.
+    int pulse_unit; ///< Pulse counter unit backing CV, or -1 if the counter is ladder-driven.
 } Counter;
 
 /**
@@ -102,6 +181,10 @@ typedef struct {
     double et;      ///< Elapsed time.
     bool in;        ///< Input state.
     bool q;         ///< Output state.
+    bool running;   ///< Delay is running; the timer wheel reports its end.
+    bool off_delay; ///< Running delay belongs to an off-delay timer.
+    double armed_pt;  ///< PT the running delay was armed with.
+    int64_t start_us; ///< Start of the running delay in microseconds since boot.
 } Timer;
 
 /**
@@ -117,7 +200,7 @@ typedef struct {
  */
 typedef struct {
     VariableType type;  ///< Type of the variable.
-    void *data;         ///< Pointer to the variable data.
+    void *data;         ///< Pointer to the variable record in variable_store.
 } VariableNode;
 
 /**
@@ -129,11 +212,44 @@ typedef struct {
     size_t capacity;      ///< Capacity of the array.
 } VariablesList;
 
+/**
+ * @brief Contiguous per-type storage backing the variables list.
+ *
+ * Each VariableNode points into one of these arrays, and all strings of the
+ * variables (names, types, pins) live in a single string pool.
+ */
+typedef struct {
+    DigitalAnalogInputOutput *ios;  ///< Digital/analog I/O records.
+    size_t io_count;                ///< Number of I/O records.
+    OneWireInput *one_wires;        ///< One-wire input records.
+    size_t one_wire_count;          ///< Number of one-wire records.
+    ADCSensor *adc_sensors;         ///< ADC sensor records.
+    size_t adc_sensor_count;        ///< Number of ADC sensor records.
+    Boolean *booleans;              ///< Boolean records.
+    size_t boolean_count;           ///< Number of boolean records.
+    Number *numbers;                ///< Number records.
+    size_t number_count;            ///< Number of number records.
+    Counter *counters;              ///< Counter records.
+    size_t counter_count;           ///< Number of counter records.
+    Timer *timers;                  ///< Timer records.
+    size_t timer_count;             ///< Number of timer records.
+    Time *times;                    ///< Time records.
+    size_t time_count;              ///< Number of time records.
+    char *string_pool;              ///< Pool holding all variable strings.
+    size_t string_pool_size;        ///< Size of the string pool in bytes.
+    size_t string_pool_used;        ///< Bytes of the string pool in use.
+} VariableStore;
+
 /**
  * @brief Global list of variables.
  */
 extern VariablesList variables_list;
 
+/**
+ * @brief Global per-type storage of the variables in variables_list.
+ */
+extern VariableStore variable_store;
+
 /**
  * @brief Load variables from a cJSON object.
  * @param variables cJSON object containing variable definitions.
@@ -141,6 +257,54 @@ extern VariablesList variables_list;
  */
 bool load_variables(cJSON *variables);
 
+/**
+ * @brief Longest wait for the sensor tasks to finish their current read when variables are reloaded.
+ */
+#define SENSOR_TASK_PARK_TIMEOUT_MS 2000
+
+/**
+ * @brief Longest wait of the ADC sensor task for a sample before it checks the sensors anyway.
+ */
+#define ADC_SENSOR_IDLE_MS 250
+
+/**
+ * @brief Replace the loaded variables in place, keeping the sensor tasks and the state of retained variables.
+ *
+ * A variable with the same name and type as before keeps its runtime state (value, counter CV,
+ * timer IN/Q/ET and a running delay), while its configuration (PV, PT, pins, source) comes
+ * from the new definition. The sensor tasks are parked between two reads instead of being
+ * deleted, and ADC sensors on unchanged pins are not re-initialized. config_arena is not
+ * reset, so the previous records stay allocated until the next full load. The scan cycle
+ * must not run during the reload, since handle indices change.
+ * @param variables cJSON array of variable definitions.
+ * @param image Image writer that receives the variables section with the configured values,
+ *              before the retained state is copied in; NULL to skip.
+ * @return bool True on success; on failure no variables are loaded.
+ */
+bool reload_variables(cJSON *variables, ImageWriter *image);
+
+/**
+ * @brief Load variables from a compiled configuration image.
+ * @param r Image reader positioned at the variables section.
+ * @return bool True if loading succeeds, false otherwise.
+ */
+bool load_variables_from_image(ImageReader *r);
+
+/**
+ * @brief Append the loaded variables to a compiled configuration image.
+ *
+ * Records are written in variables_list order so handles in the compiled program stay valid.
+ * @param w Image writer.
+ */
+void variables_write_image(ImageWriter *w);
+
+/**
+ * @brief Stop the variable tasks and drop all loaded variables.
+ *
+ * Must be called before config_arena is reset, since the variables live in it.
+ */
+void unload_variables(void);
+
 /**
  * @brief Find a variable by name.
  * @param search_name Name of the variable to find.
@@ -154,6 +318,103 @@ VariableNode *find_variable(const char *search_name);
  */
 VariableNode *find_current_time_variable(void);
 
+/**
+ * @brief Resolve a variable name (with optional member suffix) to a handle.
+ * @param var_name Full variable name, e.g. "counter_1.CV".
+ * @param handle Pointer to store the handle; set to an invalid handle if not found.
+ * @return bool True if the variable exists, false otherwise.
+ */
+bool resolve_variable(const char *var_name, VariableHandle *handle);
+
+/**
+ * @brief Get the variable node referenced by a handle.
+ * @param handle Variable handle.
+ * @return VariableNode* Pointer to the variable node, or NULL if the handle is invalid.
+ */
+VariableNode *get_variable_node(VariableHandle handle);
+
+/**
+ * @brief Get the base name of the variable referenced by a handle.
+ * @param handle Variable handle.
+ * @return const char* Variable name, or "(invalid)" if the handle is invalid.
+ */
+const char *get_variable_name(VariableHandle handle);
+
+/**
+ * @brief Read a boolean variable member by handle.
+ * @param handle Variable handle.
+ * @return bool The value of the member, or false if not applicable.
+ */
+bool read_variable_handle(VariableHandle handle);
+
+/**
+ * @brief Write a boolean value to a variable member by handle.
+ * @param handle Variable handle.
+ * @param value Boolean value to write.
+ */
+void write_variable_handle(VariableHandle handle, bool value);
+
+/**
+ * @brief Mark a variable as changed for the next monitor delta after updating it in place.
+ * @param handle Variable handle.
+ */
+void mark_variable_dirty(VariableHandle handle);
+
+/**
+ * @brief Add the pulses counted in hardware since the last access to a counter bound to a source.
+ *
+ * CV of a bound counter is only brought up to date when it is accessed; QU and QD follow.
+ * Does nothing for counters without a source. Only the scan task may call this, or another
+ * task while the scan cycle is stopped; monitors report the pending pulses without taking them.
+ * @param counter Pointer to the counter.
+ */
+void sync_counter_pulses(Counter *counter);
+
+/**
+ * @brief Bring ET of a running timer up to date; Q only changes when the timer wheel reports the expiry.
+ *
+ * Only the scan task may call this, or another task while the scan cycle is stopped;
+ * monitors compute the reported ET without writing the record.
+ * @param timer Pointer to the timer.
+ */
+void sync_timer_elapsed(Timer *timer);
+
+/**
+ * @brief Add the counted pulses to all bound counters and bring ET of all running timers up to date.
+ *
+ * Called by the scan task before the rungs run, so the records are only written from one task.
+ */
+void sync_counters_and_timers(void);
+
+/**
+ * @brief Check whether a handle refers to a digital input captured by interrupt.
+ * @param handle Variable handle.
+ * @return bool True if the variable is a "Digital Input" listed in interrupt_inputs.
+ */
+bool variable_is_captured_input(VariableHandle handle);
+
+/**
+ * @brief Read the edges of a captured digital input between the last two scans.
+ * @param handle Variable handle.
+ * @param rising True to count rising edges, false for falling edges.
+ * @return uint32_t Number of edges, or 0 if the variable is not a captured input.
+ */
+uint32_t read_input_edges_handle(VariableHandle handle, bool rising);
+
+/**
+ * @brief Read a numeric variable member by handle.
+ * @param handle Variable handle.
+ * @return double The value of the member, or 0.0 if not applicable.
+ */
+double read_numeric_variable_handle(VariableHandle handle);
+
+/**
+ * @brief Write a numeric value to a variable member by handle.
+ * @param handle Variable handle.
+ * @param value Numeric value to write.
+ */
+void write_numeric_variable_handle(VariableHandle handle, double value);
+
 /**
  * @brief Read a boolean variable by name.
  * @param var_name Name of the variable to read.
@@ -183,10 +444,83 @@ double read_numeric_variable(const char *var_name);
 void write_numeric_variable(const char *var_name, double value);
 
 /**
- * @brief Read all variables as a JSON string.
- * @return char* JSON string containing all variables, or NULL on error.
+ * @brief Write all variables as a JSON array, without building a cJSON tree.
+ *
+ * Behaves like snprintf: the output is truncated to size and the full length is returned.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return size_t Length of the full document; it did not fit if this is >= size.
+ */
+size_t write_variables_json(char *buf, size_t size);
+
+/**
+ * @brief Write the variables that changed since the last delta or keyframe as a JSON object.
+ *
+ * The object is keyed by variable name and holds only the dynamic fields
+ * (e.g. {"bool_1":true,"counter_1":{"CV":3,"QU":false}}). The dirty bits of the
+ * consumer are cleared only when the delta fits the buffer.
+ * @param consumer Monitor link the delta is formatted for; only its task may pass it.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return size_t Length of the full document, or 0 if nothing changed.
+ */
+size_t write_variables_delta_json(MonitorConsumer consumer, char *buf, size_t size);
+
+/**
+ * @brief Mark every variable as reported to a consumer, before a full keyframe is published to it.
+ * @param consumer Monitor link receiving the keyframe.
+ */
+void variables_clear_dirty(MonitorConsumer consumer);
+
+/**
+ * @brief Get the generation of the loaded variable set.
+ *
+ * The generation changes on every (re)configuration; binary monitor frames carry it
+ * so clients know when their index-to-name table is stale.
+ * @return uint32_t Current variables generation.
+ */
+uint32_t get_variables_generation(void);
+
+/**
+ * @brief Get the number of loaded variables; handle indices are below it.
+ * @return size_t Number of variables.
+ */
+size_t get_variables_count(void);
+
+/**
+ * @brief Write the index-to-name table of the variables as a binary monitor frame.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return size_t Length of the full frame; it did not fit if this is > size.
+ */
+size_t write_variable_names_cbor(uint8_t *buf, size_t size);
+
+/**
+ * @brief Write the values of all variables, in index order, as a binary monitor keyframe.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return size_t Length of the full frame; it did not fit if this is > size.
+ */
+size_t write_variables_cbor(uint8_t *buf, size_t size);
+
+/**
+ * @brief Write the variables that changed as a binary monitor delta keyed by variable index.
+ *
+ * Shares the dirty bits of the consumer with write_variables_delta_json; they are cleared only
+ * when the frame fits.
+ * @param consumer Monitor link the delta is formatted for; only its task may pass it.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return size_t Length of the full frame, or 0 if nothing changed.
+ */
+size_t write_variables_delta_cbor(MonitorConsumer consumer, uint8_t *buf, size_t size);
+
+/**
+ * @brief Update variables from a CBOR map of name to value received from child nodes.
+ * @param data Encoded map.
+ * @param len Length of the data in bytes.
  */
-char *read_variables_json(void);
+void update_variables_from_children_cbor(const uint8_t *data, size_t len);
 
 /**
  * @brief Update variables from a JSON string received from child nodes.